@@ -1,11 +1,20 @@
 #include "hk_accessory_id.h"
 
+#include <string.h>
 #include <esp_system.h>
+#include <freertos/FreeRTOS.h>
 
 #include "../utils/hk_store.h"
 #include "../utils/hk_util.h"
 
 #define HK_ACCESSORY_ID_STORE_KEY "hk_accessory_id"
+#define HK_ACCESSORY_ID_SERIALIZED_SIZE 17 // XX:XX:XX:XX:XX:XX
+
+// The string is read by several tasks. It is formatted outside of the lock and published once under it, so
+// readers never see it half written.
+portMUX_TYPE hk_accessory_id_lock = portMUX_INITIALIZER_UNLOCKED;
+char hk_accessory_id_serialized[HK_ACCESSORY_ID_SERIALIZED_SIZE + 1] = {0};
+bool hk_accessory_id_is_serialized = false;
 
 esp_err_t hk_accessory_id_get(hk_mem *id)
 {
@@ -21,33 +30,57 @@ esp_err_t hk_accessory_id_get(hk_mem *id)
         hk_mem_append_buffer(id, &random_number, sizeof(uint16_t));
 
         ret = hk_store_blob_set(HK_ACCESSORY_ID_STORE_KEY, id);
+        RUN_AND_CHECK(ret, hk_store_flush);
 
+        uint8_t *bytes = (uint8_t *)id->ptr;
         char id_str[18];
-        sprintf(id_str, "%02X:%02X:%02X:%02X:%02X:%02X",
-                id->ptr[0], id->ptr[1], id->ptr[2],
-                id->ptr[3], id->ptr[4], id->ptr[5]);
+        snprintf(id_str, sizeof(id_str), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
         HK_LOGD("Created new accessory id: %s", id_str);
     }
 
     return ret;
 }
 
-esp_err_t hk_accessory_id_get_serialized(hk_mem *id)
+esp_err_t hk_accessory_id_get_serialized(hk_slice_t *id)
 {
-    hk_mem *id_mem = hk_mem_init();
-    hk_mem_set(id_mem, 6);
+    esp_err_t ret = ESP_OK;
+
+    portENTER_CRITICAL(&hk_accessory_id_lock);
+    bool is_serialized = hk_accessory_id_is_serialized;
+    portEXIT_CRITICAL(&hk_accessory_id_lock);
+
+    if (!is_serialized)
+    {
+        char serialized[HK_ACCESSORY_ID_SERIALIZED_SIZE + 1];
+        hk_mem *id_mem = hk_mem_init();
+        hk_mem_set(id_mem, 6);
+
+        ret = hk_accessory_id_get(id_mem);
+        if (ret == ESP_OK)
+        {
+            uint8_t *bytes = (uint8_t *)id_mem->ptr;
+            snprintf(serialized, sizeof(serialized), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+
+            // another task may have published it meanwhile, then it is not written again
+            portENTER_CRITICAL(&hk_accessory_id_lock);
+            if (!hk_accessory_id_is_serialized)
+            {
+                memcpy(hk_accessory_id_serialized, serialized, sizeof(hk_accessory_id_serialized));
+                hk_accessory_id_is_serialized = true;
+            }
+            portEXIT_CRITICAL(&hk_accessory_id_lock);
+        }
+
+        hk_mem_free(id_mem);
+    }
 
-    esp_err_t ret = hk_accessory_id_get(id_mem);
     if (ret == ESP_OK)
     {
-        hk_mem_set(id, 18);
-        sprintf(id->ptr, "%02X:%02X:%02X:%02X:%02X:%02X",
-                id_mem->ptr[0], id_mem->ptr[1], id_mem->ptr[2],
-                id_mem->ptr[3], id_mem->ptr[4], id_mem->ptr[5]);
-        hk_mem_set(id, 17); // trim newline
+        *id = hk_slice_init(hk_accessory_id_serialized, HK_ACCESSORY_ID_SERIALIZED_SIZE);
     }
 
-    hk_mem_free(id_mem);
     return ret;
 }
 
@@ -55,7 +88,11 @@ esp_err_t hk_accessory_id_reset()
 {
     HK_LOGD("Deleting accessory id.");
     esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&hk_accessory_id_lock);
+    hk_accessory_id_is_serialized = false;
+    portEXIT_CRITICAL(&hk_accessory_id_lock);
     ret = hk_store_erase(HK_ACCESSORY_ID_STORE_KEY);
+    RUN_AND_CHECK(ret, hk_store_flush);
 
     if (ret == ESP_ERR_NVS_NOT_FOUND)
     {
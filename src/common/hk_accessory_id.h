@@ -9,6 +9,7 @@
 #include <esp_err.h>
 
 #include "../include/hk_mem.h"
+#include "../utils/hk_slice.h"
 
 /**
  * @brief Returns the accessory id binary
@@ -24,13 +25,14 @@ esp_err_t hk_accessory_id_get(hk_mem *id);
 /**
  * @brief Returns the accessory id as string
  *
- * Returns the accessory id as string.
+ * Returns the accessory id as string in the format XX:XX:XX:XX:XX:XX, without a terminator. The string is created
+ * once and is valid until the id is reset.
  *
- * @param id Memory to write the stream into.
+ * @param id The slice of the string.
  * 
  * @return Retruns ESP_OK if success.
  */
-esp_err_t hk_accessory_id_get_serialized(hk_mem *id);
+esp_err_t hk_accessory_id_get_serialized(hk_slice_t *id);
 
 /**
  * @brief Resets the id
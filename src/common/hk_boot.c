@@ -0,0 +1,136 @@
+#include "hk_boot.h"
+
+#include <stdbool.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "../utils/hk_logging.h"
+
+const char *hk_boot_phase_names[HK_BOOT_PHASE_COUNT] = {"store", "init", "core", "stack", "discoverable", "deferred"};
+int64_t hk_boot_times[HK_BOOT_PHASE_COUNT] = {0};
+bool hk_boot_reached[HK_BOOT_PHASE_COUNT] = {false};
+
+SemaphoreHandle_t hk_boot_jobs_done = NULL;
+size_t hk_boot_running_count = 0;
+
+void (*hk_boot_deferred_jobs[HK_BOOT_MAX_JOBS])() = {NULL};
+size_t hk_boot_deferred_count = 0;
+bool hk_boot_deferred_started = false;
+
+static void hk_boot_job_task(void *arg)
+{
+    void (*job)() = (void (*)())arg;
+    job();
+
+    xSemaphoreGive(hk_boot_jobs_done);
+    vTaskDelete(NULL);
+}
+
+static void hk_boot_run_deferred()
+{
+    // the jobs are only added before they are started, so they are read without synchronization
+    for (size_t i = 0; i < hk_boot_deferred_count; i++)
+    {
+        hk_boot_deferred_jobs[i]();
+    }
+
+    hk_boot_mark(HK_BOOT_PHASE_DEFERRED);
+    hk_boot_print();
+}
+
+static void hk_boot_deferred_task(void *arg)
+{
+    hk_boot_run_deferred();
+    vTaskDelete(NULL);
+}
+
+void hk_boot_mark(hk_boot_phase_t phase)
+{
+    if (phase >= HK_BOOT_PHASE_COUNT || hk_boot_reached[phase])
+    {
+        return;
+    }
+
+    hk_boot_times[phase] = esp_timer_get_time();
+    hk_boot_reached[phase] = true;
+    HK_LOGD("Reached boot phase %s after %lld us.", hk_boot_phase_names[phase], hk_boot_times[phase]);
+
+    if (phase == HK_BOOT_PHASE_DISCOVERABLE && !hk_boot_deferred_started)
+    {
+        hk_boot_deferred_started = true;
+        if (xTaskCreate(hk_boot_deferred_task, "hk_boot_deferred", HK_BOOT_TASK_STACK_SIZE, NULL, HK_BOOT_DEFERRED_TASK_PRIORITY, NULL) != pdPASS)
+        {
+            HK_LOGE("Could not create task for deferred work, running it now.");
+            hk_boot_run_deferred();
+        }
+    }
+}
+
+int64_t hk_boot_get_time(hk_boot_phase_t phase)
+{
+    if (phase >= HK_BOOT_PHASE_COUNT || !hk_boot_reached[phase])
+    {
+        return -1;
+    }
+
+    return hk_boot_times[phase];
+}
+
+esp_err_t hk_boot_run(void (*job)())
+{
+    if (hk_boot_jobs_done == NULL)
+    {
+        hk_boot_jobs_done = xSemaphoreCreateCounting(HK_BOOT_MAX_JOBS, 0);
+    }
+
+    if (hk_boot_jobs_done == NULL || hk_boot_running_count >= HK_BOOT_MAX_JOBS ||
+        xTaskCreate(hk_boot_job_task, "hk_boot", HK_BOOT_TASK_STACK_SIZE, (void *)job, uxTaskPriorityGet(NULL), NULL) != pdPASS)
+    {
+        HK_LOGW("Could not run boot job concurrently, running it now.");
+        job();
+        return ESP_ERR_NO_MEM;
+    }
+
+    hk_boot_running_count++;
+    return ESP_OK;
+}
+
+void hk_boot_join()
+{
+    while (hk_boot_running_count > 0)
+    {
+        xSemaphoreTake(hk_boot_jobs_done, portMAX_DELAY);
+        hk_boot_running_count--;
+    }
+}
+
+esp_err_t hk_boot_defer(void (*job)())
+{
+    if (hk_boot_deferred_started)
+    {
+        job();
+        return ESP_OK;
+    }
+
+    if (hk_boot_deferred_count >= HK_BOOT_MAX_JOBS)
+    {
+        HK_LOGE("Could not defer job, as %d jobs are deferred.", HK_BOOT_MAX_JOBS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    hk_boot_deferred_jobs[hk_boot_deferred_count++] = job;
+    return ESP_OK;
+}
+
+void hk_boot_print()
+{
+    for (size_t i = 0; i < HK_BOOT_PHASE_COUNT; i++)
+    {
+        if (hk_boot_reached[i])
+        {
+            HK_LOGI("Boot phase %s reached after %lld ms.", hk_boot_phase_names[i], hk_boot_times[i] / 1000);
+        }
+    }
+}
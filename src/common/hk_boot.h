@@ -0,0 +1,84 @@
+/**
+ * @file hk_boot.h
+ *
+ * Records the time of the boot phases, runs independent initialization concurrently and defers work, which is not
+ * needed to be discoverable.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#define HK_BOOT_MAX_JOBS 4
+#define HK_BOOT_TASK_STACK_SIZE 4096
+#define HK_BOOT_DEFERRED_TASK_PRIORITY 1
+
+typedef enum
+{
+    HK_BOOT_PHASE_STORE,        // the store is initialized
+    HK_BOOT_PHASE_INIT,         // hk_init is called
+    HK_BOOT_PHASE_CORE,         // the tasks of the library are started
+    HK_BOOT_PHASE_STACK,        // the server listens, or the gatt services are registered
+    HK_BOOT_PHASE_DISCOVERABLE, // mDNS or bluetooth advertising is started
+    HK_BOOT_PHASE_DEFERRED,     // the deferred work is done
+    HK_BOOT_PHASE_COUNT
+} hk_boot_phase_t;
+
+/**
+ * @brief Marks a phase as reached.
+ *
+ * Records the time of a phase, if it was not reached before. Reaching HK_BOOT_PHASE_DISCOVERABLE starts the deferred
+ * work on a task of low priority.
+ *
+ * @param phase The phase.
+ */
+void hk_boot_mark(hk_boot_phase_t phase);
+
+/**
+ * @brief Returns the time of a phase.
+ *
+ * Returns the time, when a phase was reached.
+ *
+ * @param phase The phase.
+ *
+ * @return Returns the microseconds since boot, or -1 if the phase was not reached.
+ */
+int64_t hk_boot_get_time(hk_boot_phase_t phase);
+
+/**
+ * @brief Runs a job concurrently.
+ *
+ * Runs a job of the initialization on a task of its own, while the caller continues with other steps. Wait for the
+ * jobs with hk_boot_join.
+ *
+ * @param job The job, which must not depend on the steps running at the same time.
+ *
+ * @return Returns an esp_err_t result. If the task cannot be created, the job is run before returning.
+ */
+esp_err_t hk_boot_run(void (*job)());
+
+/**
+ * @brief Waits for the concurrent jobs.
+ *
+ * Waits until all jobs started by hk_boot_run are done.
+ */
+void hk_boot_join();
+
+/**
+ * @brief Defers a job.
+ *
+ * Defers a job until the accessory is discoverable. Jobs deferred afterwards are run immediately.
+ *
+ * @param job The job.
+ *
+ * @return Returns ESP_ERR_NO_MEM, if HK_BOOT_MAX_JOBS jobs are deferred already.
+ */
+esp_err_t hk_boot_defer(void (*job)());
+
+/**
+ * @brief Prints the boot phases.
+ *
+ * Logs the reached phases with their time since boot.
+ */
+void hk_boot_print();
@@ -0,0 +1,109 @@
+#include "hk_configuration.h"
+
+#include <string.h>
+
+#include "hk_pairings_store.h"
+#include "../utils/hk_store.h"
+#include "../utils/hk_logging.h"
+#include "../utils/hk_util.h"
+
+#define HK_CONFIGURATION_HASH_STORE_KEY "hk_conf_hash"
+#define HK_CONFIGURATION_NUMBER_STORE_KEY "hk_conf_num"
+#define HK_CONFIGURATION_LEGACY_BLE_STORE_KEY "hk_gap_conf" // counter of the ble stack, before the hash was used
+#define HK_CONFIGURATION_LEGACY_IP_NUMBER 2                  // the ip stack advertised a fixed c# before
+
+// 32 bit FNV-1a
+#define HK_CONFIGURATION_HASH_OFFSET 2166136261u
+#define HK_CONFIGURATION_HASH_PRIME 16777619u
+
+void hk_configuration_hash_init(uint32_t *hash)
+{
+    *hash = HK_CONFIGURATION_HASH_OFFSET;
+}
+
+void hk_configuration_hash_append(uint32_t *hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        *hash ^= bytes[i];
+        *hash *= HK_CONFIGURATION_HASH_PRIME;
+    }
+}
+
+static uint16_t hk_configuration_legacy_number()
+{
+    // controllers cached the database with the number of the firmware before, so the new number has to be larger
+    uint8_t ble_number = 0;
+    if (hk_store_u8_get(HK_CONFIGURATION_LEGACY_BLE_STORE_KEY, &ble_number) == ESP_OK)
+    {
+        HK_LOGI("Continuing configuration number %d of ble.", ble_number);
+        return ble_number;
+    }
+
+    // only paired controllers cached a database
+    bool has_pairing = false;
+    hk_pairings_store_has_pairing(&has_pairing);
+    if (has_pairing)
+    {
+        HK_LOGI("Continuing configuration number %d of ip.", HK_CONFIGURATION_LEGACY_IP_NUMBER);
+        return HK_CONFIGURATION_LEGACY_IP_NUMBER;
+    }
+
+    return 0;
+}
+
+esp_err_t hk_configuration_update(uint32_t hash)
+{
+    esp_err_t ret = ESP_OK;
+    uint16_t number = 0;
+    hk_mem *hash_stored = hk_mem_init();
+
+    ret = hk_store_blob_get(HK_CONFIGURATION_HASH_STORE_KEY, hash_stored);
+    if (ret == ESP_OK && hash_stored->size == sizeof(uint32_t) && memcmp(hash_stored->ptr, &hash, sizeof(uint32_t)) == 0)
+    {
+        HK_LOGD("Attribute database did not change (%x).", hash);
+    }
+    else if (ret == ESP_OK || ret == ESP_ERR_NOT_FOUND)
+    {
+        // the stored number is kept and incremented below, as the hash changed
+        ret = hk_store_u16_get(HK_CONFIGURATION_NUMBER_STORE_KEY, &number);
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            // nothing stored yet, so the number of the firmware before is continued
+            number = hk_configuration_legacy_number();
+            ret = ESP_OK;
+        }
+
+        // the number wraps to 1
+        number = number == UINT16_MAX ? 1 : number + 1;
+        HK_LOGI("Attribute database changed (%x). Updating configuration number to %d.", hash, number);
+
+        hk_mem_set(hash_stored, 0);
+        hk_mem_append_buffer(hash_stored, &hash, sizeof(uint32_t));
+        RUN_AND_CHECK(ret, hk_store_u16_set, HK_CONFIGURATION_NUMBER_STORE_KEY, number);
+        RUN_AND_CHECK(ret, hk_store_blob_set, HK_CONFIGURATION_HASH_STORE_KEY, hash_stored);
+        RUN_AND_CHECK(ret, hk_store_flush);
+    }
+    else
+    {
+        HK_LOGE("Error getting hash of attribute database: %d", ret);
+    }
+
+    hk_mem_free(hash_stored);
+
+    return ret;
+}
+
+uint16_t hk_configuration_get()
+{
+    uint16_t number = 1;
+    hk_store_u16_get(HK_CONFIGURATION_NUMBER_STORE_KEY, &number);
+
+    return number;
+}
+
+uint8_t hk_configuration_get_u8()
+{
+    return (hk_configuration_get() - 1) % UINT8_MAX + 1;
+}
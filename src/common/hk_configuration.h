@@ -0,0 +1,63 @@
+/**
+ * @file hk_configuration.h
+ *
+ * Functions to maintain the configuration number, which tells controllers whether their cached attribute
+ * database is still valid.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/**
+ * @brief Initializes a hash.
+ *
+ * Initializes a hash of the attribute database.
+ *
+ * @param hash The hash to initialize.
+ */
+void hk_configuration_hash_init(uint32_t *hash);
+
+/**
+ * @brief Appends data to a hash.
+ *
+ * Appends data of the attribute database to the hash. The hash only depends on the data and its order.
+ *
+ * @param hash The hash.
+ * @param data The data to append.
+ * @param size The size of the data.
+ */
+void hk_configuration_hash_append(uint32_t *hash, const void *data, size_t size);
+
+/**
+ * @brief Updates the configuration number.
+ *
+ * Compares the hash with the stored one of the last start. The configuration number is increased and the
+ * hash stored, only if the attribute database changed. On the first start after an update of the firmware, the
+ * number continues from the one of the firmware before, so it never goes backwards for paired controllers.
+ *
+ * @param hash The hash of the current attribute database.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_configuration_update(uint32_t hash);
+
+/**
+ * @brief Returns the configuration number.
+ *
+ * Returns the configuration number, which is at least 1.
+ * 
+ * @return Returns the configuration number.
+ */
+uint16_t hk_configuration_get();
+
+/**
+ * @brief Returns the configuration number as byte.
+ *
+ * Returns the configuration number wrapped to 1 to 255, as needed by bluetooth.
+ * 
+ * @return Returns the configuration number.
+ */
+uint8_t hk_configuration_get_u8();
@@ -1,39 +1,62 @@
 #include "hk_conn_key_store.h"
 
-hk_conn_key_store_t *hk_conn_key_store_init()
+#include <string.h>
+
+#include "hk_pair_limiter.h"
+
+static void hk_conn_key_store_zeroize(void *buffer, size_t size)
 {
-    hk_conn_key_store_t *keys = (hk_conn_key_store_t *)malloc(sizeof(hk_conn_key_store_t));
-    
-    keys->response_key = hk_mem_init();
-    keys->request_key = hk_mem_init();
-    keys->accessory_shared_secret = hk_mem_init();
+    // volatile, so the compiler cannot drop the writes to memory, which is freed afterwards
+    volatile char *pointer = (volatile char *)buffer;
+    while (size--)
+    {
+        *pointer++ = 0;
+    }
+}
 
-    keys->session_key = hk_mem_init();
-    keys->accessory_session_key_public = hk_mem_init();
-    keys->device_session_key_public = hk_mem_init();
+hk_conn_key_store_t *hk_conn_key_store_init()
+{
+    hk_conn_key_store_t *keys = (hk_conn_key_store_t *)calloc(1, sizeof(hk_conn_key_store_t));
 
     return keys;
 }
 
 void hk_conn_key_store_free(hk_conn_key_store_t *keys)
 {
-    hk_mem_free(keys->request_key);
-    hk_mem_free(keys->response_key);
-    hk_mem_free(keys->accessory_shared_secret);
+    // the connection closes, so another connection can start a pair setup
+    hk_pair_limiter_setup_release(keys);
 
-    hk_mem_free(keys->session_key);
-    hk_mem_free(keys->accessory_session_key_public);
-    hk_mem_free(keys->device_session_key_public);
+    hk_conn_key_store_pair_setup_free(keys);
+    hk_conn_key_store_zeroize(keys, sizeof(hk_conn_key_store_t));
 
     free(keys);
 }
 
 void hk_conn_key_store_reset(hk_conn_key_store_t *keys)
 {
-    hk_mem_set(keys->request_key, 0);
-    hk_mem_set(keys->response_key, 0);
-    hk_mem_set(keys->accessory_shared_secret, 0);
-    hk_mem_set(keys->session_key, 0);
-    hk_mem_set(keys->accessory_session_key_public, 0);
-    hk_mem_set(keys->device_session_key_public, 0);
-}
\ No newline at end of file
+    hk_conn_key_store_zeroize(keys->response_key, sizeof(keys->response_key));
+    hk_conn_key_store_zeroize(keys->request_key, sizeof(keys->request_key));
+    hk_conn_key_store_zeroize(keys->accessory_shared_secret, sizeof(keys->accessory_shared_secret));
+    hk_conn_key_store_zeroize(keys->session_key, sizeof(keys->session_key));
+    hk_conn_key_store_zeroize(keys->accessory_session_key_public, sizeof(keys->accessory_session_key_public));
+    hk_conn_key_store_zeroize(keys->device_session_key_public, sizeof(keys->device_session_key_public));
+
+    keys->has_shared_secret = false;
+    keys->has_control_keys = false;
+    keys->has_session_keys = false;
+}
+
+void hk_conn_key_store_pair_setup_free(hk_conn_key_store_t *keys)
+{
+    if (keys->pair_setup_public_key != NULL)
+    {
+        hk_mem_free(keys->pair_setup_public_key);
+        keys->pair_setup_public_key = NULL;
+    }
+
+    if (keys->pair_setup_srp_key != NULL)
+    {
+        hk_srp_free_key(keys->pair_setup_srp_key);
+        keys->pair_setup_srp_key = NULL;
+    }
+}
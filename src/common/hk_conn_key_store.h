@@ -6,22 +6,41 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "../include/hk_mem.h"
 #include "../crypto/hk_srp.h"
 
+#define HK_CONN_KEY_STORE_KEY_SIZE 32
+
+/**
+ * @brief Refers to a key of the store as hk_mem, without allocating. Valid in the enclosing block only.
+ *
+ * Only for reading a key, as functions writing to a hk_mem may resize it. Keys are written with the _to_buffer
+ * functions of the crypto module instead.
+ */
+#define HK_CONN_KEY_STORE_MEM(key) (&(hk_mem){.size = HK_CONN_KEY_STORE_KEY_SIZE, .ptr = (key)})
+
 typedef struct
 {
+    // the source of the connection, like its address, to limit unauthenticated work per source
+    uint32_t source;
+
     // fields are created per connection
-    hk_mem *response_key;
-    hk_mem *request_key;
-    hk_mem *accessory_shared_secret;
+    char response_key[HK_CONN_KEY_STORE_KEY_SIZE];
+    char request_key[HK_CONN_KEY_STORE_KEY_SIZE];
+    char accessory_shared_secret[HK_CONN_KEY_STORE_KEY_SIZE];
+    bool has_shared_secret;
+    bool has_control_keys; // response and request key
 
     // fields used during verification process
-    hk_mem *session_key;
-    hk_mem *accessory_session_key_public;
-    hk_mem *device_session_key_public;
+    char session_key[HK_CONN_KEY_STORE_KEY_SIZE];
+    char accessory_session_key_public[HK_CONN_KEY_STORE_KEY_SIZE];
+    char device_session_key_public[HK_CONN_KEY_STORE_KEY_SIZE];
+    bool has_session_keys; // session key and both public keys
 
-    // fields used during setup process, they are allocated and freed by hk_pair_setup
+    // fields used during setup process, they are allocated by hk_pair_setup on M1 and freed when the setup ends
     hk_mem *pair_setup_public_key;
     hk_srp_key_t *pair_setup_srp_key;
 } hk_conn_key_store_t;
@@ -30,14 +49,14 @@ typedef struct
 /**
  * @brief Initializes the keys of a connection
  *
- * Initializes the keys of a connection.
+ * Initializes the keys of a connection. The keys are held in one allocation, no matter whether the connection pairs.
  */
 hk_conn_key_store_t *hk_conn_key_store_init();
 
 /**
  * @brief Frees the keys of a connection
  *
- * Frees the keys of a connection.
+ * Zeroizes and frees the keys of a connection, including a running pair setup.
  *
  * @param keys The keys.
  */
@@ -46,8 +65,17 @@ void hk_conn_key_store_free(hk_conn_key_store_t *keys);
 /**
  * @brief Resets the keys of a connection.
  *
- * Resets all keys of a connection. That should be done on new pair verify.
+ * Zeroizes all keys of a connection and marks them invalid. That should be done on new pair verify.
+ *
+ * @param keys The keys.
+ */
+void hk_conn_key_store_reset(hk_conn_key_store_t *keys);
+
+/**
+ * @brief Frees the state of a pair setup.
+ *
+ * Frees the srp key and the public key of a pair setup, if it is running. Has to be called when the pair setup ends.
  *
  * @param keys The keys.
  */
-void hk_conn_key_store_reset(hk_conn_key_store_t *keys);
\ No newline at end of file
+void hk_conn_key_store_pair_setup_free(hk_conn_key_store_t *keys);
@@ -0,0 +1,134 @@
+#include "hk_core.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "../utils/hk_logging.h"
+#include "../utils/hk_queue.h"
+#include "../utils/hk_tasks.h"
+#include "../utils/hk_util.h"
+
+hk_queue_t hk_core_queue;
+TaskHandle_t hk_core_task_handle = NULL;
+void (*hk_core_handler)(hk_core_event_t *event) = NULL;
+SemaphoreHandle_t hk_core_space = NULL; // given by the core task, whenever it took an event out of the queue
+
+static void hk_core_task(void *arg)
+{
+    hk_core_event_t event;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // an event, which is still being written by a producer, is popped after the producer notifies again
+        while (hk_queue_pop(&hk_core_queue, &event))
+        {
+            xSemaphoreGive(hk_core_space);
+            hk_core_handler(&event);
+        }
+    }
+}
+
+esp_err_t hk_core_init(void (*handler)(hk_core_event_t *event))
+{
+    esp_err_t ret = ESP_OK;
+
+    hk_core_handler = handler;
+    if (hk_core_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    RUN_AND_CHECK(ret, hk_queue_init, &hk_core_queue, sizeof(hk_core_event_t), HK_CORE_QUEUE_SIZE);
+
+    if (ret == ESP_OK && (hk_core_space = xSemaphoreCreateBinary()) == NULL)
+    {
+        hk_queue_free(&hk_core_queue);
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK && xTaskCreatePinnedToCore(hk_core_task, "hk_core", HK_CORE_TASK_STACK_SIZE, NULL, HK_CORE_TASK_PRIORITY, &hk_core_task_handle, HK_UTIL_TASK_CORE_ID(HK_CORE_TASK_CORE_ID)) != pdPASS)
+    {
+        HK_LOGE("Could not create core task.");
+        hk_queue_free(&hk_core_queue);
+        vSemaphoreDelete(hk_core_space);
+        hk_core_space = NULL;
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK)
+    {
+        hk_tasks_register(hk_core_task_handle, "hk_core", HK_CORE_TASK_STACK_SIZE);
+    }
+
+    return ret;
+}
+
+esp_err_t hk_core_post(hk_core_event_type_t type, void *chr, int socket)
+{
+    hk_core_event_t event = {.type = type, .chr = chr, .socket = socket};
+
+    if (hk_core_task_handle == NULL)
+    {
+        HK_LOGE("Core task was not started.");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!hk_queue_push(&hk_core_queue, &event))
+    {
+        HK_LOGE("Core queue is full, dropping event %d.", type);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xTaskNotifyGive(hk_core_task_handle);
+
+    return ESP_OK;
+}
+
+esp_err_t hk_core_post_blocking(hk_core_event_type_t type, void *chr, int socket)
+{
+    hk_core_event_t event = {.type = type, .chr = chr, .socket = socket};
+
+    if (hk_core_task_handle == NULL || xTaskGetCurrentTaskHandle() == hk_core_task_handle)
+    {
+        // the core task would wait for itself
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // the semaphore may be given from an earlier pop, then we only try once more
+    while (!hk_queue_push(&hk_core_queue, &event))
+    {
+        xTaskNotifyGive(hk_core_task_handle);
+        xSemaphoreTake(hk_core_space, portMAX_DELAY);
+    }
+
+    xTaskNotifyGive(hk_core_task_handle);
+
+    return ESP_OK;
+}
+
+esp_err_t hk_core_post_from_isr(hk_core_event_type_t type, void *chr, int socket)
+{
+    hk_core_event_t event = {.type = type, .chr = chr, .socket = socket};
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (hk_core_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!hk_queue_push(&hk_core_queue, &event))
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    vTaskNotifyGiveFromISR(hk_core_task_handle, &higher_priority_task_woken);
+    if (higher_priority_task_woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+
+    return ESP_OK;
+}
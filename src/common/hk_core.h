@@ -0,0 +1,83 @@
+/**
+ * @file hk_core.h
+ *
+ * The homekit core task, which owns the notification state. Other tasks and interrupts only post events to it.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include <sdkconfig.h>
+
+#define HK_CORE_QUEUE_SIZE 32
+#define HK_CORE_TASK_STACK_SIZE 4096
+#define HK_CORE_TASK_PRIORITY CONFIG_ESP32_HAP_CORE_TASK_PRIORITY
+#define HK_CORE_TASK_CORE_ID CONFIG_ESP32_HAP_CORE_TASK_CORE_ID
+
+typedef enum
+{
+    HK_CORE_EVENT_NOTIFY,
+    HK_CORE_EVENT_SUBSCRIBE,
+    HK_CORE_EVENT_UNSUBSCRIBE,
+    HK_CORE_EVENT_UNSUBSCRIBE_ALL,
+    HK_CORE_EVENT_RECLAIM
+} hk_core_event_type_t;
+
+typedef struct
+{
+    hk_core_event_type_t type;
+    void *chr;
+    int socket;
+} hk_core_event_t;
+
+/**
+ * @brief Starts the core task.
+ *
+ * Starts the task, which drains the event queue and calls the handler for every event.
+ *
+ * @param handler The handler of the stack, which is called on the core task only.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_core_init(void (*handler)(hk_core_event_t *event));
+
+/**
+ * @brief Posts an event.
+ *
+ * Posts an event to the core task, without blocking.
+ *
+ * @param type The type of the event.
+ * @param chr The characteristic of the event.
+ * @param socket The socket of the event, if the stack has sockets.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_NO_MEM if the queue is full.
+ */
+esp_err_t hk_core_post(hk_core_event_type_t type, void *chr, int socket);
+
+/**
+ * @brief Posts an event, which must not be lost.
+ *
+ * Posts an event to the core task. If the queue is full, waits until the core task took an event out of it. Use it
+ * for events, whose loss leaves stale state behind, like removing the subscriptions of a closed socket.
+ *
+ * @param type The type of the event.
+ * @param chr The characteristic of the event.
+ * @param socket The socket of the event, if the stack has sockets.
+ *
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_STATE if called from the core task itself.
+ */
+esp_err_t hk_core_post_blocking(hk_core_event_type_t type, void *chr, int socket);
+
+/**
+ * @brief Posts an event from an interrupt.
+ *
+ * Posts an event to the core task from an interrupt service routine. Does not log.
+ *
+ * @param type The type of the event.
+ * @param chr The characteristic of the event.
+ * @param socket The socket of the event, if the stack has sockets.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_NO_MEM if the queue is full.
+ */
+esp_err_t hk_core_post_from_isr(hk_core_event_type_t type, void *chr, int socket);
@@ -16,7 +16,11 @@ esp_err_t hk_key_store_priv_get(hk_mem *value)
 
 esp_err_t hk_key_store_priv_set(hk_mem *value)
 {
-    return hk_store_blob_set(HK_STORE_ACC_PRV_KEY, value);
+    esp_err_t ret = ESP_OK;
+    RUN_AND_CHECK(ret, hk_store_blob_set, HK_STORE_ACC_PRV_KEY, value);
+    RUN_AND_CHECK(ret, hk_store_flush);
+
+    return ret;
 }
 
 esp_err_t hk_key_store_pub_get(hk_mem *value)
@@ -26,5 +30,9 @@ esp_err_t hk_key_store_pub_get(hk_mem *value)
 
 esp_err_t hk_key_store_pub_set(hk_mem *value)
 {
-    return hk_store_blob_set(HK_STORE_ACC_PUB_KEY, value);
+    esp_err_t ret = ESP_OK;
+    RUN_AND_CHECK(ret, hk_store_blob_set, HK_STORE_ACC_PUB_KEY, value);
+    RUN_AND_CHECK(ret, hk_store_flush);
+
+    return ret;
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #include "hk_mem.h"
 #include "../utils/hk_logging.h"
+#include "../utils/hk_alloc.h"
 
 #include <string.h>
 
 hk_mem *hk_mem_init()
+{
+    return hk_mem_init_for(HK_ALLOC_DEFAULT);
+}
+
+hk_mem *hk_mem_init_for(uint8_t subsystem)
 {
     hk_mem *mem = malloc(sizeof(hk_mem));
     mem->size = 0;
     mem->ptr = NULL;
+    mem->subsystem = subsystem;
     return mem;
 }
 
@@ -19,7 +26,7 @@ void hk_mem_append(hk_mem *mem, hk_mem *mem_to_append)
 void hk_mem_append_buffer(hk_mem *mem, void *data, size_t size)
 {
     size_t new_size = mem->size + size;
-    mem->ptr = realloc(mem->ptr, new_size);
+    mem->ptr = hk_alloc_realloc(mem->subsystem, mem->ptr, new_size);
     memcpy(mem->ptr + mem->size, data, size);
     mem->size = new_size;
 }
@@ -39,14 +46,14 @@ void hk_mem_set(hk_mem *mem, size_t size)
 {
     if (mem->size != size)
     {
-        mem->ptr = realloc(mem->ptr, size);
+        mem->ptr = hk_alloc_realloc(mem->subsystem, mem->ptr, size);
         mem->size = size;
     }
 }
 
 void hk_mem_set_mem(hk_mem *mem, hk_mem *mem_to_set)
 {
-    mem->ptr = realloc(mem->ptr, mem_to_set->size);
+    mem->ptr = hk_alloc_realloc(mem->subsystem, mem->ptr, mem_to_set->size);
     memcpy(mem->ptr, mem_to_set->ptr, mem_to_set->size);
     mem->size = mem_to_set->size;
 }
@@ -57,7 +64,7 @@ void hk_mem_free(hk_mem *mem)
     {
         if (mem->ptr != NULL)
         {
-            free(mem->ptr);
+            hk_alloc_free(mem->subsystem, mem->ptr);
             mem->ptr = NULL;
         }
         free(mem);
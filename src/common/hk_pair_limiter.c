@@ -0,0 +1,228 @@
+#include "hk_pair_limiter.h"
+
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "../utils/hk_store.h"
+#include "../utils/hk_logging.h"
+#include "../utils/hk_util.h"
+#include "hk_pair_tlvs.h"
+
+#define HK_PAIR_LIMITER_ATTEMPTS_STORE_KEY "hk_setup_fails"
+
+typedef struct
+{
+    uint32_t source;
+    size_t tokens;
+    int64_t refilled;
+    int64_t used;
+} hk_pair_limiter_bucket_t;
+
+// Pairing runs on the task of the stack or on a worker, while connections are released by other tasks. The lock is
+// only held while the state is changed, the store is accessed outside of it.
+portMUX_TYPE hk_pair_limiter_lock = portMUX_INITIALIZER_UNLOCKED;
+void *hk_pair_limiter_setup_owner = NULL;
+int64_t hk_pair_limiter_setup_started = 0;
+int64_t hk_pair_limiter_backoff_until = 0;
+hk_pair_limiter_bucket_t hk_pair_limiter_verify_buckets[HK_PAIR_LIMITER_VERIFY_SOURCES];
+hk_pair_limiter_bucket_t hk_pair_limiter_verify_global;
+
+static uint8_t hk_pair_limiter_get_attempts()
+{
+    uint8_t attempts = 0;
+    esp_err_t ret = hk_store_u8_get(HK_PAIR_LIMITER_ATTEMPTS_STORE_KEY, &attempts);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND)
+    {
+        HK_LOGE("Could not get unsuccessful pair setup attempts: %s", esp_err_to_name(ret));
+    }
+
+    return attempts;
+}
+
+esp_err_t hk_pair_limiter_setup_begin(void *owner, uint8_t *error, uint16_t *retry_delay)
+{
+    int64_t now = esp_timer_get_time();
+    *retry_delay = 0;
+
+    if (hk_pair_limiter_get_attempts() >= HK_PAIR_LIMITER_MAX_SETUP_ATTEMPTS)
+    {
+        HK_LOGW("Refusing pair setup, as the maximum of unsuccessful attempts is reached.");
+        *error = HK_PAIR_TLV_ERROR_MAXTRIES;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&hk_pair_limiter_lock);
+    int64_t backoff_until = hk_pair_limiter_backoff_until;
+    bool is_busy = hk_pair_limiter_setup_owner != NULL && hk_pair_limiter_setup_owner != owner &&
+                   now - hk_pair_limiter_setup_started < HK_PAIR_LIMITER_SETUP_TIMEOUT_MS * 1000LL;
+    if (now >= backoff_until && !is_busy)
+    {
+        hk_pair_limiter_setup_owner = owner;
+        hk_pair_limiter_setup_started = now;
+    }
+    portEXIT_CRITICAL(&hk_pair_limiter_lock);
+
+    if (now < backoff_until)
+    {
+        *retry_delay = (backoff_until - now) / 1000000 + 1;
+        HK_LOGW("Refusing pair setup, as backing off for %d seconds.", *retry_delay);
+        *error = HK_PAIR_TLV_ERROR_BACKOFF;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (is_busy)
+    {
+        HK_LOGW("Refusing pair setup, as another pair setup is running.");
+        *error = HK_PAIR_TLV_ERROR_BUSY;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return ESP_OK;
+}
+
+bool hk_pair_limiter_setup_owns(void *owner)
+{
+    portENTER_CRITICAL(&hk_pair_limiter_lock);
+    bool owns = owner != NULL && hk_pair_limiter_setup_owner == owner;
+    portEXIT_CRITICAL(&hk_pair_limiter_lock);
+
+    return owns;
+}
+
+// releases the pair setup, if the owner owns it
+static bool hk_pair_limiter_setup_take_back(void *owner)
+{
+    portENTER_CRITICAL(&hk_pair_limiter_lock);
+    bool owns = owner != NULL && hk_pair_limiter_setup_owner == owner;
+    if (owns)
+    {
+        hk_pair_limiter_setup_owner = NULL;
+    }
+    portEXIT_CRITICAL(&hk_pair_limiter_lock);
+
+    return owns;
+}
+
+void hk_pair_limiter_setup_end(void *owner, bool success)
+{
+    if (!hk_pair_limiter_setup_take_back(owner))
+    {
+        return;
+    }
+
+    if (success)
+    {
+        hk_pair_limiter_reset();
+    }
+    else
+    {
+        uint8_t attempts = hk_pair_limiter_get_attempts();
+        attempts = attempts < HK_PAIR_LIMITER_MAX_SETUP_ATTEMPTS ? attempts + 1 : attempts;
+
+        // the backoff doubles with every unsuccessful attempt: 1s, 2s, 4s, ...
+        int64_t backoff = attempts < 13 ? 1LL << (attempts - 1) : HK_PAIR_LIMITER_MAX_BACKOFF_S;
+        backoff = backoff < HK_PAIR_LIMITER_MAX_BACKOFF_S ? backoff : HK_PAIR_LIMITER_MAX_BACKOFF_S;
+        portENTER_CRITICAL(&hk_pair_limiter_lock);
+        hk_pair_limiter_backoff_until = esp_timer_get_time() + backoff * 1000000;
+        portEXIT_CRITICAL(&hk_pair_limiter_lock);
+        HK_LOGW("Unsuccessful pair setup attempt %d, backing off for %d seconds.", attempts, (int)backoff);
+
+        esp_err_t ret = ESP_OK;
+        RUN_AND_CHECK(ret, hk_store_u8_set, HK_PAIR_LIMITER_ATTEMPTS_STORE_KEY, attempts);
+        RUN_AND_CHECK(ret, hk_store_flush);
+    }
+}
+
+void hk_pair_limiter_setup_release(void *owner)
+{
+    hk_pair_limiter_setup_take_back(owner);
+}
+
+static hk_pair_limiter_bucket_t *hk_pair_limiter_get_bucket(uint32_t source, int64_t now)
+{
+    hk_pair_limiter_bucket_t *bucket = &hk_pair_limiter_verify_buckets[0];
+
+    for (size_t i = 0; i < HK_PAIR_LIMITER_VERIFY_SOURCES; i++)
+    {
+        if (hk_pair_limiter_verify_buckets[i].source == source && hk_pair_limiter_verify_buckets[i].used > 0)
+        {
+            return &hk_pair_limiter_verify_buckets[i];
+        }
+
+        bucket = hk_pair_limiter_verify_buckets[i].used < bucket->used ? &hk_pair_limiter_verify_buckets[i] : bucket;
+    }
+
+    // the source used least recently gives its bucket to the new one
+    bucket->source = source;
+    bucket->tokens = HK_PAIR_LIMITER_VERIFY_TOKENS;
+    bucket->refilled = now;
+
+    return bucket;
+}
+
+static void hk_pair_limiter_refill(hk_pair_limiter_bucket_t *bucket, int64_t now, size_t capacity, int64_t refill_interval)
+{
+    size_t refill = (now - bucket->refilled) / refill_interval;
+
+    if (refill > 0)
+    {
+        bucket->tokens += refill;
+        bucket->tokens = bucket->tokens < capacity ? bucket->tokens : capacity;
+        bucket->refilled += refill * refill_interval;
+    }
+
+    bucket->used = now > 0 ? now : 1;
+}
+
+bool hk_pair_limiter_verify_take(uint32_t source)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&hk_pair_limiter_lock);
+    hk_pair_limiter_bucket_t *bucket = hk_pair_limiter_get_bucket(source, now);
+    hk_pair_limiter_refill(bucket, now, HK_PAIR_LIMITER_VERIFY_TOKENS, HK_PAIR_LIMITER_VERIFY_REFILL_MS * 1000LL);
+
+    // new and evicted sources start with a full bucket, so sources changing their address are limited by the global one
+    if (hk_pair_limiter_verify_global.used == 0)
+    {
+        hk_pair_limiter_verify_global.tokens = HK_PAIR_LIMITER_VERIFY_GLOBAL_TOKENS;
+        hk_pair_limiter_verify_global.refilled = now;
+    }
+
+    hk_pair_limiter_refill(&hk_pair_limiter_verify_global, now, HK_PAIR_LIMITER_VERIFY_GLOBAL_TOKENS, HK_PAIR_LIMITER_VERIFY_GLOBAL_REFILL_MS * 1000LL);
+
+    bool taken = bucket->tokens > 0 && hk_pair_limiter_verify_global.tokens > 0;
+    if (taken)
+    {
+        bucket->tokens--;
+        hk_pair_limiter_verify_global.tokens--;
+    }
+    portEXIT_CRITICAL(&hk_pair_limiter_lock);
+
+    if (!taken)
+    {
+        HK_LOGW("Refusing pair verify, as too many were started by the source or by all sources.");
+    }
+
+    return taken;
+}
+
+esp_err_t hk_pair_limiter_reset()
+{
+    esp_err_t ret = ESP_OK;
+
+    portENTER_CRITICAL(&hk_pair_limiter_lock);
+    hk_pair_limiter_backoff_until = 0;
+    memset(hk_pair_limiter_verify_buckets, 0, sizeof(hk_pair_limiter_verify_buckets));
+    memset(&hk_pair_limiter_verify_global, 0, sizeof(hk_pair_limiter_verify_global));
+    portEXIT_CRITICAL(&hk_pair_limiter_lock);
+
+    if (hk_pair_limiter_get_attempts() > 0)
+    {
+        RUN_AND_CHECK(ret, hk_store_u8_set, HK_PAIR_LIMITER_ATTEMPTS_STORE_KEY, 0);
+        RUN_AND_CHECK(ret, hk_store_flush);
+    }
+
+    return ret;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file hk_pair_limiter.h
+ *
+ * Limits the expensive pairing work, which can be triggered without authentication.
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HK_PAIR_LIMITER_MAX_SETUP_ATTEMPTS 100 // refer to spec 5.6.2
+#define HK_PAIR_LIMITER_SETUP_TIMEOUT_MS 30000
+#define HK_PAIR_LIMITER_MAX_BACKOFF_S 3600
+#define HK_PAIR_LIMITER_VERIFY_TOKENS 8
+#define HK_PAIR_LIMITER_VERIFY_REFILL_MS 2000
+#define HK_PAIR_LIMITER_VERIFY_SOURCES 8 // sources, which have a bucket of their own
+#define HK_PAIR_LIMITER_VERIFY_GLOBAL_TOKENS 16 // shared by all sources, so changing the source does not help
+#define HK_PAIR_LIMITER_VERIFY_GLOBAL_REFILL_MS 500
+
+/**
+ * @brief Starts a pair setup
+ *
+ * Checks whether a pair setup can be started by the connection. It is refused, if the maximum number of unsuccessful
+ * attempts is reached, if the backoff of the last unsuccessful attempt did not pass, or if another connection is
+ * pairing. Otherwise the connection owns the pair setup until it is ended or times out.
+ *
+ * @param owner The connection, which starts the pair setup.
+ * @param error The tlv error to respond with, if the pair setup is refused.
+ * @param retry_delay The seconds to wait until retrying, if the error is a backoff.
+ *
+ * @return Returns ESP_OK if the pair setup can be started, ESP_ERR_INVALID_STATE otherwise.
+ */
+esp_err_t hk_pair_limiter_setup_begin(void *owner, uint8_t *error, uint16_t *retry_delay);
+
+/**
+ * @brief Checks whether the connection owns the pair setup
+ *
+ * Checks whether the connection started the running pair setup.
+ *
+ * @param owner The connection.
+ *
+ * @return Returns true, if the connection owns the pair setup.
+ */
+bool hk_pair_limiter_setup_owns(void *owner);
+
+/**
+ * @brief Ends a pair setup
+ *
+ * Ends the pair setup of the connection. Unsuccessful attempts are counted persistently and increase the backoff.
+ *
+ * @param owner The connection, which owns the pair setup.
+ * @param success True, if the pair setup was successful.
+ */
+void hk_pair_limiter_setup_end(void *owner, bool success);
+
+/**
+ * @brief Releases a pair setup
+ *
+ * Releases the pair setup, if the connection owns it, without counting an attempt. Used when the connection closes.
+ *
+ * @param owner The connection.
+ */
+void hk_pair_limiter_setup_release(void *owner);
+
+/**
+ * @brief Takes a token for a pair verify
+ *
+ * Takes a token from the bucket of the source for starting a pair verify. The buckets are refilled over time. Every
+ * source has its own bucket, so a source, which starts pair verify over and over, does not lock out paired controllers.
+ * If more sources start pair verify, the source used least recently loses its bucket. Every token is also taken from a
+ * global bucket, which limits the pair verifies of all sources together.
+ *
+ * @param source The source of the connection, like its address.
+ *
+ * @return Returns true, if a token was available.
+ */
+bool hk_pair_limiter_verify_take(uint32_t source);
+
+/**
+ * @brief Resets the limits
+ *
+ * Resets the counter of unsuccessful pair setups and the backoff.
+ *
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_pair_limiter_reset();
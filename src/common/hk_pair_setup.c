@@ -15,6 +15,24 @@
 #include "hk_pair_tlvs.h"
 #include "hk_code_store.h"
 #include "hk_key_store.h"
+#include "hk_pair_limiter.h"
+
+static esp_err_t hk_pairing_setup_refuse(hk_mem *result, uint8_t state, uint8_t error, uint16_t retry_delay)
+{
+    hk_tlv_t *tlv_data_response = NULL;
+
+    tlv_data_response = hk_tlv_add_uint8(tlv_data_response, HK_PAIR_TLV_STATE, state);
+    tlv_data_response = hk_tlv_add_uint8(tlv_data_response, HK_PAIR_TLV_ERROR, error);
+    if (error == HK_PAIR_TLV_ERROR_BACKOFF)
+    {
+        tlv_data_response = hk_tlv_add_uint16(tlv_data_response, HK_PAIR_TLV_RETRYDELAY, retry_delay);
+    }
+
+    hk_tlv_serialize(tlv_data_response, result);
+    hk_tlv_free(tlv_data_response);
+
+    return ESP_OK;
+}
 
 static esp_err_t hk_pairing_setup_srp_start(hk_mem *result, hk_conn_key_store_t *keys)
 {
@@ -22,6 +40,7 @@ static esp_err_t hk_pairing_setup_srp_start(hk_mem *result, hk_conn_key_store_t
     HK_LOGD("pairing setup 1/3 (start).");
 
     esp_err_t ret = ESP_OK;
+    hk_conn_key_store_pair_setup_free(keys); // of a previous pair setup, which was not finished
     keys->pair_setup_public_key = hk_mem_init();
     hk_mem *salt = hk_mem_init();
     hk_tlv_t *tlv_data_response = NULL;
@@ -84,6 +103,7 @@ static esp_err_t hk_pairing_setup_srp_verify(hk_tlv_t *tlv, hk_mem *result, hk_c
 
     hk_tlv_free(tlv_data_response);
     hk_mem_free(keys->pair_setup_public_key);
+    keys->pair_setup_public_key = NULL;
     hk_mem_free(ios_pk);
     hk_mem_free(ios_proof);
     hk_mem_free(accessory_proof);
@@ -131,7 +151,7 @@ static esp_err_t hk_pairing_setup_exchange_response_verification(hk_tlv_t *tlv,
 
     if (!ret)
     {
-        hk_pairings_store_add(device_id, device_long_term_key_public, true);
+        hk_pairings_store_add(hk_slice_from_mem(device_id), hk_slice_from_mem(device_long_term_key_public), true);
     }
 
     hk_tlv_free(tlv_data_decrypted);
@@ -154,7 +174,7 @@ static esp_err_t hk_pairing_setup_exchange_response_generation(hk_mem *result, h
     hk_mem *accessory_private_key = hk_mem_init();
     hk_mem *accessory_info = hk_mem_init();
     hk_mem *accessory_signature = hk_mem_init();
-    hk_mem *accessory_pairing_id = hk_mem_init();
+    hk_slice_t accessory_pairing_id;
     hk_mem *sub_result = hk_mem_init();
     hk_mem *encrypted = hk_mem_init();
     hk_tlv_t *tlv_data_response = NULL;
@@ -170,11 +190,11 @@ static esp_err_t hk_pairing_setup_exchange_response_generation(hk_mem *result, h
     RUN_AND_CHECK(ret, hk_hkdf, srp_private_key, accessory_info, HK_HKDF_PAIR_SETUP_ACCESSORY_SALT, HK_HKDF_PAIR_SETUP_ACCESSORY_INFO);
 
     // spec 5.6.6.2.3
-    RUN_AND_CHECK(ret, hk_accessory_id_get_serialized, accessory_pairing_id);
+    RUN_AND_CHECK(ret, hk_accessory_id_get_serialized, &accessory_pairing_id);
 
     if (!ret)
     {
-        hk_mem_append(accessory_info, accessory_pairing_id);
+        hk_mem_append_buffer(accessory_info, (void *)accessory_pairing_id.ptr, accessory_pairing_id.size);
         hk_mem_append(accessory_info, accessory_public_key);
     }
 
@@ -184,7 +204,7 @@ static esp_err_t hk_pairing_setup_exchange_response_generation(hk_mem *result, h
     // spec 5.6.6.2.5
     if (!ret)
     {
-        tlv_data_response_sub = hk_tlv_add_mem(tlv_data_response_sub, HK_PAIR_TLV_IDENTIFIER, accessory_pairing_id);
+        tlv_data_response_sub = hk_tlv_add_buffer(tlv_data_response_sub, HK_PAIR_TLV_IDENTIFIER, (char *)accessory_pairing_id.ptr, accessory_pairing_id.size);
         tlv_data_response_sub = hk_tlv_add_mem(tlv_data_response_sub, HK_PAIR_TLV_PUBLICKEY, accessory_public_key);
         tlv_data_response_sub = hk_tlv_add_mem(tlv_data_response_sub, HK_PAIR_TLV_SIGNATURE, accessory_signature);
 
@@ -209,7 +229,6 @@ static esp_err_t hk_pairing_setup_exchange_response_generation(hk_mem *result, h
 
     hk_tlv_free(tlv_data_response_sub);
     hk_tlv_free(tlv_data_response);
-    hk_mem_free(accessory_pairing_id);
     hk_mem_free(accessory_public_key);
     hk_mem_free(accessory_private_key);
     hk_mem_free(accessory_info);
@@ -243,7 +262,7 @@ static esp_err_t hk_pairing_setup_exchange_response(hk_tlv_t *tlv, hk_mem *resul
     hk_mem_free(shared_secret);
     hk_mem_free(srp_private_key);
     hk_mem_free(device_id);
-    hk_srp_free_key(keys->pair_setup_srp_key);
+    hk_conn_key_store_pair_setup_free(keys);
 
     HK_LOGD("pairing setup 3/3 done.");
     return ret;
@@ -262,16 +281,50 @@ esp_err_t hk_pair_setup(hk_mem *request, hk_mem *response, hk_conn_key_store_t *
     }
     else
     {
+        uint8_t error = 0;
+        uint16_t retry_delay = 0;
+
         switch (*type_tlv->value)
         {
         case HK_PAIR_TLV_STATE_M1:
+            if (hk_pair_limiter_setup_begin(keys, &error, &retry_delay) != ESP_OK)
+            {
+                ret = hk_pairing_setup_refuse(response, HK_PAIR_TLV_STATE_M2, error, retry_delay);
+                break;
+            }
+
             RUN_AND_CHECK(ret, hk_pairing_setup_srp_start, response, keys);
+            if (ret != ESP_OK)
+            {
+                hk_conn_key_store_pair_setup_free(keys);
+                hk_pair_limiter_setup_release(keys);
+            }
             break;
         case HK_PAIR_TLV_STATE_M3:
+            if (!hk_pair_limiter_setup_owns(keys) || keys->pair_setup_public_key == NULL)
+            {
+                HK_LOGE("Received pair setup M3 without M1.");
+                ret = hk_pairing_setup_refuse(response, HK_PAIR_TLV_STATE_M4, HK_PAIR_TLV_ERROR_UNKNOWN, 0);
+                break;
+            }
+
             RUN_AND_CHECK(ret, hk_pairing_setup_srp_verify, tlv_data_request, response, keys);
+            if (ret != ESP_OK)
+            {
+                hk_conn_key_store_pair_setup_free(keys);
+                hk_pair_limiter_setup_end(keys, false);
+            }
             break;
         case HK_PAIR_TLV_STATE_M5:
+            if (!hk_pair_limiter_setup_owns(keys) || keys->pair_setup_srp_key == NULL || keys->pair_setup_public_key != NULL)
+            {
+                HK_LOGE("Received pair setup M5 without M3.");
+                ret = hk_pairing_setup_refuse(response, HK_PAIR_TLV_STATE_M6, HK_PAIR_TLV_ERROR_UNKNOWN, 0);
+                break;
+            }
+
             RUN_AND_CHECK(ret, hk_pairing_setup_exchange_response, tlv_data_request, response, keys);
+            hk_pair_limiter_setup_end(keys, ret == ESP_OK);
             break;
         default:
             HK_LOGE("Unexpected value in tlv in pair setup: %d", *type_tlv->value);
@@ -1,5 +1,7 @@
 #include "hk_pair_verify.h"
 
+#include <string.h>
+
 #include "../crypto/hk_curve25519.h"
 #include "../crypto/hk_hkdf.h"
 #include "../crypto/hk_chacha20poly1305.h"
@@ -13,6 +15,7 @@
 #include "hk_pairings_store.h"
 #include "hk_pair_tlvs.h"
 #include "hk_key_store.h"
+#include "hk_pair_limiter.h"
 
 typedef struct
 {
@@ -27,7 +30,7 @@ esp_err_t hk_pair_verify_create_session(hk_conn_key_store_t *keys)
     esp_err_t ret = ESP_OK;
 
     hk_mem *session_id = hk_mem_init();
-    ret = hk_hkdf_with_given_size(keys->accessory_shared_secret, session_id, 8, HK_HKDF_PAIR_VERIFY_RESUME_SALT, HK_HKDF_PAIR_VERIFY_RESUME_INFO);
+    ret = hk_hkdf_with_given_size(HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), session_id, 8, HK_HKDF_PAIR_VERIFY_RESUME_SALT, HK_HKDF_PAIR_VERIFY_RESUME_INFO);
 
     if (!ret && hk_pair_verify_sessions != NULL && hk_ll_count(hk_pair_verify_sessions) >= 8)
     {
@@ -41,7 +44,7 @@ esp_err_t hk_pair_verify_create_session(hk_conn_key_store_t *keys)
         hk_pair_verify_sessions->id = hk_mem_init();
         hk_pair_verify_sessions->accessory_shared_secret = hk_mem_init();
         hk_mem_append(hk_pair_verify_sessions->id, session_id);
-        hk_mem_append(hk_pair_verify_sessions->accessory_shared_secret, keys->accessory_shared_secret);
+        hk_mem_append_buffer(hk_pair_verify_sessions->accessory_shared_secret, keys->accessory_shared_secret, HK_CONN_KEY_STORE_KEY_SIZE);
     }
 
     hk_mem_free(session_id);
@@ -53,13 +56,15 @@ static esp_err_t hk_pair_verify_create_session_security(hk_conn_key_store_t *key
 {
     esp_err_t ret = ESP_OK;
 
-    ret = hk_hkdf(keys->accessory_shared_secret, keys->response_key, HK_HKDF_CONTROL_READ_SALT, HK_HKDF_CONTROL_READ_INFO);
+    ret = hk_hkdf_to_buffer(HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), keys->response_key, HK_HKDF_CONTROL_READ_SALT, HK_HKDF_CONTROL_READ_INFO);
 
     if (!ret)
     {
-        ret = hk_hkdf(keys->accessory_shared_secret, keys->request_key, HK_HKDF_CONTROL_WRITE_SALT, HK_HKDF_CONTROL_WRITE_INFO);
+        ret = hk_hkdf_to_buffer(HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), keys->request_key, HK_HKDF_CONTROL_WRITE_SALT, HK_HKDF_CONTROL_WRITE_INFO);
     }
 
+    keys->has_control_keys = ret == ESP_OK;
+
     return ret;
 }
 
@@ -72,12 +77,13 @@ esp_err_t hk_pair_verify_start(hk_conn_key_store_t *keys, hk_tlv_t *request_tlvs
     hk_curve25519_key_t *accessory_curve_key_pair = hk_curve25519_init();
     hk_curve25519_key_t *device_curve_key_pair = hk_curve25519_init();
     hk_mem *accessory_info = hk_mem_init();
-    hk_mem *accessory_id = hk_mem_init();
+    hk_slice_t accessory_id;
     hk_mem *accessory_signature = hk_mem_init();
     hk_mem *accessory_public_key = hk_mem_init();
     hk_mem *accessory_private_key = hk_mem_init();
     hk_mem *sub_result = hk_mem_init();
     hk_mem *encrypted = hk_mem_init();
+    hk_mem *device_session_key_public = hk_mem_init();
     hk_tlv_t *tlv_data_response_sub = NULL;
     hk_tlv_t *tlv_data_response = NULL;
 
@@ -90,18 +96,29 @@ esp_err_t hk_pair_verify_start(hk_conn_key_store_t *keys, hk_tlv_t *request_tlvs
     RUN_AND_CHECK(ret, hk_curve25519_update_from_random, accessory_curve_key_pair);
 
     // spec 5.7.2.2
-    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_PUBLICKEY, keys->device_session_key_public);
-    RUN_AND_CHECK(ret, hk_curve25519_update_from_public_key, keys->device_session_key_public, device_curve_key_pair);
-    RUN_AND_CHECK(ret, hk_curve25519_calculate_shared_secret, accessory_curve_key_pair, device_curve_key_pair, keys->accessory_shared_secret);
+    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_PUBLICKEY, device_session_key_public);
+    if (!ret && device_session_key_public->size != HK_CONN_KEY_STORE_KEY_SIZE)
+    {
+        HK_LOGE("Public key of device has %d bytes instead of %d.", device_session_key_public->size, HK_CONN_KEY_STORE_KEY_SIZE);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    else if (!ret)
+    {
+        memcpy(keys->device_session_key_public, device_session_key_public->ptr, HK_CONN_KEY_STORE_KEY_SIZE);
+    }
+
+    RUN_AND_CHECK(ret, hk_curve25519_update_from_public_key, device_session_key_public, device_curve_key_pair);
+    RUN_AND_CHECK(ret, hk_curve25519_calculate_shared_secret_to_buffer, accessory_curve_key_pair, device_curve_key_pair, keys->accessory_shared_secret);
+    keys->has_shared_secret = ret == ESP_OK;
 
     // spec 5.7.2.3
-    RUN_AND_CHECK(ret, hk_curve25519_export_public_key, accessory_curve_key_pair, keys->accessory_session_key_public);
-    RUN_AND_CHECK(ret, hk_accessory_id_get_serialized, accessory_id);
+    RUN_AND_CHECK(ret, hk_curve25519_export_public_key_to_buffer, accessory_curve_key_pair, keys->accessory_session_key_public);
+    RUN_AND_CHECK(ret, hk_accessory_id_get_serialized, &accessory_id);
     if (!ret)
     {
-        hk_mem_append(accessory_info, keys->accessory_session_key_public);
-        hk_mem_append(accessory_info, accessory_id);
-        hk_mem_append(accessory_info, keys->device_session_key_public);
+        hk_mem_append_buffer(accessory_info, keys->accessory_session_key_public, HK_CONN_KEY_STORE_KEY_SIZE);
+        hk_mem_append_buffer(accessory_info, (void *)accessory_id.ptr, accessory_id.size);
+        hk_mem_append_buffer(accessory_info, keys->device_session_key_public, HK_CONN_KEY_STORE_KEY_SIZE);
     }
 
     // // spec 5.7.2.4
@@ -111,23 +128,24 @@ esp_err_t hk_pair_verify_start(hk_conn_key_store_t *keys, hk_tlv_t *request_tlvs
     // spec 5.7.2.5
     if (!ret)
     {
-        tlv_data_response_sub = hk_tlv_add_mem(tlv_data_response_sub, HK_PAIR_TLV_IDENTIFIER, accessory_id);
+        tlv_data_response_sub = hk_tlv_add_buffer(tlv_data_response_sub, HK_PAIR_TLV_IDENTIFIER, (char *)accessory_id.ptr, accessory_id.size);
         tlv_data_response_sub = hk_tlv_add_mem(tlv_data_response_sub, HK_PAIR_TLV_SIGNATURE, accessory_signature);
 
         hk_tlv_serialize(tlv_data_response_sub, sub_result);
     }
 
     // spec 5.7.2.6
-    RUN_AND_CHECK(ret, hk_hkdf, keys->accessory_shared_secret, keys->session_key, HK_HKDF_PAIR_VERIFY_ENCRYPT_SALT, HK_HKDF_PAIR_VERIFY_ENCRYPT_INFO);
+    RUN_AND_CHECK(ret, hk_hkdf_to_buffer, HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), keys->session_key, HK_HKDF_PAIR_VERIFY_ENCRYPT_SALT, HK_HKDF_PAIR_VERIFY_ENCRYPT_INFO);
+    keys->has_session_keys = ret == ESP_OK;
 
     // spec 5.7.2.7
-    RUN_AND_CHECK(ret, hk_chacha20poly1305_encrypt, keys->session_key, HK_CHACHA_VERIFY_MSG2, sub_result, encrypted);
+    RUN_AND_CHECK(ret, hk_chacha20poly1305_encrypt, HK_CONN_KEY_STORE_MEM(keys->session_key), HK_CHACHA_VERIFY_MSG2, sub_result, encrypted);
 
     // spec 5.7.2.8
     tlv_data_response = hk_tlv_add_uint8(tlv_data_response, HK_PAIR_TLV_STATE, HK_PAIR_TLV_STATE_M2);
     if (!ret)
     {
-        tlv_data_response = hk_tlv_add_mem(tlv_data_response, HK_PAIR_TLV_PUBLICKEY, keys->accessory_session_key_public); // there is an error in the specification, dont use the srp proof
+        tlv_data_response = hk_tlv_add_mem(tlv_data_response, HK_PAIR_TLV_PUBLICKEY, HK_CONN_KEY_STORE_MEM(keys->accessory_session_key_public)); // there is an error in the specification, dont use the srp proof
         tlv_data_response = hk_tlv_add_mem(tlv_data_response, HK_PAIR_TLV_ENCRYPTEDDATA, encrypted);
     }
     else
@@ -141,12 +159,12 @@ esp_err_t hk_pair_verify_start(hk_conn_key_store_t *keys, hk_tlv_t *request_tlvs
     hk_tlv_free(tlv_data_response_sub);
     hk_tlv_free(tlv_data_response);
     hk_mem_free(accessory_info);
-    hk_mem_free(accessory_id);
     hk_mem_free(accessory_signature);
     hk_mem_free(accessory_public_key);
     hk_mem_free(accessory_private_key);
     hk_mem_free(sub_result);
     hk_mem_free(encrypted);
+    hk_mem_free(device_session_key_public);
     hk_ed25519_free(accessory_long_term_key);
     hk_curve25519_free(accessory_curve_key_pair);
     hk_curve25519_free(device_curve_key_pair);
@@ -167,9 +185,10 @@ esp_err_t hk_pair_verify_finish(hk_conn_key_store_t *keys, hk_mem *device_id, hk
     hk_tlv_t *request_tlvs_decrypted = NULL;
     hk_tlv_t *tlv_data_response = NULL;
 
-    esp_err_t ret = hk_tlv_get_mem_by_type(request_tlvs, HK_PAIR_TLV_ENCRYPTEDDATA, encrypted_data);
+    esp_err_t ret = keys->has_session_keys ? ESP_OK : ESP_ERR_INVALID_STATE;
 
-    RUN_AND_CHECK(ret, hk_chacha20poly1305_decrypt, keys->session_key, HK_CHACHA_VERIFY_MSG3, encrypted_data, decrypted_data);
+    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_ENCRYPTEDDATA, encrypted_data);
+    RUN_AND_CHECK(ret, hk_chacha20poly1305_decrypt, HK_CONN_KEY_STORE_MEM(keys->session_key), HK_CHACHA_VERIFY_MSG3, encrypted_data, decrypted_data);
 
     if (!ret)
     {
@@ -178,14 +197,14 @@ esp_err_t hk_pair_verify_finish(hk_conn_key_store_t *keys, hk_mem *device_id, hk
 
     RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs_decrypted, HK_PAIR_TLV_IDENTIFIER, device_id);
     RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs_decrypted, HK_PAIR_TLV_SIGNATURE, device_signature);
-    RUN_AND_CHECK(ret, hk_pairings_store_ltpk_get, device_id, device_long_term_key_public);
+    RUN_AND_CHECK(ret, hk_pairings_store_ltpk_get, hk_slice_from_mem(device_id), device_long_term_key_public);
     RUN_AND_CHECK(ret, hk_ed25519_init_from_public_key, device_long_term_key, device_long_term_key_public);
 
     if (!ret)
     {
-        hk_mem_append(device_info, keys->device_session_key_public);
+        hk_mem_append_buffer(device_info, keys->device_session_key_public, HK_CONN_KEY_STORE_KEY_SIZE);
         hk_mem_append(device_info, device_id);
-        hk_mem_append(device_info, keys->accessory_session_key_public);
+        hk_mem_append_buffer(device_info, keys->accessory_session_key_public, HK_CONN_KEY_STORE_KEY_SIZE);
     }
 
     RUN_AND_CHECK(ret, hk_ed25519_verify, device_long_term_key, device_signature, device_info);
@@ -279,11 +298,13 @@ esp_err_t hk_pair_verify_resume(hk_conn_key_store_t *keys, hk_tlv_t *request_tlv
         }
 
         RUN_AND_CHECK(ret, hk_chacha20poly1305_caluclate_auth_tag_without_message, encryption_key, HK_CHACHA_RESUME_MSG2, encrypted_data);
-        RUN_AND_CHECK(ret, hk_hkdf_with_external_salt, session->accessory_shared_secret, keys->accessory_shared_secret, salt, HK_HKDF_PAIR_RESUME_SHARED_SECRET_INFO);
+        RUN_AND_CHECK(ret, hk_hkdf_with_external_salt_to_buffer, session->accessory_shared_secret, keys->accessory_shared_secret, salt, HK_HKDF_PAIR_RESUME_SHARED_SECRET_INFO);
 
         if (!ret)
         {
-            hk_mem_set_mem(session->accessory_shared_secret, keys->accessory_shared_secret);
+            keys->has_shared_secret = true;
+            hk_mem_set(session->accessory_shared_secret, 0);
+            hk_mem_append_buffer(session->accessory_shared_secret, keys->accessory_shared_secret, HK_CONN_KEY_STORE_KEY_SIZE);
             RUN_AND_CHECK(ret, hk_pair_verify_create_session_security, keys);
         }
 
@@ -348,7 +369,16 @@ esp_err_t hk_pair_verify(hk_mem *request, hk_mem *result, hk_conn_key_store_t *k
                 }
             }
             
-            if(!*is_session_encrypted)
+            if (!*is_session_encrypted && !hk_pair_limiter_verify_take(keys->source))
+            {
+                // resumed sessions of paired controllers are cheap and not limited
+                hk_tlv_t *tlv_data_response = NULL;
+                tlv_data_response = hk_tlv_add_uint8(tlv_data_response, HK_PAIR_TLV_STATE, HK_PAIR_TLV_STATE_M2);
+                tlv_data_response = hk_tlv_add_uint8(tlv_data_response, HK_PAIR_TLV_ERROR, HK_PAIR_TLV_ERROR_BUSY);
+                hk_tlv_serialize(tlv_data_response, result);
+                hk_tlv_free(tlv_data_response);
+            }
+            else if (!*is_session_encrypted)
             {
                 ret = hk_pair_verify_start(keys, tlv_data_request, result);
             }
@@ -14,13 +14,14 @@ static esp_err_t hk_pairings_add(hk_mem *conn_device_id, hk_tlv_t *request_tlvs,
     *is_paired = true;
     bool is_admin = false;
     hk_tlv_t *response_tlvs = NULL;
-    hk_mem *device_id = hk_mem_init();
-    hk_mem *device_long_term_key_public = hk_mem_init();
+    hk_slice_t device_id;
+    hk_slice_t device_long_term_key_public;
     esp_err_t ret = ESP_OK;
 
-    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_IDENTIFIER, device_id);
-    RUN_AND_CHECK(ret, hk_pairings_store_is_admin, conn_device_id, &is_admin);
-    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_PUBLICKEY, device_long_term_key_public);
+    // the values are only looked at, so they are not copied out of the request
+    RUN_AND_CHECK(ret, hk_tlv_get_slice_by_type, request_tlvs, HK_PAIR_TLV_IDENTIFIER, &device_id);
+    RUN_AND_CHECK(ret, hk_pairings_store_is_admin, hk_slice_from_mem(conn_device_id), &is_admin);
+    RUN_AND_CHECK(ret, hk_tlv_get_slice_by_type, request_tlvs, HK_PAIR_TLV_PUBLICKEY, &device_long_term_key_public);
 
     if (is_admin)
     {
@@ -45,7 +46,6 @@ static esp_err_t hk_pairings_add(hk_mem *conn_device_id, hk_tlv_t *request_tlvs,
     response_tlvs = hk_tlv_add_uint8(response_tlvs, HK_PAIR_TLV_STATE, HK_PAIR_TLV_STATE_M2); //state M2 is always returned
 
     *response_tlvs_ptr = response_tlvs;
-    hk_mem_free(device_id);
 
     return ret;
 }
@@ -58,10 +58,10 @@ static esp_err_t hk_pairings_remove(hk_tlv_t *request_tlvs, hk_tlv_t **response_
     bool is_admin = false;
     bool has_admin_pairing = false;
     hk_tlv_t *response_tlvs = NULL;
-    hk_mem *device_id = hk_mem_init();
+    hk_slice_t device_id;
     esp_err_t ret = ESP_OK;
 
-    RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_IDENTIFIER, device_id);
+    RUN_AND_CHECK(ret, hk_tlv_get_slice_by_type, request_tlvs, HK_PAIR_TLV_IDENTIFIER, &device_id);
     RUN_AND_CHECK(ret, hk_pairings_store_is_admin, device_id, &is_admin);
 
     if (is_admin)
@@ -88,7 +88,6 @@ static esp_err_t hk_pairings_remove(hk_tlv_t *request_tlvs, hk_tlv_t **response_
     response_tlvs = hk_tlv_add_uint8(response_tlvs, HK_PAIR_TLV_STATE, HK_PAIR_TLV_STATE_M2); //state M2 is always returned
 
     *response_tlvs_ptr = response_tlvs;
-    hk_mem_free(device_id);
 
     return ret;
 }
@@ -104,7 +103,7 @@ static esp_err_t hk_pairings_list(hk_mem *conn_device_id, hk_tlv_t *request_tlvs
     esp_err_t ret = ESP_OK;
 
     RUN_AND_CHECK(ret, hk_tlv_get_mem_by_type, request_tlvs, HK_PAIR_TLV_IDENTIFIER, device_id);
-    RUN_AND_CHECK(ret, hk_pairings_store_is_admin, conn_device_id, &is_admin);
+    RUN_AND_CHECK(ret, hk_pairings_store_is_admin, hk_slice_from_mem(conn_device_id), &is_admin);
 
     if (is_admin)
     {
@@ -23,7 +23,13 @@ static esp_err_t hk_pairings_store_get(hk_mem *data)
 
 static esp_err_t hk_pairings_store_set(hk_mem *data)
 {
-    return hk_store_blob_set(HK_PARING_STORE_KEY, data);
+    esp_err_t ret = ESP_OK;
+
+    // a pairing has to survive a reset, right after it was confirmed
+    RUN_AND_CHECK(ret, hk_store_blob_set, HK_PARING_STORE_KEY, data);
+    RUN_AND_CHECK(ret, hk_store_flush);
+
+    return ret;
 }
 
 static void hk_pairings_store_entry_add(hk_pairing_store_pair *entry, hk_mem *data)
@@ -50,46 +56,40 @@ static void hk_pairings_store_entry_update(hk_pairing_store_pair *entry, char *d
     entry->length = 2 * sizeof(size_t) + sizeof(bool) + entry->id_length + entry->key_length;
 }
 
-static esp_err_t hk_pairings_store_entry_get(hk_pairing_store_pair *entry, hk_mem *data, hk_mem *device_id)
+static esp_err_t hk_pairings_store_entry_get(hk_pairing_store_pair *entry, hk_mem *data, hk_slice_t device_id)
 {
     esp_err_t ret = ESP_ERR_NOT_FOUND;
-    char *device_id_str = strndup(device_id->ptr, device_id->size);
 
     if (data->size > 0)
     {
         for (size_t data_read = 0; data_read < data->size;)
         {
             hk_pairings_store_entry_update(entry, data->ptr + data_read);
-            char *entry_str = strndup(entry->id, entry->id_length);
-            if (strcmp(device_id_str, entry_str) == 0)
+            if (hk_slice_equal(device_id, hk_slice_init(entry->id, entry->id_length)))
             {
                 ret = ESP_OK;
-                free(entry_str);
                 break;
             }
 
-            free(entry_str);
-
             data_read += entry->length;
         }
     }
 
-    free(device_id_str);
     return ret;
 }
 
-esp_err_t hk_pairings_store_add(hk_mem *device_id, hk_mem *device_ltpk, bool is_admin)
+esp_err_t hk_pairings_store_add(hk_slice_t device_id, hk_slice_t device_ltpk, bool is_admin)
 {
     esp_err_t ret = ESP_OK;
     hk_mem *data = hk_mem_init();
     hk_pairing_store_pair *entry = (hk_pairing_store_pair *)malloc(sizeof(hk_pairing_store_pair));
 
     hk_pairings_store_get(data);
-    entry->id_length = device_id->size;
-    entry->key_length = device_ltpk->size;
+    entry->id_length = device_id.size;
+    entry->key_length = device_ltpk.size;
     entry->is_admin = is_admin;
-    entry->id = device_id->ptr;
-    entry->key = device_ltpk->ptr;
+    entry->id = device_id.ptr;
+    entry->key = device_ltpk.ptr;
     hk_pairings_store_entry_add(entry, data);
     RUN_AND_CHECK(ret, hk_pairings_store_set, data);
 
@@ -99,7 +99,7 @@ esp_err_t hk_pairings_store_add(hk_mem *device_id, hk_mem *device_ltpk, bool is_
     return ret;
 }
 
-esp_err_t hk_pairings_store_device_exists(hk_mem *device_id, bool *exists)
+esp_err_t hk_pairings_store_device_exists(hk_slice_t device_id, bool *exists)
 {
     hk_mem *data = hk_mem_init();
     hk_pairing_store_pair *entry = (hk_pairing_store_pair *)malloc(sizeof(hk_pairing_store_pair));
@@ -122,7 +122,7 @@ esp_err_t hk_pairings_store_device_exists(hk_mem *device_id, bool *exists)
     return ret;
 }
 
-esp_err_t hk_pairings_store_ltpk_get(hk_mem *device_id, hk_mem *device_ltpk)
+esp_err_t hk_pairings_store_ltpk_get(hk_slice_t device_id, hk_mem *device_ltpk)
 {
     hk_mem *data = hk_mem_init();
     hk_pairing_store_pair *entry = (hk_pairing_store_pair *)malloc(sizeof(hk_pairing_store_pair));
@@ -140,14 +140,13 @@ esp_err_t hk_pairings_store_ltpk_get(hk_mem *device_id, hk_mem *device_ltpk)
     return ret;
 }
 
-esp_err_t hk_pairings_store_remove(hk_mem *device_id)
+esp_err_t hk_pairings_store_remove(hk_slice_t device_id)
 {
     esp_err_t ret = ESP_OK;
     hk_mem *data = hk_mem_init();
     hk_mem *new_data = hk_mem_init();
     hk_pairing_store_pair *entry = (hk_pairing_store_pair *)malloc(sizeof(hk_pairing_store_pair));
     bool item_removed = false;
-    char *device_id_str = strndup(device_id->ptr, device_id->size);
 
     RUN_AND_CHECK(ret, hk_pairings_store_get, data);
     if (!ret && data->size > 0)
@@ -155,7 +154,7 @@ esp_err_t hk_pairings_store_remove(hk_mem *device_id)
         for (size_t data_read = 0; data_read < data->size;)
         {
             hk_pairings_store_entry_update(entry, data->ptr + data_read);
-            if (strcmp(device_id_str, entry->id))
+            if (hk_slice_equal(device_id, hk_slice_init(entry->id, entry->id_length)))
             {
                 item_removed = true;
             }
@@ -178,13 +177,12 @@ esp_err_t hk_pairings_store_remove(hk_mem *device_id)
     
     hk_mem_free(data);
     hk_mem_free(new_data);
-    free(device_id_str);
     free(entry);
 
     return ret;
 }
 
-esp_err_t hk_pairings_store_is_admin(hk_mem *device_id, bool *is_admin)
+esp_err_t hk_pairings_store_is_admin(hk_slice_t device_id, bool *is_admin)
 {
     hk_mem *data = hk_mem_init();
     hk_pairing_store_pair *entry = (hk_pairing_store_pair *)malloc(sizeof(hk_pairing_store_pair));
@@ -249,6 +247,7 @@ esp_err_t hk_pairings_store_remove_all()
     HK_LOGD("Deleting paring store.");
     esp_err_t ret = ESP_OK;
     ret = hk_store_erase(HK_PARING_STORE_KEY);
+    RUN_AND_CHECK(ret, hk_store_flush);
     
     if (ret == ESP_ERR_NVS_NOT_FOUND)
     {
@@ -275,7 +274,7 @@ esp_err_t hk_pairings_log_devices()
         {
             hk_pairings_store_entry_update(entry, data->ptr + data_read);
             
-            HK_LOGI("%s", strndup(entry->id, entry->id_length));
+            HK_LOGI("%.*s", (int)entry->id_length, entry->id);
             data_read += entry->length;
         }
     }
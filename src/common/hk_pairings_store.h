@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../include/hk_mem.h"
+#include "../utils/hk_slice.h"
 
 #include <esp_err.h>
 #include <stdbool.h>
@@ -22,7 +23,7 @@
  * 
  * @return Returns ESP_OK on success.
  */
-esp_err_t hk_pairings_store_add(hk_mem* device_id, hk_mem* device_ltpk, bool is_admin);
+esp_err_t hk_pairings_store_add(hk_slice_t device_id, hk_slice_t device_ltpk, bool is_admin);
 
 /**
  * @brief Removes a pairing
@@ -33,7 +34,7 @@ esp_err_t hk_pairings_store_add(hk_mem* device_id, hk_mem* device_ltpk, bool is_
  * 
  * @return Returns ESP_OK on success.
  */
-esp_err_t hk_pairings_store_remove(hk_mem *device_id);
+esp_err_t hk_pairings_store_remove(hk_slice_t device_id);
 
 /**
  * @brief Check if a device pairing exists
@@ -45,7 +46,7 @@ esp_err_t hk_pairings_store_remove(hk_mem *device_id);
  * 
  * @return Returns ESP_OK on success.
  */
-esp_err_t hk_pairings_store_device_exists(hk_mem *device_id, bool *exists);
+esp_err_t hk_pairings_store_device_exists(hk_slice_t device_id, bool *exists);
 
 /**
  * @brief Check if a device pairing is an admin pairing
@@ -57,7 +58,7 @@ esp_err_t hk_pairings_store_device_exists(hk_mem *device_id, bool *exists);
  * 
  * @return Returns ESP_OK on success.
  */
-esp_err_t hk_pairings_store_is_admin(hk_mem *device_id, bool *is_admin);
+esp_err_t hk_pairings_store_is_admin(hk_slice_t device_id, bool *is_admin);
 
 /**
  * @brief Checks if store holds an admin pairing
@@ -100,7 +101,7 @@ esp_err_t hk_pairings_store_remove_all();
  * 
  * @return Returns ESP_OK on success.
  */
-esp_err_t hk_pairings_store_ltpk_get(hk_mem *device_id, hk_mem *device_ltpk);
+esp_err_t hk_pairings_store_ltpk_get(hk_slice_t device_id, hk_mem *device_ltpk);
 
 
 /**
@@ -0,0 +1,551 @@
+#include "hk_value.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "../utils/hk_logging.h"
+
+static const char hk_value_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static size_t hk_value_format_uint64(uint64_t number, char *out)
+{
+    char buffer[20];
+    char *current = buffer + sizeof(buffer);
+
+    // two digits per division, as the division is the expensive part
+    while (number >= 100)
+    {
+        const char *digits = hk_value_digits + (number % 100) * 2;
+        number /= 100;
+        *--current = digits[1];
+        *--current = digits[0];
+    }
+
+    if (number >= 10)
+    {
+        const char *digits = hk_value_digits + number * 2;
+        *--current = digits[1];
+        *--current = digits[0];
+    }
+    else
+    {
+        *--current = '0' + number;
+    }
+
+    size_t length = buffer + sizeof(buffer) - current;
+    memcpy(out, current, length);
+    out[length] = 0;
+
+    return length;
+}
+
+static size_t hk_value_format_float_digits(const char *digits, size_t count, int exponent, char *out)
+{
+    char *current = out;
+
+    if (exponent < -5 || exponent > 9)
+    {
+        // d.ddde-XX, as %g writes numbers with a large or small exponent
+        *current++ = digits[0];
+        if (count > 1)
+        {
+            *current++ = '.';
+            memcpy(current, digits + 1, count - 1);
+            current += count - 1;
+        }
+
+        *current++ = 'e';
+        *current++ = exponent < 0 ? '-' : '+';
+        current += hk_value_format_uint64(exponent < 0 ? -exponent : exponent, current);
+    }
+    else if (exponent < 0)
+    {
+        // 0.000ddd
+        *current++ = '0';
+        *current++ = '.';
+        memset(current, '0', -exponent - 1);
+        current += -exponent - 1;
+        memcpy(current, digits, count);
+        current += count;
+    }
+    else
+    {
+        // ddd.ddd or ddd000
+        for (int i = 0; i <= exponent || i < count; i++)
+        {
+            if (i == exponent + 1)
+            {
+                *current++ = '.';
+            }
+
+            *current++ = i < count ? digits[i] : '0';
+        }
+    }
+
+    *current = 0;
+
+    return current - out;
+}
+
+static size_t hk_value_format_float(float number, char *out)
+{
+    if (!isfinite(number))
+    {
+        return 0;
+    }
+
+    // the sign is written first, so -0 keeps its sign
+    if (signbit(number))
+    {
+        *out = '-';
+        return hk_value_format_float(-number, out + 1) + 1;
+    }
+
+    // whole numbers are written without exponent, as %g would write 100 as 1e+02
+    if (number < 1e9f && number == (float)(uint32_t)number)
+    {
+        return hk_value_format_uint64((uint32_t)number, out);
+    }
+
+    // The shortest digits are generated in one pass (Steele & White): digits are taken from the number, until the
+    // rest is within half the distance to one of the neighbouring floats, so the digits read back as the same float.
+    // A float is exact in a double, and the rounding errors of the double are far below the distance of the floats.
+    // The distances are shrunk a bit, so these errors never pick digits, which read back as a neighbour. Digits exactly
+    // on the boundary are not taken, which writes one more digit for a few numbers.
+    double value = number;
+    double low = (value - nextafterf(number, 0)) / 2 * 0.999999;
+    double high = isfinite(nextafterf(number, INFINITY)) ? (nextafterf(number, INFINITY) - value) / 2 * 0.999999 : low;
+
+    int exponent = 0;
+    frexp(value, &exponent);
+    exponent = (int)floor((exponent - 1) * 0.30102999566398120);
+    double scale = pow(10, -exponent);
+    if (value * scale >= 10)
+    {
+        exponent++;
+        scale /= 10;
+    }
+    else if (value * scale < 1)
+    {
+        exponent--;
+        scale *= 10;
+    }
+
+    value *= scale;
+    low *= scale;
+    high *= scale;
+
+    // a float has 9 significant digits at most
+    char digits[10];
+    size_t count = 0;
+    while (count < sizeof(digits))
+    {
+        int digit = (int)value;
+        value -= digit;
+
+        bool is_low_close = value < low;
+        bool is_high_close = value > 1 - high;
+        if (is_low_close || is_high_close)
+        {
+            if (is_high_close && (!is_low_close || value >= 0.5))
+            {
+                digit++;
+            }
+
+            digits[count++] = '0' + digit;
+            break;
+        }
+
+        digits[count++] = '0' + digit;
+        value *= 10;
+        low *= 10;
+        high *= 10;
+    }
+
+    // rounding up the last digit carries over into the digits before
+    for (size_t i = count - 1; i > 0 && digits[i] > '9'; i--)
+    {
+        digits[i] = '0';
+        digits[i - 1]++;
+    }
+
+    if (digits[0] > '9')
+    {
+        digits[0] = '1';
+        exponent++;
+    }
+
+    while (count > 1 && digits[count - 1] == '0')
+    {
+        count--;
+    }
+
+    return hk_value_format_float_digits(digits, count, exponent, out);
+}
+
+static bool hk_value_literal_equals(const char *text, size_t length, const char *literal)
+{
+    return length == strlen(literal) && memcmp(text, literal, length) == 0;
+}
+
+static esp_err_t hk_value_parse_integer(const char *text, size_t length, bool *negative, uint64_t *number)
+{
+    size_t i = 0;
+    *negative = false;
+    *number = 0;
+
+    if (hk_value_literal_equals(text, length, "true"))
+    {
+        *number = 1;
+        return ESP_OK;
+    }
+    else if (hk_value_literal_equals(text, length, "false"))
+    {
+        return ESP_OK;
+    }
+
+    if (i < length && text[i] == '-')
+    {
+        *negative = true;
+        i++;
+    }
+
+    if (i >= length || text[i] < '0' || text[i] > '9')
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; i++)
+    {
+        uint64_t digit = text[i] - '0';
+        if (*number > (UINT64_MAX - digit) / 10)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        *number = *number * 10 + digit;
+    }
+
+    // a fraction is accepted, as long as it does not change the number
+    if (i < length && text[i] == '.')
+    {
+        for (i++; i < length && text[i] == '0'; i++)
+        {
+        }
+    }
+
+    return i == length ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+size_t hk_value_size(hk_format_t format)
+{
+    switch (format)
+    {
+    case HK_FORMAT_BOOL:
+    case HK_FORMAT_UINT8:
+        return sizeof(uint8_t);
+    case HK_FORMAT_UINT16:
+        return sizeof(uint16_t);
+    case HK_FORMAT_UINT32:
+    case HK_FORMAT_INT:
+        return sizeof(uint32_t);
+    case HK_FORMAT_UINT64:
+        return sizeof(uint64_t);
+    case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
+        return sizeof(float);
+    default:
+        return 0;
+    }
+}
+
+esp_err_t hk_value_decode(hk_format_t format, const char *data, size_t size, hk_value_t *value)
+{
+    value->format = format;
+    value->u64 = 0;
+
+    switch (format)
+    {
+    case HK_FORMAT_BOOL:
+    {
+        if (size < 1)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        value->b = false;
+        for (size_t i = 0; i < size; i++)
+        {
+            value->b |= data[i] != 0;
+        }
+
+        return ESP_OK;
+    }
+    case HK_FORMAT_UINT8:
+    case HK_FORMAT_UINT16:
+    case HK_FORMAT_UINT32:
+    case HK_FORMAT_UINT64:
+    case HK_FORMAT_INT:
+    {
+        size_t width = hk_value_size(format);
+        if (size < 1)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        // little endian, like the esp32 and bluetooth
+        uint64_t number = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            uint8_t byte = (uint8_t)data[i];
+            if (i < sizeof(uint64_t))
+            {
+                number |= (uint64_t)byte << (i * 8);
+            }
+            else if (byte != 0)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+        }
+
+        if (format == HK_FORMAT_INT)
+        {
+            // sign extend the given width and check that it fits into 32 bits
+            int64_t signed_number = size < sizeof(uint64_t) && (number >> (size * 8 - 1)) & 1 ? (int64_t)(number | (UINT64_MAX << (size * 8))) : (int64_t)number;
+            if (signed_number < INT32_MIN || signed_number > INT32_MAX)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            value->i32 = (int32_t)signed_number;
+        }
+        else if (width < sizeof(uint64_t) && number >> (width * 8) != 0)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        else
+        {
+            value->u64 = number;
+        }
+
+        return ESP_OK;
+    }
+    case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
+        if (size == sizeof(float))
+        {
+            memcpy(&value->f, data, sizeof(float));
+        }
+        else if (size == sizeof(double))
+        {
+            double number;
+            memcpy(&number, data, sizeof(double));
+            value->f = (float)number;
+        }
+        else
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        return ESP_OK;
+    case HK_FORMAT_STRING:
+        while (size > 0 && data[size - 1] == 0)
+        {
+            size--;
+        }
+        value->buffer.ptr = data;
+        value->buffer.size = size;
+        return ESP_OK;
+    case HK_FORMAT_TLV8:
+    case HK_FORMAT_DATA:
+        value->buffer.ptr = data;
+        value->buffer.size = size;
+        return ESP_OK;
+    default:
+        HK_LOGE("Cannot decode value of unknown format %d.", format);
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+esp_err_t hk_value_encode(const hk_value_t *value, hk_mem *out)
+{
+    switch (value->format)
+    {
+    case HK_FORMAT_BOOL:
+    {
+        uint8_t byte = value->b ? 1 : 0;
+        hk_mem_append_buffer(out, (char *)&byte, sizeof(uint8_t));
+        return ESP_OK;
+    }
+    case HK_FORMAT_UINT8:
+    case HK_FORMAT_UINT16:
+    case HK_FORMAT_UINT32:
+    case HK_FORMAT_UINT64:
+    {
+        // the union is little endian, so the lower bytes hold the value for each width
+        uint64_t number = value->u64;
+        hk_mem_append_buffer(out, (char *)&number, hk_value_size(value->format));
+        return ESP_OK;
+    }
+    case HK_FORMAT_INT:
+    {
+        int32_t number = value->i32;
+        hk_mem_append_buffer(out, (char *)&number, sizeof(int32_t));
+        return ESP_OK;
+    }
+    case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
+    {
+        float number = value->f;
+        hk_mem_append_buffer(out, (char *)&number, sizeof(float));
+        return ESP_OK;
+    }
+    case HK_FORMAT_STRING:
+    case HK_FORMAT_TLV8:
+    case HK_FORMAT_DATA:
+        hk_mem_append_buffer(out, (char *)value->buffer.ptr, value->buffer.size);
+        return ESP_OK;
+    default:
+        HK_LOGE("Cannot encode value of unknown format %d.", value->format);
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+esp_err_t hk_value_parse(hk_format_t format, const char *text, size_t length, hk_value_t *value)
+{
+    value->format = format;
+    value->u64 = 0;
+
+    switch (format)
+    {
+    case HK_FORMAT_BOOL:
+        if (hk_value_literal_equals(text, length, "true") || hk_value_literal_equals(text, length, "1"))
+        {
+            value->b = true;
+        }
+        else if (hk_value_literal_equals(text, length, "false") || hk_value_literal_equals(text, length, "0"))
+        {
+            value->b = false;
+        }
+        else
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        return ESP_OK;
+    case HK_FORMAT_UINT8:
+    case HK_FORMAT_UINT16:
+    case HK_FORMAT_UINT32:
+    case HK_FORMAT_UINT64:
+    case HK_FORMAT_INT:
+    {
+        bool negative = false;
+        uint64_t number = 0;
+        if (hk_value_parse_integer(text, length, &negative, &number) != ESP_OK)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (format == HK_FORMAT_INT)
+        {
+            if ((negative && number > (uint64_t)INT32_MAX + 1) || (!negative && number > INT32_MAX))
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+
+            value->i32 = negative ? (int32_t)(0 - number) : (int32_t)number;
+            return ESP_OK;
+        }
+
+        size_t width = hk_value_size(format);
+        if ((negative && number != 0) || (width < sizeof(uint64_t) && number >> (width * 8) != 0))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        value->u64 = number;
+        return ESP_OK;
+    }
+    case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
+    {
+        char buffer[32];
+        char *end = NULL;
+        if (length == 0 || length >= sizeof(buffer))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        memcpy(buffer, text, length);
+        buffer[length] = 0;
+        value->f = strtof(buffer, &end);
+        if (end != buffer + length || !isfinite(value->f))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        return ESP_OK;
+    }
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+size_t hk_value_format(const hk_value_t *value, char *out)
+{
+    switch (value->format)
+    {
+    case HK_FORMAT_BOOL:
+        strcpy(out, value->b ? "true" : "false");
+        return value->b ? 4 : 5;
+    case HK_FORMAT_UINT8:
+        return hk_value_format_uint64(value->u8, out);
+    case HK_FORMAT_UINT16:
+        return hk_value_format_uint64(value->u16, out);
+    case HK_FORMAT_UINT32:
+        return hk_value_format_uint64(value->u32, out);
+    case HK_FORMAT_UINT64:
+        return hk_value_format_uint64(value->u64, out);
+    case HK_FORMAT_INT:
+        if (value->i32 < 0)
+        {
+            out[0] = '-';
+            return hk_value_format_uint64(0 - (uint64_t)(int64_t)value->i32, out + 1) + 1;
+        }
+        return hk_value_format_uint64(value->i32, out);
+    case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
+        return hk_value_format_float(value->f, out);
+    default:
+        return 0;
+    }
+}
+
+esp_err_t hk_value_normalize(hk_format_t format, hk_mem *mem)
+{
+    if (hk_value_size(format) == 0)
+    {
+        // strings, tlv8 and data have no width to normalize
+        return ESP_OK;
+    }
+
+    hk_value_t value;
+    esp_err_t ret = hk_value_decode(format, mem->ptr, mem->size, &value);
+    if (ret == ESP_OK)
+    {
+        hk_mem_set(mem, 0);
+        ret = hk_value_encode(&value, mem);
+    }
+
+    return ret;
+}
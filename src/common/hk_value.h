@@ -0,0 +1,124 @@
+/**
+ * @file hk_value.h
+ *
+ * Functions to convert characteristic values between their binary and textual representation.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#include "../include/hk_mem.h"
+#include "hk_chrs_properties.h"
+
+/**
+ * @brief The maximum size of a formatted number, including the string terminator.
+ */
+#define HK_VALUE_MAX_FORMATTED_SIZE 24
+
+/**
+ * @brief A characteristic value.
+ *
+ * A value tagged with the format of its characteristic. Strings, tlv8 and data point into the buffer they were
+ * decoded from and are not copied.
+ */
+typedef struct
+{
+    hk_format_t format;
+    union
+    {
+        bool b;
+        uint8_t u8;
+        uint16_t u16;
+        uint32_t u32;
+        uint64_t u64;
+        int32_t i32;
+        float f;
+        struct
+        {
+            const char *ptr;
+            size_t size;
+        } buffer;
+    };
+} hk_value_t;
+
+/**
+ * @brief Returns the binary size of a format.
+ *
+ * Returns the size of the binary representation of a format.
+ *
+ * @param format The format.
+ * 
+ * @return Returns the size in bytes or 0 if the format has no fixed size.
+ */
+size_t hk_value_size(hk_format_t format);
+
+/**
+ * @brief Decodes a binary value.
+ *
+ * Decodes a value in the binary representation of its format, as it is used by the callbacks and by bluetooth.
+ * Integers wider than the format are accepted, if the upper bytes are not used. Floats given as double are converted.
+ *
+ * @param format The format of the value.
+ * @param data The binary value.
+ * @param size The size of the binary value.
+ * @param value The decoded value.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_SIZE if the value does not fit the format.
+ */
+esp_err_t hk_value_decode(hk_format_t format, const char *data, size_t size, hk_value_t *value);
+
+/**
+ * @brief Encodes a binary value.
+ *
+ * Appends the binary representation of a value with the exact width of its format.
+ *
+ * @param value The value.
+ * @param out The memory to append to.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_value_encode(const hk_value_t *value, hk_mem *out);
+
+/**
+ * @brief Parses a textual value.
+ *
+ * Parses a json literal (number, true or false) with the format of the characteristic. Integers are checked
+ * against the range of the format. Booleans accept 0 and 1, integers accept true and false.
+ *
+ * @param format The format of the value.
+ * @param text The json literal, it does not have to be null terminated.
+ * @param length The length of the literal.
+ * @param value The parsed value.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_ARG if the literal does not match the format.
+ */
+esp_err_t hk_value_parse(hk_format_t format, const char *text, size_t length, hk_value_t *value);
+
+/**
+ * @brief Formats a textual value.
+ *
+ * Formats a number or boolean value as json literal. Floats are written with the shortest representation,
+ * that reads back to the same value.
+ *
+ * @param value The value.
+ * @param out The output buffer with at least HK_VALUE_MAX_FORMATTED_SIZE bytes. It is null terminated.
+ * 
+ * @return Returns the length of the literal or 0 if the format is not a number or boolean.
+ */
+size_t hk_value_format(const hk_value_t *value, char *out);
+
+/**
+ * @brief Normalizes a binary value.
+ *
+ * Decodes a binary value and encodes it again with the exact width of its format.
+ *
+ * @param format The format of the value.
+ * @param mem The binary value, which is replaced.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_value_normalize(hk_format_t format, hk_mem *mem);
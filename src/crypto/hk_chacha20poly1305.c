@@ -1,4 +1,5 @@
 #include "hk_chacha20poly1305.h"
+#include "hk_chacha20poly1305_native.h"
 #include "hk_crypto_util.h"
 #include "../utils/hk_logging.h"
 #include "../include/hk_mem.h"
@@ -8,6 +9,7 @@
 #include <wolfssl/wolfcrypt/poly1305.h>
 #include <wolfssl/wolfcrypt/chacha.h>
 
+#ifndef CONFIG_ESP32_HAP_CHACHA20POLY1305_NATIVE
 static void hk_chacha20poly1305_word32_to_little64(const word32 inLittle32, byte outLittle64[8])
 {
     XMEMSET(outLittle64 + 4, 0, 4);
@@ -17,6 +19,7 @@ static void hk_chacha20poly1305_word32_to_little64(const word32 inLittle32, byte
     outLittle64[2] = (byte)((inLittle32 & 0x00FF0000) >> 16);
     outLittle64[3] = (byte)((inLittle32 & 0xFF000000) >> 24);
 }
+#endif
 
 esp_err_t hk_chacha20poly1305_caluclate_auth_tag_without_message(hk_mem *key, const char *nonce, hk_mem *auth_tag)
 {
@@ -25,6 +28,11 @@ esp_err_t hk_chacha20poly1305_caluclate_auth_tag_without_message(hk_mem *key, co
         HK_LOGE("Key size has to be %d but was %d.", CHACHA20_POLY1305_AEAD_KEYSIZE, key->size);
     }
 
+#ifdef CONFIG_ESP32_HAP_CHACHA20POLY1305_NATIVE
+    // the auth tag of an empty message without aad
+    hk_mem_set(auth_tag, CHACHA20_POLY1305_AEAD_AUTHTAG_SIZE);
+    return hk_chacha20poly1305_native_encrypt((const uint8_t *)key->ptr, (const uint8_t *)nonce, NULL, 0, NULL, NULL, 0, (uint8_t *)auth_tag->ptr);
+#else
     Poly1305 poly1305Ctx;
     ChaCha chaChaCtx;
     byte poly1305Key[CHACHA20_POLY1305_AEAD_KEYSIZE];
@@ -77,6 +85,7 @@ esp_err_t hk_chacha20poly1305_caluclate_auth_tag_without_message(hk_mem *key, co
         HK_CRYPOT_ERR("Failed decrypt message", err);
         return ESP_FAIL;
     }
+#endif
 }
 
 esp_err_t hk_chacha20poly1305_encrypt(hk_mem *key, const char *nonce, hk_mem *message, hk_mem *encrypted)
@@ -87,6 +96,14 @@ esp_err_t hk_chacha20poly1305_encrypt(hk_mem *key, const char *nonce, hk_mem *me
 
 esp_err_t hk_chacha20poly1305_encrypt_buffer(hk_mem *key, const char *nonce, char *aad, size_t aad_size, char *message, char *encrypted, size_t message_size)
 {
+#ifdef CONFIG_ESP32_HAP_CHACHA20POLY1305_NATIVE
+    return hk_chacha20poly1305_native_encrypt(
+        (const uint8_t *)key->ptr,
+        (const uint8_t *)nonce,
+        (const uint8_t *)aad, aad_size,
+        (const uint8_t *)message, (uint8_t *)encrypted, message_size,
+        (uint8_t *)(encrypted + message_size));
+#else
     int ret = wc_ChaCha20Poly1305_Encrypt(
         (byte *)key->ptr,
         (byte *)nonce,
@@ -98,6 +115,7 @@ esp_err_t hk_chacha20poly1305_encrypt_buffer(hk_mem *key, const char *nonce, cha
         HK_CRYPOT_ERR("Error encrypting message", ret);
 
     return ret;
+#endif
 }
 
 esp_err_t hk_chacha20poly1305_decrypt(hk_mem *key, const char *nonce, hk_mem *encrypted, hk_mem *message)
@@ -109,6 +127,19 @@ esp_err_t hk_chacha20poly1305_decrypt(hk_mem *key, const char *nonce, hk_mem *en
 esp_err_t hk_chacha20poly1305_decrypt_buffer(hk_mem *key, const char *nonce, char *aad, size_t aad_size, char *encrypted,
                                              char *message, size_t message_size)
 {
+#ifdef CONFIG_ESP32_HAP_CHACHA20POLY1305_NATIVE
+    esp_err_t ret = hk_chacha20poly1305_native_decrypt(
+        (const uint8_t *)key->ptr,
+        (const uint8_t *)nonce,
+        (const uint8_t *)aad, aad_size,
+        (const uint8_t *)encrypted, (uint8_t *)message, message_size, // the encrypted message
+        (const uint8_t *)encrypted + message_size);                   // the authTag
+
+    if (ret != ESP_OK)
+    {
+        HK_LOGE("Failed decrypt message, the auth tag does not match.");
+    }
+#else
     int ret = wc_ChaCha20Poly1305_Decrypt(
         (byte *)key->ptr,
         (const byte *)nonce,
@@ -121,6 +152,7 @@ esp_err_t hk_chacha20poly1305_decrypt_buffer(hk_mem *key, const char *nonce, cha
     {
         HK_CRYPOT_ERR("Failed decrypt message", ret);
     }
+#endif
 
     return ret;
 }
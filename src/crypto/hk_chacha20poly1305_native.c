@@ -0,0 +1,380 @@
+#include "hk_chacha20poly1305_native.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#define HK_CHACHA20POLY1305_NATIVE_BLOCK_SIZE 64
+#define HK_CHACHA20POLY1305_NATIVE_MASK26 0x3ffffff
+
+#define HK_CHACHA20POLY1305_NATIVE_ROTATE(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(a, b, c, d)          \
+    a += b;                                                           \
+    d = HK_CHACHA20POLY1305_NATIVE_ROTATE(d ^ a, 16);                 \
+    c += d;                                                           \
+    b = HK_CHACHA20POLY1305_NATIVE_ROTATE(b ^ c, 12);                 \
+    a += b;                                                           \
+    d = HK_CHACHA20POLY1305_NATIVE_ROTATE(d ^ a, 8);                  \
+    c += d;                                                           \
+    b = HK_CHACHA20POLY1305_NATIVE_ROTATE(b ^ c, 7);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HK_CHACHA20POLY1305_NATIVE_LITTLE_ENDIAN
+#endif
+
+typedef struct
+{
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+} hk_chacha20poly1305_native_poly1305_t;
+
+static inline uint32_t hk_chacha20poly1305_native_load(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void hk_chacha20poly1305_native_store(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void hk_chacha20poly1305_native_zeroize(void *buffer, size_t size)
+{
+    // volatile, so the compiler cannot drop the writes to the stack, which is not read afterwards
+    volatile uint8_t *pointer = (volatile uint8_t *)buffer;
+    while (size--)
+    {
+        *pointer++ = 0;
+    }
+}
+
+static void hk_chacha20poly1305_native_chacha_init(uint32_t state[16], const uint8_t *key, const uint8_t *nonce)
+{
+    // "expand 32-byte k"
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        state[4 + i] = hk_chacha20poly1305_native_load(key + i * 4);
+    }
+
+    state[12] = 0;
+    state[13] = hk_chacha20poly1305_native_load(nonce);
+    state[14] = hk_chacha20poly1305_native_load(nonce + 4);
+    state[15] = hk_chacha20poly1305_native_load(nonce + 8);
+}
+
+// computes the key stream of the current block and advances the counter
+static void hk_chacha20poly1305_native_chacha_block(uint32_t state[16], uint32_t stream[16])
+{
+    uint32_t x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+    uint32_t x4 = state[4], x5 = state[5], x6 = state[6], x7 = state[7];
+    uint32_t x8 = state[8], x9 = state[9], x10 = state[10], x11 = state[11];
+    uint32_t x12 = state[12], x13 = state[13], x14 = state[14], x15 = state[15];
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x0, x4, x8, x12);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x1, x5, x9, x13);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x2, x6, x10, x14);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x3, x7, x11, x15);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x0, x5, x10, x15);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x1, x6, x11, x12);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x2, x7, x8, x13);
+        HK_CHACHA20POLY1305_NATIVE_QUARTER_ROUND(x3, x4, x9, x14);
+    }
+
+    stream[0] = x0 + state[0];
+    stream[1] = x1 + state[1];
+    stream[2] = x2 + state[2];
+    stream[3] = x3 + state[3];
+    stream[4] = x4 + state[4];
+    stream[5] = x5 + state[5];
+    stream[6] = x6 + state[6];
+    stream[7] = x7 + state[7];
+    stream[8] = x8 + state[8];
+    stream[9] = x9 + state[9];
+    stream[10] = x10 + state[10];
+    stream[11] = x11 + state[11];
+    stream[12] = x12 + state[12];
+    stream[13] = x13 + state[13];
+    stream[14] = x14 + state[14];
+    stream[15] = x15 + state[15];
+
+    state[12]++;
+}
+
+static void hk_chacha20poly1305_native_chacha_xor(const uint32_t stream[16], const uint8_t *in, uint8_t *out, size_t size)
+{
+#ifdef HK_CHACHA20POLY1305_NATIVE_LITTLE_ENDIAN
+    if (size == HK_CHACHA20POLY1305_NATIVE_BLOCK_SIZE && ((uintptr_t)in & 3) == 0 && ((uintptr_t)out & 3) == 0)
+    {
+        // the fast path for the full blocks of word aligned frames
+        const uint32_t *in_words = (const uint32_t *)in;
+        uint32_t *out_words = (uint32_t *)out;
+        for (size_t i = 0; i < 16; i++)
+        {
+            out_words[i] = in_words[i] ^ stream[i];
+        }
+
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = in[i] ^ (uint8_t)(stream[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+static void hk_chacha20poly1305_native_poly1305_init(hk_chacha20poly1305_native_poly1305_t *poly1305, const uint8_t *key)
+{
+    // r is clamped as required by the specification
+    poly1305->r[0] = (hk_chacha20poly1305_native_load(key + 0)) & 0x3ffffff;
+    poly1305->r[1] = (hk_chacha20poly1305_native_load(key + 3) >> 2) & 0x3ffff03;
+    poly1305->r[2] = (hk_chacha20poly1305_native_load(key + 6) >> 4) & 0x3ffc0ff;
+    poly1305->r[3] = (hk_chacha20poly1305_native_load(key + 9) >> 6) & 0x3f03fff;
+    poly1305->r[4] = (hk_chacha20poly1305_native_load(key + 12) >> 8) & 0x00fffff;
+
+    memset(poly1305->h, 0, sizeof(poly1305->h));
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        poly1305->pad[i] = hk_chacha20poly1305_native_load(key + 16 + i * 4);
+    }
+}
+
+// adds the data, which is padded with zeros to whole blocks of 16 bytes, as the aead construction requires
+static void hk_chacha20poly1305_native_poly1305_update(hk_chacha20poly1305_native_poly1305_t *poly1305, const uint8_t *data, size_t size)
+{
+    const uint32_t r0 = poly1305->r[0], r1 = poly1305->r[1], r2 = poly1305->r[2], r3 = poly1305->r[3], r4 = poly1305->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = poly1305->h[0], h1 = poly1305->h[1], h2 = poly1305->h[2], h3 = poly1305->h[3], h4 = poly1305->h[4];
+    uint8_t last[16];
+
+    while (size > 0)
+    {
+        const uint8_t *block = data;
+        if (size < 16)
+        {
+            memset(last, 0, sizeof(last));
+            memcpy(last, data, size);
+            block = last;
+        }
+
+        h0 += (hk_chacha20poly1305_native_load(block + 0)) & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h1 += (hk_chacha20poly1305_native_load(block + 3) >> 2) & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h2 += (hk_chacha20poly1305_native_load(block + 6) >> 4) & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h3 += (hk_chacha20poly1305_native_load(block + 9) >> 6) & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h4 += (hk_chacha20poly1305_native_load(block + 12) >> 8) | (1 << 24);
+
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        uint32_t c = (uint32_t)(d0 >> 26);
+        h0 = (uint32_t)d0 & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        d1 += c;
+        c = (uint32_t)(d1 >> 26);
+        h1 = (uint32_t)d1 & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        d2 += c;
+        c = (uint32_t)(d2 >> 26);
+        h2 = (uint32_t)d2 & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        d3 += c;
+        c = (uint32_t)(d3 >> 26);
+        h3 = (uint32_t)d3 & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        d4 += c;
+        c = (uint32_t)(d4 >> 26);
+        h4 = (uint32_t)d4 & HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h0 += c * 5;
+        c = h0 >> 26;
+        h0 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+        h1 += c;
+
+        if (size < 16)
+        {
+            break;
+        }
+
+        data += 16;
+        size -= 16;
+    }
+
+    poly1305->h[0] = h0;
+    poly1305->h[1] = h1;
+    poly1305->h[2] = h2;
+    poly1305->h[3] = h3;
+    poly1305->h[4] = h4;
+}
+
+static void hk_chacha20poly1305_native_poly1305_finish(hk_chacha20poly1305_native_poly1305_t *poly1305, uint8_t *auth_tag)
+{
+    uint32_t h0 = poly1305->h[0], h1 = poly1305->h[1], h2 = poly1305->h[2], h3 = poly1305->h[3], h4 = poly1305->h[4];
+
+    // carries h completely
+    uint32_t c = h1 >> 26;
+    h1 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    h1 += c;
+
+    // computes h - p and selects it without branches, if h is not smaller than p
+    uint32_t g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    uint32_t g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    uint32_t g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    uint32_t g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= HK_CHACHA20POLY1305_NATIVE_MASK26;
+    uint32_t g4 = h4 + c - (1UL << 26);
+
+    uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // converts to radix 2^32 and adds the pad
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    uint64_t f = (uint64_t)h0 + poly1305->pad[0];
+    hk_chacha20poly1305_native_store(auth_tag + 0, (uint32_t)f);
+    f = (uint64_t)h1 + poly1305->pad[1] + (f >> 32);
+    hk_chacha20poly1305_native_store(auth_tag + 4, (uint32_t)f);
+    f = (uint64_t)h2 + poly1305->pad[2] + (f >> 32);
+    hk_chacha20poly1305_native_store(auth_tag + 8, (uint32_t)f);
+    f = (uint64_t)h3 + poly1305->pad[3] + (f >> 32);
+    hk_chacha20poly1305_native_store(auth_tag + 12, (uint32_t)f);
+}
+
+// derives the key of poly1305 from the first block of key stream and authenticates the aad
+static void hk_chacha20poly1305_native_start(uint32_t state[16], hk_chacha20poly1305_native_poly1305_t *poly1305,
+                                             const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aad_size)
+{
+    uint32_t stream[16];
+    uint8_t poly1305_key[32];
+
+    hk_chacha20poly1305_native_chacha_init(state, key, nonce);
+    hk_chacha20poly1305_native_chacha_block(state, stream);
+    for (size_t i = 0; i < 8; i++)
+    {
+        hk_chacha20poly1305_native_store(poly1305_key + i * 4, stream[i]);
+    }
+
+    hk_chacha20poly1305_native_poly1305_init(poly1305, poly1305_key);
+    hk_chacha20poly1305_native_poly1305_update(poly1305, aad, aad_size);
+
+    // the key stream must not stay on the stack
+    hk_chacha20poly1305_native_zeroize(stream, sizeof(stream));
+    hk_chacha20poly1305_native_zeroize(poly1305_key, sizeof(poly1305_key));
+}
+
+// applies the key stream, beginning with the second block; if poly1305 is given, every output block is authenticated,
+// while it is still in the cache
+static void hk_chacha20poly1305_native_apply(uint32_t state[16], hk_chacha20poly1305_native_poly1305_t *poly1305,
+                                             const uint8_t *in, uint8_t *out, size_t size)
+{
+    uint32_t stream[16];
+
+    for (size_t position = 0; position < size; position += HK_CHACHA20POLY1305_NATIVE_BLOCK_SIZE)
+    {
+        size_t block_size = size - position < HK_CHACHA20POLY1305_NATIVE_BLOCK_SIZE ? size - position : HK_CHACHA20POLY1305_NATIVE_BLOCK_SIZE;
+        hk_chacha20poly1305_native_chacha_block(state, stream);
+        hk_chacha20poly1305_native_chacha_xor(stream, in + position, out + position, block_size);
+
+        if (poly1305 != NULL)
+        {
+            hk_chacha20poly1305_native_poly1305_update(poly1305, out + position, block_size);
+        }
+    }
+
+    hk_chacha20poly1305_native_zeroize(stream, sizeof(stream));
+}
+
+static void hk_chacha20poly1305_native_finish(hk_chacha20poly1305_native_poly1305_t *poly1305, size_t aad_size, size_t size, uint8_t *auth_tag)
+{
+    uint8_t lengths[16];
+    hk_chacha20poly1305_native_store(lengths + 0, (uint32_t)aad_size);
+    hk_chacha20poly1305_native_store(lengths + 4, 0);
+    hk_chacha20poly1305_native_store(lengths + 8, (uint32_t)size);
+    hk_chacha20poly1305_native_store(lengths + 12, 0);
+    hk_chacha20poly1305_native_poly1305_update(poly1305, lengths, sizeof(lengths));
+    hk_chacha20poly1305_native_poly1305_finish(poly1305, auth_tag);
+
+    hk_chacha20poly1305_native_zeroize(poly1305, sizeof(hk_chacha20poly1305_native_poly1305_t));
+}
+
+esp_err_t hk_chacha20poly1305_native_encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aad_size,
+                                             const uint8_t *message, uint8_t *encrypted, size_t message_size, uint8_t *auth_tag)
+{
+    uint32_t state[16];
+    hk_chacha20poly1305_native_poly1305_t poly1305;
+
+    hk_chacha20poly1305_native_start(state, &poly1305, key, nonce, aad, aad_size);
+    hk_chacha20poly1305_native_apply(state, &poly1305, message, encrypted, message_size);
+    hk_chacha20poly1305_native_finish(&poly1305, aad_size, message_size, auth_tag);
+    hk_chacha20poly1305_native_zeroize(state, sizeof(state));
+
+    return ESP_OK;
+}
+
+esp_err_t hk_chacha20poly1305_native_decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aad_size,
+                                             const uint8_t *encrypted, uint8_t *message, size_t message_size, const uint8_t *auth_tag)
+{
+    esp_err_t ret = ESP_OK;
+    uint32_t state[16];
+    hk_chacha20poly1305_native_poly1305_t poly1305;
+    uint8_t calculated_auth_tag[HK_CHACHA20POLY1305_NATIVE_TAG_SIZE];
+
+    // the message is only decrypted after the auth tag was verified, so forged frames never reach the output
+    hk_chacha20poly1305_native_start(state, &poly1305, key, nonce, aad, aad_size);
+    hk_chacha20poly1305_native_poly1305_update(&poly1305, encrypted, message_size);
+    hk_chacha20poly1305_native_finish(&poly1305, aad_size, message_size, calculated_auth_tag);
+
+    // compares in constant time
+    uint8_t difference = 0;
+    for (size_t i = 0; i < HK_CHACHA20POLY1305_NATIVE_TAG_SIZE; i++)
+    {
+        difference |= calculated_auth_tag[i] ^ auth_tag[i];
+    }
+
+    if (difference != 0)
+    {
+        ret = ESP_ERR_INVALID_MAC;
+    }
+    else
+    {
+        hk_chacha20poly1305_native_apply(state, NULL, encrypted, message, message_size);
+    }
+
+    hk_chacha20poly1305_native_zeroize(state, sizeof(state));
+
+    return ret;
+}
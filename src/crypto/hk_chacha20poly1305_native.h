@@ -0,0 +1,59 @@
+/**
+ * @file hk_chacha20poly1305_native.h
+ *
+ * A native ChaCha20-Poly1305 (RFC 8439) for 32 bit cores.
+ *
+ * Encrypts and authenticates in one pass over the frame: every 64 byte block of key stream is applied and the block
+ * is added to Poly1305, while it is still in the cache. Decryption verifies the auth tag first and only decrypts, if
+ * it matches. Poly1305 computes in radix 2^26, so all products fit into
+ * the 32x32 to 64 bit multiplications of Xtensa. Word aligned buffers are processed in words.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define HK_CHACHA20POLY1305_NATIVE_KEY_SIZE 32
+#define HK_CHACHA20POLY1305_NATIVE_NONCE_SIZE 12
+#define HK_CHACHA20POLY1305_NATIVE_TAG_SIZE 16
+
+/**
+ * @brief Encrypts and authenticates a message.
+ *
+ * Encrypts and authenticates a message. The message can be encrypted in place.
+ *
+ * @param key The key of 32 bytes.
+ * @param nonce The nonce of 12 bytes.
+ * @param aad The additional authenticated data, or NULL.
+ * @param aad_size The size of the additional authenticated data.
+ * @param message The message.
+ * @param encrypted The encrypted message of message_size bytes.
+ * @param message_size The size of the message.
+ * @param auth_tag The auth tag of 16 bytes.
+ *
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_chacha20poly1305_native_encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aad_size,
+                                             const uint8_t *message, uint8_t *encrypted, size_t message_size, uint8_t *auth_tag);
+
+/**
+ * @brief Decrypts and verifies a message.
+ *
+ * Verifies the auth tag of a message and decrypts it, if the auth tag matches. The message can be decrypted in place.
+ * If the auth tag does not match, the output is not written.
+ *
+ * @param key The key of 32 bytes.
+ * @param nonce The nonce of 12 bytes.
+ * @param aad The additional authenticated data, or NULL.
+ * @param aad_size The size of the additional authenticated data.
+ * @param encrypted The encrypted message.
+ * @param message The decrypted message of message_size bytes.
+ * @param message_size The size of the message.
+ * @param auth_tag The auth tag of 16 bytes.
+ *
+ * @return Returns ESP_ERR_INVALID_MAC, if the auth tag does not match.
+ */
+esp_err_t hk_chacha20poly1305_native_decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aad_size,
+                                             const uint8_t *encrypted, uint8_t *message, size_t message_size, const uint8_t *auth_tag);
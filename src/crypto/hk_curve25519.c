@@ -38,24 +38,37 @@ esp_err_t hk_curve25519_update_from_public_key(hk_mem *public_key, hk_curve25519
 
 esp_err_t hk_curve25519_calculate_shared_secret(hk_curve25519_key_t *key1, hk_curve25519_key_t *key2, hk_mem *shared_secret)
 {
-    hk_mem_set(shared_secret, CURVE25519_KEYSIZE);
+    hk_mem_set(shared_secret, HK_CURVE25519_KEY_SIZE);
 
+    return hk_curve25519_calculate_shared_secret_to_buffer(key1, key2, shared_secret->ptr);
+}
+
+esp_err_t hk_curve25519_calculate_shared_secret_to_buffer(hk_curve25519_key_t *key1, hk_curve25519_key_t *key2, char *shared_secret)
+{
+    word32 size = HK_CURVE25519_KEY_SIZE;
     int ret = 0;
     HK_CRYPTO_RUN_AND_CHECK(ret, wc_curve25519_shared_secret_ex,
                             (curve25519_key *)key1->internal,
                             (curve25519_key *)key2->internal,
-                            (byte *)shared_secret->ptr, &shared_secret->size, EC25519_LITTLE_ENDIAN);
+                            (byte *)shared_secret, &size, EC25519_LITTLE_ENDIAN);
 
     return ret ? ESP_FAIL : ESP_OK;
 }
 
 esp_err_t hk_curve25519_export_public_key(hk_curve25519_key_t *key, hk_mem *public_key)
 {
-    hk_mem_set(public_key, CURVE25519_KEYSIZE);
+    hk_mem_set(public_key, HK_CURVE25519_KEY_SIZE);
+
+    return hk_curve25519_export_public_key_to_buffer(key, public_key->ptr);
+}
+
+esp_err_t hk_curve25519_export_public_key_to_buffer(hk_curve25519_key_t *key, char *public_key)
+{
+    word32 size = HK_CURVE25519_KEY_SIZE;
     int ret = 0;
     HK_CRYPTO_RUN_AND_CHECK(ret, wc_curve25519_export_public_ex,
         (curve25519_key *)key->internal,
-        (byte *)public_key->ptr, &public_key->size,
+        (byte *)public_key, &size,
         EC25519_LITTLE_ENDIAN);
 
     return ret ? ESP_FAIL : ESP_OK;
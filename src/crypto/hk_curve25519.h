@@ -10,6 +10,8 @@
 
 #include "../include/hk_mem.h"
 
+#define HK_CURVE25519_KEY_SIZE 32
+
 /**
  * @brief Typedef for a curve25519 key.
  */
@@ -62,6 +64,19 @@ esp_err_t hk_curve25519_update_from_public_key(hk_mem *public_key, hk_curve25519
  */
 esp_err_t hk_curve25519_export_public_key(hk_curve25519_key_t *key, hk_mem *public_key);
 
+/**
+ * @brief Exports the public key into a buffer.
+ *
+ * Exports the public key into a buffer of HK_CURVE25519_KEY_SIZE bytes, like a key of a struct, which must not be
+ * resized.
+ *
+ * @param key The encryption key.
+ * @param public_key The buffer of the public key.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_curve25519_export_public_key_to_buffer(hk_curve25519_key_t *key, char *public_key);
+
 /**
  * @brief Calculates the shared secret.
  *
@@ -75,6 +90,20 @@ esp_err_t hk_curve25519_export_public_key(hk_curve25519_key_t *key, hk_mem *publ
  */
 esp_err_t hk_curve25519_calculate_shared_secret(hk_curve25519_key_t *key1, hk_curve25519_key_t *key2, hk_mem *shared_secret);
 
+/**
+ * @brief Calculates the shared secret into a buffer.
+ *
+ * Calculates the shared secret into a buffer of HK_CURVE25519_KEY_SIZE bytes, like a key of a struct, which must not
+ * be resized.
+ *
+ * @param key1 The first key.
+ * @param key2 The second key.
+ * @param shared_secret The buffer of the shared secret.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_curve25519_calculate_shared_secret_to_buffer(hk_curve25519_key_t *key1, hk_curve25519_key_t *key2, char *shared_secret);
+
 /**
  * @brief Frees the ressources used by the key.
  *
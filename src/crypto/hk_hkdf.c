@@ -29,7 +29,16 @@ esp_err_t static hk_hkdf_internal(
 
 esp_err_t hk_hkdf(hk_mem *key_in, hk_mem *key_out, const char* salt, const char* info)
 {
-    return hk_hkdf_with_given_size(key_in, key_out, 32, salt, info);
+    return hk_hkdf_with_given_size(key_in, key_out, HK_HKDF_KEY_SIZE, salt, info);
+}
+
+esp_err_t hk_hkdf_to_buffer(hk_mem *key_in, char *key_out, const char* salt, const char* info)
+{
+    return hk_hkdf_internal(
+        key_in->ptr, key_in->size,
+        key_out, HK_HKDF_KEY_SIZE,
+        (char*)salt, strlen(salt),
+        info, strlen(info));
 }
 
 esp_err_t hk_hkdf_with_given_size(hk_mem *key_in, hk_mem *key_out, size_t size, const char* salt, const char* info)
@@ -45,11 +54,16 @@ esp_err_t hk_hkdf_with_given_size(hk_mem *key_in, hk_mem *key_out, size_t size,
 
 esp_err_t hk_hkdf_with_external_salt(hk_mem *key_in, hk_mem *key_out, hk_mem *salt, const char* info)
 {
-    hk_mem_set(key_out, 32);
+    hk_mem_set(key_out, HK_HKDF_KEY_SIZE);
     
+    return hk_hkdf_with_external_salt_to_buffer(key_in, key_out->ptr, salt, info);
+}
+
+esp_err_t hk_hkdf_with_external_salt_to_buffer(hk_mem *key_in, char *key_out, hk_mem *salt, const char* info)
+{
     return hk_hkdf_internal(
         key_in->ptr, key_in->size,
-        key_out->ptr, key_out->size,
+        key_out, HK_HKDF_KEY_SIZE,
         salt->ptr, salt->size,
         info, strlen(info));
 }
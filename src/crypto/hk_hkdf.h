@@ -30,6 +30,8 @@
 #define HK_HKDF_CONTROL_WRITE_INFO "Control-Write-Encryption-Key"
 #define HK_HKDF_BROADCAST_ENCRYPTION_KEY_INFO "Broadcast-Encryption-Key"
 
+#define HK_HKDF_KEY_SIZE 32
+
 /**
  * @brief Creates key.
  *
@@ -44,6 +46,20 @@
  */
 esp_err_t hk_hkdf(hk_mem *key_in, hk_mem* key_out, const char* salt, const char* info);
 
+/**
+ * @brief Creates key into a buffer.
+ *
+ * Creates key into a buffer of HK_HKDF_KEY_SIZE bytes, like a key of a struct, which must not be resized.
+ * 
+ * @param key_in The key to crypt.
+ * @param key_out The buffer of the created key.
+ * @param salt The salt.
+ * @param info The info.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_hkdf_to_buffer(hk_mem *key_in, char *key_out, const char* salt, const char* info);
+
 /**
  * @brief Creates key.
  *
@@ -71,4 +87,18 @@ esp_err_t hk_hkdf_with_given_size(hk_mem *key_in, hk_mem* key_out, size_t size,
  * 
  * @return Returns an esp_err_t result.
  */
-esp_err_t hk_hkdf_with_external_salt(hk_mem *key_in, hk_mem *key_out, hk_mem *salt, const char* info);
\ No newline at end of file
+esp_err_t hk_hkdf_with_external_salt(hk_mem *key_in, hk_mem *key_out, hk_mem *salt, const char* info);
+
+/**
+ * @brief Creates key into a buffer.
+ *
+ * Creates key into a buffer of HK_HKDF_KEY_SIZE bytes, like a key of a struct, which must not be resized.
+ * 
+ * @param key_in The key to crypt.
+ * @param key_out The buffer of the created key.
+ * @param salt The salt.
+ * @param info The info.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_hkdf_with_external_salt_to_buffer(hk_mem *key_in, char *key_out, hk_mem *salt, const char* info);
\ No newline at end of file
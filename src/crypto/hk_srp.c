@@ -1,6 +1,7 @@
 #include "hk_srp.h"
 #include "hk_crypto_util.h"
 #include "../utils/hk_logging.h"
+#include "../utils/hk_alloc.h"
 
 #define WOLFSSL_USER_SETTINGS
 #include <wolfssl/wolfcrypt/settings.h>
@@ -48,7 +49,8 @@ const byte hk_srp_g[] = {0x05};
 hk_srp_key_t *hk_srp_init_key()
 {
     hk_srp_key_t *key = malloc(sizeof(hk_srp_key_t));
-    key->internal = malloc(sizeof(Srp));
+    // the srp state holds several large numbers and is only used during pair setup
+    key->internal = hk_alloc_malloc(HK_ALLOC_PAIRING, sizeof(Srp));
 
     return key;
 }
@@ -63,7 +65,7 @@ esp_err_t hk_srp_generate_key(hk_srp_key_t *key, const char *username, const cha
 {
     byte salt[16];
     size_t verifierLen = 1024;
-    byte *verifier = malloc(verifierLen);
+    byte *verifier = hk_alloc_malloc(HK_ALLOC_PAIRING, verifierLen);
     int ret = 0;
 
     hk_random_fill(salt, sizeof(salt));
@@ -83,7 +85,7 @@ esp_err_t hk_srp_generate_key(hk_srp_key_t *key, const char *username, const cha
 
     HK_CRYPTO_RUN_AND_CHECK(ret, wc_SrpSetVerifier, (Srp *)key->internal, verifier, verifierLen);
 
-    free(verifier);
+    hk_alloc_free(HK_ALLOC_PAIRING, verifier);
 
     return ret ? ESP_FAIL : ESP_OK;
 }
@@ -178,7 +180,7 @@ void hk_srp_free_key(hk_srp_key_t *key)
     if (key->internal != NULL)
     {
         wc_SrpTerm((Srp *)key->internal);
-        free(key->internal);
+        hk_alloc_free(HK_ALLOC_PAIRING, key->internal);
         key->internal = NULL;
     }
 
@@ -62,6 +62,8 @@ esp_err_t hk_setup_add_srv(hk_srv_types_t srv_type, bool primary, bool hidden);
  * @brief Add a characteristic
  *
  * Adds a characteristic. It defines the features of your device.
+ * Values are exchanged in the binary representation of the characteristic format, with its exact width
+ * (e.g. one byte for bool and uint8, four bytes for int and float). Strings are not null terminated.
  *
  * @param chr_type The type of the characteristic.
  * @param read The function called if the characteristic is read. NULL if characteristec cannot be read.
@@ -71,6 +73,20 @@ esp_err_t hk_setup_add_srv(hk_srv_types_t srv_type, bool primary, bool hidden);
  */
 esp_err_t hk_setup_add_chr(hk_chr_types_t chr_type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write)(hk_mem* request), bool can_notify, void **chr_ptr);
 
+/**
+ * @brief Add a characteristic with write response
+ *
+ * Adds a characteristic, whose write function can return a value. If a controller requests a write response,
+ * the value is sent back with the write. If no value is returned, the current value is read and sent instead.
+ *
+ * @param chr_type The type of the characteristic.
+ * @param read The function called if the characteristic is read. NULL if characteristec cannot be read.
+ * @param write_with_response The function called if the characteristic is written. The response can be filled with the resulting value.
+ * @param can_notify True if the property can notify homekit for changes.
+ * @param chr_ptr A pointer to the characteristic.
+ */
+esp_err_t hk_setup_add_chr_with_response(hk_chr_types_t chr_type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write_with_response)(hk_mem* request, hk_mem* response), bool can_notify, void **chr_ptr);
+
 /**
  * @brief Finish setup
  *
@@ -85,11 +101,67 @@ esp_err_t hk_setup_finish();
  */
 esp_err_t hk_reset();
 
+/**
+ * @brief Start changing the accessories at runtime
+ *
+ * Starts a reconfiguration of the running device. Afterwards accessories, services and characteristics can be added
+ * with the hk_setup_add_* functions and removed with hk_reconfigure_remove_*. Services are added to the accessory added last,
+ * characteristics to the service added last, which can be an existing one. Existing accessories, services and characteristics keep their ids.
+ * Not supported by the bluetooth stack.
+ */
+esp_err_t hk_reconfigure_start();
+
+/**
+ * @brief Remove an accessory at runtime
+ *
+ * Removes the accessory, which contains the given characteristic. Has to be called between hk_reconfigure_start and hk_reconfigure_finish.
+ * 
+ * @param chr_ptr A characteristic handle of the accessory, returned by hk_setup_add_chr;
+ * 
+ * @return Returns ESP_ERR_NOT_FOUND, if no accessory contains the characteristic.
+ */
+esp_err_t hk_reconfigure_remove_accessory(void *chr_ptr);
+
+/**
+ * @brief Remove a service at runtime
+ *
+ * Removes the service, which contains the given characteristic. Has to be called between hk_reconfigure_start and hk_reconfigure_finish.
+ * 
+ * @param chr_ptr A characteristic handle of the service, returned by hk_setup_add_chr;
+ * 
+ * @return Returns ESP_ERR_NOT_FOUND, if no service contains the characteristic.
+ */
+esp_err_t hk_reconfigure_remove_srv(void *chr_ptr);
+
+/**
+ * @brief Finish changing the accessories at runtime
+ *
+ * Publishes the changed accessories and announces the new configuration number, so controllers reload the accessories.
+ * Connected controllers stay connected. Handles of removed characteristics must not be used afterwards.
+ * Waits until no task reads the accessories anymore. So it can be called from write callbacks, but must not be
+ * called from read callbacks, which are called while the accessories are read.
+ */
+esp_err_t hk_reconfigure_finish();
+
 /**
  * @brief Notify homekit that a property has changed
  *
  * Calling this method triggers homekit to read a new value and notify all listening devices.
+ * It can be called from any task and never blocks, as the notification is queued and sent by the homekit core task.
  * 
  * @param chr_ptr The characteristic handle, returned by hk_setup_add_chr;
+ * 
+ * @return Returns ESP_ERR_NO_MEM, if too many notifications are pending.
+ */
+esp_err_t hk_notify(void *chr_ptr);
+
+/**
+ * @brief Notify homekit from an interrupt that a property has changed
+ *
+ * Same as hk_notify, but safe to be called from an interrupt service routine.
+ * 
+ * @param chr_ptr The characteristic handle, returned by hk_setup_add_chr;
+ * 
+ * @return Returns ESP_ERR_NO_MEM, if too many notifications are pending.
  */
-esp_err_t hk_notify(void *chr_ptr);
\ No newline at end of file
+esp_err_t hk_notify_from_isr(void *chr_ptr);
\ No newline at end of file
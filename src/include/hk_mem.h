@@ -7,6 +7,7 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 /**
@@ -18,6 +19,7 @@ typedef struct
 {
     size_t size;
     char *ptr;
+    uint8_t subsystem; // the hk_alloc_subsystem_t, which allocates ptr; 0 is the default heap
 } hk_mem;
 
 /**
@@ -29,6 +31,18 @@ typedef struct
  */
 hk_mem *hk_mem_init();
 
+/**
+ * @brief Allocate memory for a subsystem
+ *
+ * This will allocate a new memory, whose data is allocated in the heap region of the subsystem (see hk_alloc.h).
+ * Use it for large buffers, which can be placed in SPIRAM.
+ *
+ * @param subsystem The hk_alloc_subsystem_t of the data.
+ *
+ * @return Returns a pointer to the allocated memory.
+ */
+hk_mem *hk_mem_init_for(uint8_t subsystem);
+
 /**
  * @brief Appends memory
  *
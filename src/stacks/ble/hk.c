@@ -1,18 +1,22 @@
 #include "../../utils/hk_logging.h"
 #include "../../include/hk.h"
 #include "../../utils/hk_store.h"
+#include "../../utils/hk_recorder.h"
 #include "../../utils/hk_util.h"
 #include "../../common/hk_accessory_id.h"
 #include "../../common/hk_pairings_store.h"
+#include "../../common/hk_pair_limiter.h"
 #include "../../common/hk_global_state.h"
 #include "../../common/hk_code_store.h"
+#include "../../common/hk_core.h"
+#include "../../common/hk_boot.h"
+#include "../../common/hk_configuration.h"
 #include "hk_nimble.h"
 #include "hk_gatt.h"
+#include "hk_chr.h"
 #include "hk_gap.h"
 #include "hk_pairing_ble.h"
 
-#define HK_STORE_REVISION "hk_rvsn"
-
 void (*hk_identify_callback)();
 
 esp_err_t hk_read_protocol_information_version(hk_mem *response)
@@ -43,16 +47,41 @@ esp_err_t hk_write_chr_signature(hk_mem *response)
     return ESP_ERR_NOT_SUPPORTED;
 }
 
+static void hk_handle_core_event(hk_core_event_t *event)
+{
+    if (event->type == HK_CORE_EVENT_NOTIFY)
+    {
+        hk_gatt_indicate(event->chr);
+    }
+}
+
+static void hk_log_devices()
+{
+    hk_pairings_log_devices();
+}
+
 esp_err_t hk_init(const char *name, const hk_categories_t category, const char *code)
 {
+    hk_boot_mark(HK_BOOT_PHASE_INIT);
     hk_code = code;
-    hk_global_state_init();
+#ifdef CONFIG_ESP32_HAP_RECORDER
+    hk_recorder_init(CONFIG_ESP32_HAP_RECORDER_SIZE);
+#endif
+
+    // the global state is read and written in the store, while the tasks start and the controller is initialized
+    hk_boot_run(hk_global_state_init);
+    hk_boot_defer(hk_log_devices);
+    hk_core_init(hk_handle_core_event);
+    hk_pairing_ble_init();
+    hk_boot_mark(HK_BOOT_PHASE_CORE);
     hk_nimble_init();
-    hk_gap_init(name, category, 2);
+    hk_boot_join();
+
+    hk_gap_init(name, category, hk_configuration_get());
     hk_gatt_start();
     hk_nimble_start();
+    hk_boot_mark(HK_BOOT_PHASE_STACK);
 
-    hk_pairings_log_devices();
     ESP_LOGD("homekit", "Started.");
 
     return ESP_OK;
@@ -61,73 +90,16 @@ esp_err_t hk_init(const char *name, const hk_categories_t category, const char *
 esp_err_t hk_setup_start()
 {
     hk_store_init();
+    hk_boot_mark(HK_BOOT_PHASE_STORE);
     hk_gatt_init();
 
     return ESP_OK;
 }
 
-esp_err_t hk_setup_update_configuration_counter(const char *revision)
-{
-    hk_mem* revision_stored = hk_mem_init();
-    esp_err_t ret = hk_store_blob_get(HK_STORE_REVISION, revision_stored);
-    
-    if (ret == ESP_ERR_NOT_FOUND) //ESP_ERR_NVS_NOT_FOUND
-    {
-        ret = ESP_OK;
-        HK_LOGD("Found no revision number. Setting configuration counter to 1.");
-        hk_mem_append_string(revision_stored, revision);
-        RUN_AND_CHECK(ret, hk_store_blob_set, HK_STORE_REVISION, revision_stored);
-        RUN_AND_CHECK(ret, hk_store_u8_set, HK_STORE_CONFIGURATION, 1);
-
-        hk_mem_free(revision_stored);
-        return ret;
-    }
-    else if (ret != ESP_OK)
-    {
-        HK_LOGE("Error updating configuration counter %x.", ret);
-        hk_mem_free(revision_stored);
-        return ret;
-    }
-
-    char* revision_stored_str = hk_mem_to_string(revision_stored);
-    HK_LOGD("Revision stored is '%s'. The new one is '%s'.", revision_stored_str, revision);
-    free(revision_stored_str);
-
-    uint8_t configuration_counter = 0;
-    if (!hk_mem_equal_str(revision_stored, revision))
-    {
-        HK_LOGD("Updating revision and counter.");
-        ret = hk_store_u8_get(HK_STORE_CONFIGURATION, &configuration_counter);
-
-        if (ret != ESP_OK)
-        {
-            HK_LOGW("Error getting configuration counter (%d). Setting counter to 0.", ret);
-            configuration_counter = 0;
-        }
-        else
-        {
-            configuration_counter++;
-        }
-
-        ret = ESP_OK;
-        HK_LOGI("Found new revision number (%s). Updating configuration counter to %d.", revision, configuration_counter);
-
-        hk_mem_set(revision_stored, 0);
-        hk_mem_append_string(revision_stored, revision);
-        RUN_AND_CHECK(ret, hk_store_blob_set, HK_STORE_REVISION, revision_stored);
-        RUN_AND_CHECK(ret, hk_store_u8_set, HK_STORE_CONFIGURATION, configuration_counter); 
-    }
-
-    hk_mem_free(revision_stored);
-
-    return ret;
-}
-
 esp_err_t hk_setup_add_accessory(const char *name, const char *manufacturer, const char *model, const char *serial_number, const char *revision, void (*identify)())
 {
     void *dummy_chr_ptr;
     hk_identify_callback = identify;
-    hk_setup_update_configuration_counter(revision);
 
     hk_gatt_add_srv(HK_SRV_ACCESSORY_INFORMATION, false, false, false);
 
@@ -163,25 +135,74 @@ esp_err_t hk_setup_add_chr(hk_chr_types_t type, esp_err_t(*read)(hk_mem *respons
     return hk_gatt_add_chr(type, read, write, NULL, can_notify, -1, -1, chr_ptr);
 }
 
+esp_err_t hk_setup_add_chr_with_response(hk_chr_types_t type, esp_err_t(*read)(hk_mem *response), esp_err_t(*write_with_response)(hk_mem *request, hk_mem *response), bool can_notify, void** chr_ptr)
+{
+    esp_err_t ret = hk_gatt_add_chr(type, read, NULL, NULL, can_notify, -1, -1, chr_ptr);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    if (*chr_ptr == NULL)
+    {
+        HK_LOGE("Could not add chr with response.");
+        return ESP_FAIL;
+    }
+
+    ((hk_chr_t *)*chr_ptr)->write_response_callback = write_with_response;
+
+    return ret;
+}
+
 esp_err_t hk_setup_finish()
 {
     hk_gatt_end_config();
+    hk_configuration_update(hk_gatt_hash());
     HK_LOGW("Set up.");
 
     return ESP_OK;
 }
 
+esp_err_t hk_reconfigure_start()
+{
+    // the gatt table of nimble cannot be changed while the stack is running
+    HK_LOGE("Reconfiguring at runtime is not supported by the bluetooth stack.");
+
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t hk_reconfigure_remove_accessory(void *chr_ptr)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t hk_reconfigure_remove_srv(void *chr_ptr)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t hk_reconfigure_finish()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
 esp_err_t hk_reset()
 {
     HK_LOGW("Resetting homekit for this device.");
     hk_accessory_id_reset();
     hk_global_state_reset();
     hk_pairings_store_remove_all();
+    hk_pair_limiter_reset();
 
     return ESP_OK;
 }
 
 esp_err_t hk_notify(void *chr)
 {
-    return hk_gatt_indicate(chr);
+    return hk_core_post(HK_CORE_EVENT_NOTIFY, chr, -1);
+}
+
+esp_err_t hk_notify_from_isr(void *chr)
+{
+    return hk_core_post_from_isr(HK_CORE_EVENT_NOTIFY, chr, -1);
 }
\ No newline at end of file
@@ -19,6 +19,7 @@ hk_chr_t *hk_chr_init(hk_chr_types_t chr_type, hk_chr_setup_info_t *setup_info)
     chr->read_callback = NULL;
     chr->write_callback = NULL;
     chr->write_with_response_callback = NULL;
+    chr->write_response_callback = NULL;
 
     return chr;
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ typedef struct
     esp_err_t (*read_callback)(hk_mem* response);
     esp_err_t (*write_callback)(hk_mem* request);
     esp_err_t (*write_with_response_callback)(hk_connection_t *connection, hk_mem *request, hk_mem *response);
+    esp_err_t (*write_response_callback)(hk_mem *request, hk_mem *response);
     char srv_index;
     char srv_id;
     bool srv_primary;
@@ -5,7 +5,9 @@
 
 #include "../../utils/hk_ll.h"
 #include "../../utils/hk_logging.h"
+#include "../../utils/hk_alloc.h"
 #include "hk_uuids.h"
+#include "hk_pairing_ble.h"
 
 hk_connection_t *hk_connection_connections = NULL;
 
@@ -46,9 +48,10 @@ hk_transaction_t *hk_connection_transaction_init(hk_connection_t *connection, ui
     transaction->request = hk_mem_init();
     transaction->expected_request_length = 0;
 
-    transaction->response = hk_mem_init();
+    transaction->response = hk_mem_init_for(HK_ALLOC_BLE);
     transaction->response_sent = 0;
     transaction->response_status = 0;
+    transaction->response_pending = false;
     transaction->start_time = esp_timer_get_time();
 
     return transaction;
@@ -83,6 +86,18 @@ hk_connection_t *hk_connection_get_all()
     return hk_connection_connections;
 }
 
+static uint32_t hk_connection_source(hk_mem *address)
+{
+    // pair verify is limited per peer, so the address is folded into the source with fnv-1a
+    uint32_t source = 2166136261u;
+    for (size_t i = 0; i < address->size; i++)
+    {
+        source = (source ^ (uint8_t)address->ptr[i]) * 16777619u;
+    }
+
+    return source;
+}
+
 hk_connection_t *hk_connection_init(uint16_t handle, hk_mem *address)
 {
     HK_LOGD("%d - Adding new connection (%s).", handle, address->ptr);
@@ -91,11 +106,14 @@ hk_connection_t *hk_connection_init(uint16_t handle, hk_mem *address)
 
     connection->handle = handle;
     connection->is_secure = false;
+    connection->pairing_pending = false;
     connection->global_state_was_changed_once = false;
     connection->received_frame_count = 0;
     connection->sent_frame_count = 0;
     connection->security_keys = hk_conn_key_store_init();
+    connection->security_keys->source = hk_connection_source(address);
     connection->transactions = NULL;
+    connection->subscriptions = NULL;
     connection->mtu_size = (uint8_t)256;
     connection->device_id = hk_mem_init();
 
@@ -109,6 +127,46 @@ void hk_connection_mtu_set(uint16_t handle, uint16_t mtu_size)
     connection->mtu_size = mtu_size;
 }
 
+bool hk_connection_is_subscribed(hk_connection_t *connection, uint16_t attr_handle)
+{
+    hk_ll_foreach(connection->subscriptions, subscription)
+    {
+        if (*subscription == attr_handle)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void hk_connection_subscription_set(uint16_t handle, uint16_t attr_handle, bool is_subscribed)
+{
+    hk_connection_t *connection = hk_connection_get_by_handle(handle);
+    if (connection == NULL)
+    {
+        return;
+    }
+
+    HK_LOGV("%d - Setting subscription of %d to %d.", handle, attr_handle, is_subscribed);
+    if (is_subscribed && !hk_connection_is_subscribed(connection, attr_handle))
+    {
+        connection->subscriptions = hk_ll_init(connection->subscriptions);
+        *connection->subscriptions = attr_handle;
+    }
+    else if (!is_subscribed)
+    {
+        hk_ll_foreach(connection->subscriptions, subscription)
+        {
+            if (*subscription == attr_handle)
+            {
+                connection->subscriptions = hk_ll_remove(connection->subscriptions, subscription);
+                hk_ll_break();
+            }
+        }
+    }
+}
+
 void hk_connection_free(uint16_t handle)
 {
     HK_LOGV("%d - Removing connection from %d connections.", handle, hk_ll_count(hk_connection_connections));
@@ -120,11 +178,16 @@ void hk_connection_free(uint16_t handle)
     }
 
     hk_ll_free(connection->transactions);
+    hk_ll_free(connection->subscriptions);
 
-    connection->handle = -1;
-    hk_conn_key_store_free(connection->security_keys);
+    // a running pairing step takes over the keys and frees them when it is done
+    if (!hk_pairing_ble_orphan(handle))
+    {
+        hk_conn_key_store_free(connection->security_keys);
+        hk_mem_free(connection->device_id);
+    }
 
+    connection->handle = -1;
     hk_connection_connections = hk_ll_remove(hk_connection_connections, connection);
-    hk_mem_free(connection->device_id);
     HK_LOGD("%d - Connection closed.", handle);
 }
\ No newline at end of file
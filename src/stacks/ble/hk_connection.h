@@ -17,6 +17,7 @@ typedef struct
     hk_mem *response;
     uint16_t response_sent;
     uint8_t response_status;
+    bool response_pending; // the response is completed asynchronously
     uint64_t start_time;
 } hk_transaction_t;
 
@@ -25,11 +26,13 @@ typedef struct
     uint16_t handle; // the handle used by nimble
     hk_conn_key_store_t *security_keys;
     bool is_secure;
+    bool pairing_pending; // a pairing step is running on the pairing task
     bool global_state_was_changed_once;
     uint32_t received_frame_count;
     uint32_t sent_frame_count;
     hk_mem *device_id;
     hk_transaction_t *transactions;
+    uint16_t *subscriptions; // attribute handles, for which the controller enabled indications
     uint16_t mtu_size;
 } hk_connection_t;
 
@@ -41,4 +44,6 @@ hk_connection_t *hk_connection_init(uint16_t handle, hk_mem *address);
 hk_connection_t *hk_connection_get_all();
 hk_connection_t *hk_connection_get_by_handle(uint16_t handle);
 void hk_connection_mtu_set(uint16_t handle, uint16_t mtu_size);
+void hk_connection_subscription_set(uint16_t handle, uint16_t attr_handle, bool is_subscribed);
+bool hk_connection_is_subscribed(hk_connection_t *connection, uint16_t attr_handle);
 void hk_connection_free(uint16_t handle);
\ No newline at end of file
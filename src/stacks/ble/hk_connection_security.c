@@ -15,7 +15,7 @@ esp_err_t hk_connection_security_decrypt(hk_connection_t *connection, hk_mem *in
     size_t message_size = in->size - HK_AUTHTAG_SIZE;
     hk_mem_set(out, message_size);
     esp_err_t ret = hk_chacha20poly1305_decrypt_buffer(
-        connection->security_keys->request_key, nonce,
+        HK_CONN_KEY_STORE_MEM(connection->security_keys->request_key), nonce,
         NULL, 0,
         (char *)in->ptr, (char *)out->ptr, message_size);
 
@@ -33,7 +33,7 @@ esp_err_t hk_connection_security_encrypt(hk_connection_t *connection, hk_mem *in
     nonce[5] = connection->sent_frame_count++ / 256;
 
     esp_err_t ret = hk_chacha20poly1305_encrypt_buffer(
-        connection->security_keys->response_key, nonce,
+        HK_CONN_KEY_STORE_MEM(connection->security_keys->response_key), nonce,
         NULL, 0,
         in->ptr, out->ptr, in->size);
 
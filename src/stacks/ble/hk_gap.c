@@ -8,6 +8,8 @@
 #include "../../common/hk_accessory_id.h"
 #include "../../common/hk_pairings_store.h"
 #include "../../common/hk_global_state.h"
+#include "../../common/hk_configuration.h"
+#include "../../common/hk_boot.h"
 #include "../../crypto/hk_chacha20poly1305.h"
 
 #include "hk_connection_security.h"
@@ -103,6 +105,14 @@ static int hk_gap_gap_event(struct ble_gap_event *event, void *arg)
                 event->subscribe.cur_notify,
                 event->subscribe.prev_indicate,
                 event->subscribe.cur_indicate);
+
+        // on termination the connection is removed anyway
+        if (event->subscribe.reason != BLE_GAP_SUBSCRIBE_REASON_TERM)
+        {
+            hk_connection_subscription_set(event->subscribe.conn_handle, event->subscribe.attr_handle,
+                                           event->subscribe.cur_indicate || event->subscribe.cur_notify);
+        }
+
         rc = 0;
         break;
     case BLE_GAP_EVENT_MTU:
@@ -216,8 +226,7 @@ esp_err_t hk_gap_start_advertising()
     uint8_t type = 0x06;
     uint8_t stl = 0x2d;
     uint8_t sf = has_pairing ? 0x00 : 0x01;
-    uint8_t configuration = 0;
-    RUN_AND_CHECK(ret, hk_store_u8_get, HK_STORE_CONFIGURATION, &configuration);
+    uint8_t configuration = hk_configuration_get_u8();
     uint8_t ble = 0x02;
     hk_accessory_id_get(accessory_id);
 
@@ -233,6 +242,11 @@ esp_err_t hk_gap_start_advertising()
 
     RUN_AND_CHECK(ret, hk_gap_start_advertising_internal, manufacturer_data, true);
 
+    if (ret == ESP_OK)
+    {
+        hk_boot_mark(HK_BOOT_PHASE_DISCOVERABLE);
+    }
+
     hk_mem_free(accessory_id);
     hk_mem_free(manufacturer_data);
 
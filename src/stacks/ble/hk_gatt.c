@@ -5,9 +5,12 @@
 #include <services/gap/ble_svc_gap.h>
 #include <services/gatt/ble_svc_gatt.h>
 #include <host/ble_hs.h>
+#include <nimble/nimble_port.h>
 
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_ll.h"
+#include "../../utils/hk_rcu.h"
+#include "../../utils/hk_recorder.h"
 
 #include "hk_chr.h"
 #include "hk_uuids.h"
@@ -25,34 +28,34 @@
 #include "../../crypto/hk_chacha20poly1305.h"
 #include "../../common/hk_global_state.h"
 #include "../../common/hk_pairings_store.h"
+#include "../../common/hk_configuration.h"
 
 typedef struct ble_gatt_svc_def hk_ble_srv_t;
 typedef struct ble_gatt_chr_def hk_ble_chr_t;
 typedef struct ble_gatt_dsc_def hk_ble_descriptor_t;
 
 hk_chr_setup_info_t *hk_gatt_setup_info = NULL;
+// the services under construction, which are only visible to readers after being published
 hk_ble_srv_t *hk_gatt_srvs = NULL;
+hk_rcu_t hk_gatt_srvs_rcu;
 uint8_t last_transaction_id;
 
 
-esp_err_t hk_gatt_indicate(void *hk_chr_void)
+typedef struct
 {
-    if (hk_chr_void == NULL)
-    {
-        return ESP_FAIL;
-    }
+    struct ble_npl_event event; // indicates on the nimble host task
+    hk_chr_t *chr;
+} hk_gatt_indication_t;
+
+// Runs on the nimble host task, which owns the connections and their subscriptions.
+static void hk_gatt_indicate_on_host(struct ble_npl_event *event)
+{
+    hk_gatt_indication_t *indication = (hk_gatt_indication_t *)ble_npl_event_get_arg(event);
+    hk_chr_t *chr = indication->chr;
+    free(indication);
 
     int ble_ret = 0;
     esp_err_t ret = ESP_OK;
-    bool has_pairing = false;
-
-    ret = hk_pairings_store_has_pairing(&has_pairing);
-    if (ret != ESP_OK || !has_pairing)
-    {
-        return ESP_OK;
-    }
-
-    hk_chr_t *chr = (hk_chr_t *)hk_chr_void;
 
     hk_connection_t *connections = hk_connection_get_all();
     if (connections != NULL)
@@ -60,34 +63,29 @@ esp_err_t hk_gatt_indicate(void *hk_chr_void)
         HK_LOGD("Starting notify event.");
         uint16_t chr_val_handle = 0;
         ble_ret = ble_gatts_find_chr(BLE_UUID(chr->srv_uuid), BLE_UUID(chr->uuid), NULL, &chr_val_handle);
+        if (ble_ret)
+        {
+            HK_LOGE("Characteristic to indicate was not found.");
+        }
 
         hk_ll_foreach(connections, connection)
         {
-            // caching the values of the connection, to minimize the chance the pointer of the connection
-            // gets invalid, due to disconnect. 
-            bool is_secure = connection->is_secure;
-            bool global_state_was_changed_once = connection->global_state_was_changed_once;
-            bool handle = connection->handle;
-
-            if (is_secure)
+            if (connection->is_secure)
             {
-                if (!global_state_was_changed_once)
+                if (!connection->global_state_was_changed_once)
                 {
-                    global_state_was_changed_once = true;
+                    connection->global_state_was_changed_once = true;
                     hk_global_state_next();
                 }
 
-                if (!ble_ret)
+                // only controllers, which enabled indications for the characteristic, are indicated
+                if (!ble_ret && hk_connection_is_subscribed(connection, chr_val_handle))
                 {
                     struct os_mbuf* om = ble_hs_mbuf_att_pkt();
-                    ble_ret = ble_gattc_indicate_custom(handle, chr_val_handle, om);
-                }
-
-                if (ble_ret)
-                {
-                    HK_LOGE("Error indicating during active connection.");
-                    // todo: break;
-                    ret = ESP_FAIL;
+                    if (ble_gattc_indicate_custom(connection->handle, chr_val_handle, om))
+                    {
+                        HK_LOGE("Error indicating during active connection.");
+                    }
                 }
             }
         }
@@ -109,8 +107,37 @@ esp_err_t hk_gatt_indicate(void *hk_chr_void)
     }
 
     // at the moment we do not need a disconnected event mode, as we are always notifying. It might be needed when introducing device sleep.
+}
+
+esp_err_t hk_gatt_indicate(void *hk_chr_void)
+{
+    if (hk_chr_void == NULL)
+    {
+        return ESP_FAIL;
+    }
 
-    return ret;
+    esp_err_t ret = ESP_OK;
+    bool has_pairing = false;
+
+    ret = hk_pairings_store_has_pairing(&has_pairing);
+    if (ret != ESP_OK || !has_pairing)
+    {
+        return ESP_OK;
+    }
+
+    // the connections are changed by the nimble host task, so they are only looked at there
+    hk_gatt_indication_t *indication = (hk_gatt_indication_t *)malloc(sizeof(hk_gatt_indication_t));
+    if (indication == NULL)
+    {
+        HK_LOGE("Could not allocate indication.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    indication->chr = (hk_chr_t *)hk_chr_void;
+    ble_npl_event_init(&indication->event, hk_gatt_indicate_on_host, indication);
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &indication->event);
+
+    return ESP_OK;
 }
 
 static int hk_gatt_read_ble_descriptor(struct ble_gatt_access_ctxt *ctxt, void *arg)
@@ -141,23 +168,29 @@ static int hk_gatt_read_ble_descriptor(struct ble_gatt_access_ctxt *ctxt, void *
 
 static int hk_gatt_decrypt(struct ble_gatt_access_ctxt *ctxt, const ble_uuid128_t *chr_uuid, hk_connection_t *connection, hk_mem *request)
 {
-    uint8_t buffer_len = OS_MBUF_PKTLEN(ctxt->om);
-    uint8_t buffer[buffer_len];
+    // the length is given by the controller, so the data is flattened into the heap instead of the stack
+    uint16_t buffer_len = OS_MBUF_PKTLEN(ctxt->om);
     uint16_t out_len = 0;
-    int rc = ble_hs_mbuf_to_flat(ctxt->om, buffer, buffer_len, &out_len);
+    int rc = 0;
     const ble_uuid128_t *chr_uuid_pair_verify = hk_uuids_get((uint8_t)HK_CHR_PAIR_VERIFY);
     if (connection->is_secure && !hk_uuids_cmp(chr_uuid, chr_uuid_pair_verify))
     {
         hk_mem *received_before_encryption = hk_mem_init();
-        hk_mem_append_buffer(received_before_encryption, buffer, out_len);
+        hk_mem_set(received_before_encryption, buffer_len);
+        rc = ble_hs_mbuf_to_flat(ctxt->om, received_before_encryption->ptr, buffer_len, &out_len);
+        hk_mem_set(received_before_encryption, out_len);
         hk_connection_security_decrypt(connection, received_before_encryption, request); 
         hk_mem_free(received_before_encryption);
     }
     else
     {
-        hk_mem_append_buffer(request, buffer, out_len);
+        size_t offset = request->size;
+        hk_mem_set(request, offset + buffer_len);
+        rc = ble_hs_mbuf_to_flat(ctxt->om, request->ptr + offset, buffer_len, &out_len);
+        hk_mem_set(request, offset + out_len);
     }
 
+    HK_RECORDER_RECORD(HK_RECORDER_BLE_REQUEST, connection->handle, request->ptr, request->size);
     return rc;
 }
 
@@ -165,6 +198,7 @@ static int hk_gatt_encrypt(struct ble_gatt_access_ctxt *ctxt, const ble_uuid128_
 {
     int rc;
     const ble_uuid128_t *chr_uuid_pair_verify = hk_uuids_get((uint8_t)HK_CHR_PAIR_VERIFY);
+    HK_RECORDER_RECORD(HK_RECORDER_BLE_RESPONSE, connection->handle, response->ptr, response->size);
     if (connection->is_secure && !hk_uuids_cmp(chr_uuid, chr_uuid_pair_verify))
     {
         HK_LOGV("Encrypting response");
@@ -309,9 +343,18 @@ static int hk_gatt_read_ble_chr(uint16_t handle, struct ble_gatt_access_ctxt *ct
         hk_transaction_t *transaction = hk_connection_transaction_get_by_uuid(connection, chr_uuid);
         if (transaction == NULL)
         {
+            hk_mem_free(response);
             return BLE_ATT_ERR_UNLIKELY;
         }
 
+        if (transaction->response_pending)
+        {
+            // the controller retries the read, until the pairing task completed the response
+            HK_LOGD("%d - Response is not ready yet.", handle);
+            hk_mem_free(response);
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+
         bool continuation = transaction->response_sent > 0;
         bool has_body = transaction->response->size > 0;
         uint8_t control_field = continuation ? 0b10000010 : 0b00000010;
@@ -571,6 +614,54 @@ void hk_gatt_end_config()
     hk_gatt_alloc_new_srv();
 
     free(hk_gatt_setup_info);
+
+    // from now on the services are immutable
+    hk_rcu_publish(&hk_gatt_srvs_rcu, hk_gatt_srvs);
+}
+
+static void hk_gatt_hash_chr(uint32_t *hash, hk_ble_chr_t *ble_chr)
+{
+    hk_chr_t *chr = (hk_chr_t *)ble_chr->arg;
+    uint8_t features[] = {
+        chr->read_callback != NULL,
+        chr->write_callback != NULL,
+        chr->write_with_response_callback != NULL,
+        chr->write_response_callback != NULL,
+        chr->srv_primary,
+        chr->srv_hidden,
+        chr->srv_supports_configuration};
+
+    hk_configuration_hash_append(hash, BLE_UUID128(ble_chr->uuid)->value, 16);
+    hk_configuration_hash_append(hash, &ble_chr->flags, sizeof(ble_chr->flags));
+    hk_configuration_hash_append(hash, &chr->chr_index, sizeof(chr->chr_index));
+    hk_configuration_hash_append(hash, features, sizeof(features));
+    if (chr->static_data != NULL)
+    {
+        // e.g. the firmware revision
+        hk_configuration_hash_append(hash, chr->static_data, strlen(chr->static_data) + 1);
+    }
+}
+
+uint32_t hk_gatt_hash()
+{
+    uint32_t hash;
+    uint8_t reader;
+    hk_configuration_hash_init(&hash);
+    hk_ble_srv_t *srvs = (hk_ble_srv_t *)hk_rcu_read_lock(&hk_gatt_srvs_rcu, &reader);
+
+    // both arrays end with a zeroed element
+    for (hk_ble_srv_t *srv = srvs; srv != NULL && srv->type != 0; srv++)
+    {
+        hk_configuration_hash_append(&hash, BLE_UUID128(srv->uuid)->value, 16);
+        for (hk_ble_chr_t *ble_chr = (hk_ble_chr_t *)srv->characteristics; ble_chr->uuid != NULL; ble_chr++)
+        {
+            hk_gatt_hash_chr(&hash, ble_chr);
+        }
+    }
+
+    hk_rcu_read_unlock(&hk_gatt_srvs_rcu, reader);
+
+    return hash;
 }
 
 void hk_gatt_start()
@@ -578,16 +669,22 @@ void hk_gatt_start()
     HK_LOGD("Starting GATT.");
     ble_svc_gatt_init();
 
-    int rc = ble_gatts_count_cfg(hk_gatt_srvs);
+    // nimble keeps referencing the published version, it is replaced only by resetting the gatt server
+    uint8_t reader;
+    hk_ble_srv_t *srvs = (hk_ble_srv_t *)hk_rcu_read_lock(&hk_gatt_srvs_rcu, &reader);
+
+    int rc = ble_gatts_count_cfg(srvs);
     if (rc != 0)
     {
         HK_LOGE("Error initializing services: %d", rc);
         //return rc;
     }
 
-    rc = ble_gatts_add_svcs(hk_gatt_srvs);
+    rc = ble_gatts_add_svcs(srvs);
     if (rc != 0)
     {
         HK_LOGE("Error setting gatt config: %d", rc);
     }
+
+    hk_rcu_read_unlock(&hk_gatt_srvs_rcu, reader);
 }
\ No newline at end of file
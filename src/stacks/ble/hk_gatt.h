@@ -30,5 +30,6 @@ esp_err_t hk_gatt_add_chr(
     void** chr_ptr);
 void hk_gatt_add_chr_static_read(hk_chr_types_t type, const char *value);
 void hk_gatt_end_config();
+uint32_t hk_gatt_hash();
 void hk_gatt_start();
 esp_err_t hk_gatt_indicate(void *ble_chr);
\ No newline at end of file
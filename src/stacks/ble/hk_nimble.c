@@ -1,12 +1,15 @@
 #include "hk_nimble.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <nimble/nimble_port.h>
-#include <nimble/nimble_port_freertos.h>
 #include <esp_nimble_hci.h>
 #include <host/ble_hs.h>
 #include <host/util/util.h>
 
 #include "../../utils/hk_logging.h"
+#include "../../utils/hk_util.h"
+#include "../../utils/hk_tasks.h"
 
 #include "hk_gap.h"
 
@@ -51,7 +54,8 @@ void hk_nimble_host_task(void *param)
     /* This function will return only when nimble_port_stop() is executed */
     nimble_port_run();
     HK_LOGI("Nimble stopping.");
-    nimble_port_freertos_deinit();
+    hk_tasks_unregister(xTaskGetCurrentTaskHandle());
+    vTaskDelete(NULL);
 }
 
 void hk_nimble_init()
@@ -80,5 +84,14 @@ void hk_nimble_start()
 {
     HK_LOGD("Starting nimble.");
 
-    nimble_port_freertos_init(hk_nimble_host_task);
+    // the host task is created here instead of nimble_port_freertos_init, to configure its core and priority
+    TaskHandle_t task_handle = NULL;
+    if (xTaskCreatePinnedToCore(hk_nimble_host_task, "ble", HK_NIMBLE_HOST_TASK_STACK_SIZE, NULL, HK_NIMBLE_HOST_TASK_PRIORITY, &task_handle, HK_UTIL_TASK_CORE_ID(HK_NIMBLE_HOST_TASK_CORE_ID)) != pdPASS)
+    {
+        HK_LOGE("Could not create nimble host task.");
+    }
+    else
+    {
+        hk_tasks_register(task_handle, "ble", HK_NIMBLE_HOST_TASK_STACK_SIZE);
+    }
 }
\ No newline at end of file
@@ -1,4 +1,10 @@
 #pragma once
 
+#include <sdkconfig.h>
+
+#define HK_NIMBLE_HOST_TASK_STACK_SIZE CONFIG_BT_NIMBLE_HOST_TASK_STACK_SIZE
+#define HK_NIMBLE_HOST_TASK_PRIORITY CONFIG_ESP32_HAP_NIMBLE_HOST_TASK_PRIORITY
+#define HK_NIMBLE_HOST_TASK_CORE_ID CONFIG_ESP32_HAP_NIMBLE_HOST_TASK_CORE_ID
+
 void hk_nimble_init();
-void hk_nimble_start();
\ No newline at end of file
+void hk_nimble_start();
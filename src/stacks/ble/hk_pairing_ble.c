@@ -1,47 +1,259 @@
 #include "hk_pairing_ble.h"
 
 #include <esp_timer.h>
+#include <freertos/task.h>
+#include <nimble/nimble_port.h>
 
 #include "../../utils/hk_tlv.h"
+#include "../../utils/hk_ll.h"
+#include "../../utils/hk_queue.h"
+#include "../../utils/hk_tasks.h"
+#include "../../utils/hk_util.h"
 #include "../../include/hk_mem.h"
+#include "../../include/hk_chrs.h"
 #include "../../common/hk_pair_setup.h"
 #include "../../common/hk_pair_verify.h"
 #include "../../common/hk_pairings.h"
 #include "hk_connection_security.h"
+#include "hk_uuids.h"
 
 #include "../../utils/hk_logging.h"
 
-esp_err_t hk_pairing_ble_write_pair_setup(hk_connection_t *connection, hk_mem *request, hk_mem *response)
+typedef struct
 {
-    esp_err_t ret = ESP_OK;
-    int rc = hk_pair_setup(request, response, connection->security_keys);
-    if (rc != 0)
+    struct ble_npl_event event; // completes the job on the nimble host task
+    uint16_t handle;
+    uint8_t transaction_id;
+    const ble_uuid128_t *chr_uuid;
+    bool is_verify;
+    bool orphaned; // the connection was closed, the job owns keys and device id
+    hk_conn_key_store_t *keys;
+    hk_mem *device_id;
+    hk_mem *request;
+    hk_mem *response;
+    bool is_secure;
+    esp_err_t result;
+} hk_pairing_ble_job_t;
+
+hk_queue_t hk_pairing_ble_queue;
+TaskHandle_t hk_pairing_ble_task_handle = NULL;
+// jobs, which were not completed yet. Only used on the nimble host task.
+hk_pairing_ble_job_t **hk_pairing_ble_jobs = NULL;
+
+static void hk_pairing_ble_complete(struct ble_npl_event *event)
+{
+    hk_pairing_ble_job_t *job = (hk_pairing_ble_job_t *)ble_npl_event_get_arg(event);
+
+    hk_ll_foreach(hk_pairing_ble_jobs, pending_job)
     {
-        HK_LOGE("Error in pair setup: %d", ret);
-        ret = ESP_ERR_INVALID_ARG;
+        if (*pending_job == job)
+        {
+            hk_pairing_ble_jobs = hk_ll_remove(hk_pairing_ble_jobs, pending_job);
+            hk_ll_break();
+        }
     }
 
-    return ret;
+    hk_connection_t *connection = job->orphaned ? NULL : hk_connection_get_by_handle(job->handle);
+    if (connection == NULL)
+    {
+        HK_LOGD("%d - Discarding pairing response, as the connection was closed.", job->handle);
+        hk_conn_key_store_free(job->keys);
+        hk_mem_free(job->device_id);
+    }
+    else
+    {
+        hk_transaction_t *transaction = hk_connection_transaction_get_by_uuid(connection, job->chr_uuid);
+
+        if (transaction != NULL && transaction->id == job->transaction_id && transaction->response_pending)
+        {
+            if (job->response->size > 0)
+            {
+                hk_tlv_t *tlv_data_response = NULL;
+                tlv_data_response = hk_tlv_add_mem(tlv_data_response, 0x01, job->response);
+                hk_tlv_serialize(tlv_data_response, transaction->response);
+                hk_tlv_free(tlv_data_response);
+            }
+
+            transaction->response_status = job->result == ESP_OK ? 0x00 : 0x06;
+            transaction->response_pending = false;
+        }
+
+        if (job->is_verify)
+        {
+            connection->is_secure = job->is_secure;
+            if (job->is_secure)
+            {
+                HK_LOGD("Connection now is secure.");
+            }
+        }
+
+        connection->pairing_pending = false;
+    }
+
+    hk_mem_free(job->request);
+    hk_mem_free(job->response);
+    free(job);
 }
 
-esp_err_t hk_pairing_ble_write_pair_verify(hk_connection_t *connection, hk_mem *request, hk_mem *response)
+static void hk_pairing_ble_run(hk_pairing_ble_job_t *job)
 {
-    bool is_encrypted = false;
-    int res = hk_pair_verify(request, response, connection->security_keys, connection->device_id, &is_encrypted);
-    if (res != 0)
+    if (job->is_verify)
+    {
+        int res = hk_pair_verify(job->request, job->response, job->keys, job->device_id, &job->is_secure);
+        if (res != 0)
+        {
+            HK_LOGE("Error in pair verify: %d", res);
+        }
+
+        // errors of pair verify are part of the response
+        job->result = ESP_OK;
+    }
+    else
     {
-        HK_LOGE("Error in pair verify: %d", res);
+        int rc = hk_pair_setup(job->request, job->response, job->keys);
+        if (rc != 0)
+        {
+            HK_LOGE("Error in pair setup: %d", rc);
+            job->result = ESP_ERR_INVALID_ARG;
+        }
     }
+}
+
+static void hk_pairing_ble_task(void *arg)
+{
+    hk_pairing_ble_job_t *job;
 
-    connection->is_secure = is_encrypted;
-    if (is_encrypted)
+    while (true)
     {
-        HK_LOGD("Connection now is secure.");
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (hk_queue_pop(&hk_pairing_ble_queue, &job))
+        {
+            int64_t start_time = esp_timer_get_time();
+            hk_pairing_ble_run(job);
+            HK_LOGD("%d - Pairing step took %lld ms.", job->handle, (esp_timer_get_time() - start_time) / 1000);
+
+            ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &job->event);
+        }
     }
+}
+
+static esp_err_t hk_pairing_ble_submit(hk_connection_t *connection, bool is_verify, hk_chr_types_t chr_type, hk_mem *request)
+{
+    const ble_uuid128_t *chr_uuid = hk_uuids_get((uint8_t)chr_type);
+    hk_transaction_t *transaction = hk_connection_transaction_get_by_uuid(connection, chr_uuid);
+
+    if (transaction == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (connection->pairing_pending)
+    {
+        HK_LOGE("%d - Refusing pairing step, as the previous one is still running.", connection->handle);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    hk_pairing_ble_job_t *job = (hk_pairing_ble_job_t *)malloc(sizeof(hk_pairing_ble_job_t));
+    if (job == NULL)
+    {
+        HK_LOGE("%d - Could not allocate pairing job.", connection->handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ble_npl_event_init(&job->event, hk_pairing_ble_complete, job);
+    job->handle = connection->handle;
+    job->transaction_id = transaction->id;
+    job->chr_uuid = chr_uuid;
+    job->is_verify = is_verify;
+    job->orphaned = false;
+    job->keys = connection->security_keys;
+    job->device_id = connection->device_id;
+    job->request = hk_mem_init();
+    job->response = hk_mem_init();
+    job->is_secure = false;
+    job->result = ESP_OK;
+    hk_mem_set_mem(job->request, request);
+
+    if (!hk_queue_push(&hk_pairing_ble_queue, &job))
+    {
+        HK_LOGE("%d - Pairing queue is full.", connection->handle);
+        hk_mem_free(job->request);
+        hk_mem_free(job->response);
+        free(job);
+        return ESP_ERR_NO_MEM;
+    }
+
+    hk_pairing_ble_jobs = hk_ll_init(hk_pairing_ble_jobs);
+    *hk_pairing_ble_jobs = job;
+
+    // the keys are used by the worker until the job is completed
+    if (is_verify)
+    {
+        connection->is_secure = false;
+    }
+
+    connection->pairing_pending = true;
+    transaction->response_pending = true;
+    xTaskNotifyGive(hk_pairing_ble_task_handle);
 
     return ESP_OK;
 }
 
+esp_err_t hk_pairing_ble_init()
+{
+    esp_err_t ret = ESP_OK;
+
+    if (hk_pairing_ble_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    RUN_AND_CHECK(ret, hk_queue_init, &hk_pairing_ble_queue, sizeof(hk_pairing_ble_job_t *), HK_PAIRING_BLE_QUEUE_SIZE);
+
+    if (ret == ESP_OK && xTaskCreatePinnedToCore(hk_pairing_ble_task, "hk_pairing", HK_PAIRING_BLE_TASK_STACK_SIZE, NULL, HK_PAIRING_BLE_TASK_PRIORITY, &hk_pairing_ble_task_handle, HK_UTIL_TASK_CORE_ID(HK_PAIRING_BLE_TASK_CORE_ID)) != pdPASS)
+    {
+        HK_LOGE("Could not create pairing task.");
+        hk_queue_free(&hk_pairing_ble_queue);
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK)
+    {
+        hk_tasks_register(hk_pairing_ble_task_handle, "hk_pairing", HK_PAIRING_BLE_TASK_STACK_SIZE);
+    }
+
+    return ret;
+}
+
+bool hk_pairing_ble_orphan(uint16_t handle)
+{
+    bool orphaned = false;
+
+    hk_ll_foreach(hk_pairing_ble_jobs, pending_job)
+    {
+        if ((*pending_job)->handle == handle)
+        {
+            (*pending_job)->orphaned = true;
+            orphaned = true;
+        }
+    }
+
+    return orphaned;
+}
+
+esp_err_t hk_pairing_ble_write_pair_setup(hk_connection_t *connection, hk_mem *request, hk_mem *response)
+{
+    // the response is completed by the pairing task
+    return hk_pairing_ble_submit(connection, false, HK_CHR_PAIR_SETUP, request);
+}
+
+esp_err_t hk_pairing_ble_write_pair_verify(hk_connection_t *connection, hk_mem *request, hk_mem *response)
+{
+    // the response is completed by the pairing task
+    return hk_pairing_ble_submit(connection, true, HK_CHR_PAIR_VERIFY, request);
+}
+
 esp_err_t hk_pairing_ble_read_pairing_features(hk_mem *response)
 {
     const uint8_t hk_pairing_ble_features = 0; //zero because non mfi certified
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <sdkconfig.h>
 #include <freertos/FreeRTOS.h>
 #include "../include/hk_mem.h"
 #include "hk_connection.h"
 
+#define HK_PAIRING_BLE_QUEUE_SIZE 4
+#define HK_PAIRING_BLE_TASK_STACK_SIZE 8192
+#define HK_PAIRING_BLE_TASK_PRIORITY CONFIG_ESP32_HAP_PAIRING_TASK_PRIORITY
+#define HK_PAIRING_BLE_TASK_CORE_ID CONFIG_ESP32_HAP_PAIRING_TASK_CORE_ID
+
+esp_err_t hk_pairing_ble_init();
+bool hk_pairing_ble_orphan(uint16_t handle);
+
 esp_err_t hk_pairing_ble_write_pair_setup(hk_connection_t *connection, hk_mem* request, hk_mem* response);
 esp_err_t hk_pairing_ble_write_pair_verify(hk_connection_t *connection, hk_mem* request, hk_mem* response);
 esp_err_t hk_pairing_ble_read_pairing_features(hk_mem* response);
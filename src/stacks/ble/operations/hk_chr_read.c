@@ -3,6 +3,7 @@
 #include "../../../include/hk_mem.h"
 #include "../../../utils/hk_logging.h"
 #include "../../../utils/hk_tlv.h"
+#include "../../../common/hk_value.h"
 
 #include "../hk_formats_ble.h"
 
@@ -19,6 +20,11 @@ esp_err_t hk_chr_read(hk_transaction_t *transaction, hk_chr_t *chr)
     else
     {
         ret = chr->read_callback(read_response);
+        if (ret == ESP_OK)
+        {
+            // callbacks may return wider integers or doubles, bluetooth needs the exact width
+            ret = hk_value_normalize(hk_chrs_properties_get_type(chr->chr_type), read_response);
+        }
     }
 
     HK_LOGD("Characteristic read returned %d response size %u", ret, read_response->size);
@@ -4,6 +4,7 @@
 
 #include "../../../utils/hk_logging.h"
 #include "../../../utils/hk_tlv.h"
+#include "../../../common/hk_value.h"
 
 #include "../hk_formats_ble.h"
 
@@ -23,6 +24,11 @@ esp_err_t hk_chr_timed_write(hk_transaction_t *transaction, hk_chr_t *chr)
         HK_LOGE("Error getting value of write request.");
         ret = ESP_ERR_INVALID_ARG;
     }
+    else if (hk_value_normalize(hk_chrs_properties_get_type(chr->chr_type), hk_chr_timed_write_write_request) != ESP_OK)
+    {
+        HK_LOGE("Value of write request does not match the format of the characteristic.");
+        ret = ESP_ERR_INVALID_ARG;
+    }
 
     if (ret == ESP_OK)
     {
@@ -75,6 +81,10 @@ esp_err_t hk_chr_execute_write(hk_connection_t *connection, hk_transaction_t *tr
         {
             ret = chr->write_with_response_callback(connection, hk_chr_timed_write_write_request, write_response);
         }
+        else if (chr->write_response_callback)
+        {
+            ret = chr->write_response_callback(hk_chr_timed_write_write_request, write_response);
+        }
         else
         {
             HK_LOGE("Write callback was not found.");
@@ -6,6 +6,7 @@
 #include "../../../utils/hk_store.h"
 #include "../../../crypto/hk_hkdf.h"
 #include "../../../common/hk_global_state.h"
+#include "../../../common/hk_configuration.h"
 #include "../../../common/hk_accessory_id.h"
 
 #include "../hk_formats_ble.h"
@@ -27,14 +28,13 @@ esp_err_t hk_protocol_configuration(hk_conn_key_store_t *keys, hk_transaction_t
 
         // get parameters
         uint16_t global_state = hk_global_state_get();
-        uint8_t configuration = 0;
-        RUN_AND_CHECK(ret, hk_store_u8_get, HK_STORE_CONFIGURATION, &configuration);
+        uint8_t configuration = hk_configuration_get_u8();
         RUN_AND_CHECK(ret, hk_accessory_id_get, accessory_id);
-        ret = hk_broadcast_key_get(keys->accessory_shared_secret, broadcast_key);
+        ret = hk_broadcast_key_get(HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), broadcast_key);
         if (ret == ESP_ERR_NOT_FOUND || is01) // create new broadcast key if requested or key not available
         {
             ret = ESP_OK;
-            RUN_AND_CHECK(ret, hk_broadcast_key_reset, keys->accessory_shared_secret, broadcast_key);
+            RUN_AND_CHECK(ret, hk_broadcast_key_reset, HK_CONN_KEY_STORE_MEM(keys->accessory_shared_secret), broadcast_key);
         }
 
         // generate response
@@ -1,16 +1,25 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 #include "../../utils/hk_logging.h"
 #include "../../include/hk.h"
 #include "../../utils/hk_store.h"
+#include "../../utils/hk_recorder.h"
 #include "../../common/hk_accessory_id.h"
 #include "../../common/hk_pairings_store.h"
+#include "../../common/hk_pair_limiter.h"
 #include "../../common/hk_code_store.h"
-#include "../../common/hk_accessory_id.h"
+#include "../../common/hk_core.h"
+#include "../../common/hk_boot.h"
+#include "../../common/hk_configuration.h"
 #include "hk_server.h"
 #include "hk_advertising.h"
 #include "hk_chrs.h"
 #include "hk_accessories_store.h"
 
 void (*hk_identify_callback)();
+const char *hk_name = NULL;
+hk_categories_t hk_category;
 
 esp_err_t hk_identify(hk_mem* request){
     if(hk_identify_callback != NULL){
@@ -20,11 +29,35 @@ esp_err_t hk_identify(hk_mem* request){
     return ESP_OK;
 }
 
+static void hk_init_advertising()
+{
+    hk_advertising_init(hk_name, hk_category, hk_configuration_get());
+}
+
+static void hk_log_devices()
+{
+    hk_pairings_log_devices();
+}
+
 esp_err_t hk_init(const char *name, const hk_categories_t category, const char *code)
 {
+    hk_boot_mark(HK_BOOT_PHASE_INIT);
     hk_code = code;
-    hk_advertising_init(name, category, 2);
+    hk_name = name;
+    hk_category = category;
+#ifdef CONFIG_ESP32_HAP_RECORDER
+    hk_recorder_init(CONFIG_ESP32_HAP_RECORDER_SIZE);
+#endif
+
+    // mDNS is set up while the server starts. mDNS probes the name before announcing the service, which takes
+    // longer than starting the server, so the server listens before the accessory is found.
+    hk_boot_run(hk_init_advertising);
+    hk_core_init(hk_chrs_handle_event);
+    hk_boot_mark(HK_BOOT_PHASE_CORE);
     hk_server_start();
+    hk_boot_mark(HK_BOOT_PHASE_STACK);
+    hk_boot_join();
+    hk_boot_mark(HK_BOOT_PHASE_DISCOVERABLE);
 
     ESP_LOGD("homekit", "Inititialized.");
 
@@ -34,7 +67,8 @@ esp_err_t hk_init(const char *name, const hk_categories_t category, const char *
 esp_err_t hk_setup_start()
 {
     hk_store_init();
-    hk_pairings_log_devices();
+    hk_boot_mark(HK_BOOT_PHASE_STORE);
+    hk_boot_defer(hk_log_devices);
     
     return ESP_OK;
 }
@@ -68,19 +102,75 @@ esp_err_t hk_setup_add_chr(hk_chr_types_t type, esp_err_t (*read)(hk_mem* respon
     return hk_accessories_store_add_chr(type, read, write, can_notify, chr_ptr);
 }
 
+esp_err_t hk_setup_add_chr_with_response(hk_chr_types_t type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write_with_response)(hk_mem* request, hk_mem* response), bool can_notify, void **chr_ptr)
+{
+    return hk_accessories_store_add_chr_with_response(type, read, write_with_response, can_notify, chr_ptr);
+}
+
 esp_err_t hk_setup_finish()
 {
+    uint8_t reader;
     hk_accessories_store_end_config();
+
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
+    hk_configuration_update(hk_accessories_store_hash(accessories));
+    hk_accessories_store_read_unlock(reader);
+
     ESP_LOGD("homekit", "Set up.");
     
     return ESP_OK;
 }
 
+esp_err_t hk_reconfigure_start()
+{
+    hk_accessories_store_begin_config();
+
+    return ESP_OK;
+}
+
+esp_err_t hk_reconfigure_remove_accessory(void *chr_ptr)
+{
+    return hk_accessories_store_remove_accessory(chr_ptr);
+}
+
+esp_err_t hk_reconfigure_remove_srv(void *chr_ptr)
+{
+    return hk_accessories_store_remove_srv(chr_ptr);
+}
+
+esp_err_t hk_reconfigure_finish()
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t reader;
+    hk_accessories_store_end_config();
+
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
+    ret = hk_configuration_update(hk_accessories_store_hash(accessories));
+    hk_accessories_store_read_unlock(reader);
+
+    if (ret == ESP_OK)
+    {
+        ret = hk_advertising_update_configuration(hk_configuration_get());
+    }
+
+    // the characteristics of removed services are freed by the core task, after pending events for them are handled
+    hk_srv_t *removed_srvs = hk_accessories_store_take_removed_srvs();
+    if (removed_srvs != NULL && hk_core_post_blocking(HK_CORE_EVENT_RECLAIM, removed_srvs, -1) != ESP_OK)
+    {
+        HK_LOGE("Could not reclaim removed services.");
+    }
+
+    HK_LOGI("Reconfigured to configuration %d.", hk_configuration_get());
+
+    return ret;
+}
+
 esp_err_t hk_reset()
 {
     HK_LOGW("Resetting homekit for this device.");
     hk_accessory_id_reset();
     hk_pairings_store_remove_all();
+    hk_pair_limiter_reset();
     hk_advertising_reset();
     
     return ESP_OK;
@@ -88,5 +178,10 @@ esp_err_t hk_reset()
 
 esp_err_t hk_notify(void *chr)
 {
-    return hk_chrs_notify(chr);
+    return hk_core_post(HK_CORE_EVENT_NOTIFY, chr, -1);
+}
+
+esp_err_t hk_notify_from_isr(void *chr)
+{
+    return hk_core_post_from_isr(HK_CORE_EVENT_NOTIFY, chr, -1);
 }
\ No newline at end of file
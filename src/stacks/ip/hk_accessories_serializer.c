@@ -1,54 +1,82 @@
 #include "hk_accessories_serializer.h"
 
+#include <string.h>
+
 #include "../../include/hk_srvs.h"
 #include "../../include/hk_chrs.h"
 #include "../../include/hk_mem.h"
 #include "../../common/hk_chrs_properties.h"
+#include "../../common/hk_value.h"
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_ll.h"
+#include "../../utils/hk_base64.h"
 
 #define HAP_UUID "%08X-0000-1000-8000-0026BB765291"
+#define HK_ACCESSORIES_SERIALIZER_INITIAL_SIZE 2048 // doubled until the accessories fit
 
-cJSON *hk_accessories_serializer_format_value(hk_format_t format, void *value)
+cJSON *hk_accessories_serializer_format_data(hk_mem *value)
+{
+    // the value is encoded into the string of the item, which is freed by cJSON_Delete, instead of copying it
+    cJSON *j_value = cJSON_CreateNull();
+    char *encoded = cJSON_malloc(hk_base64_encoded_size(value->size) + 1);
+    if (j_value == NULL || encoded == NULL)
+    {
+        HK_LOGE("Could not allocate base64 value of size %d.", value->size);
+        cJSON_free(encoded);
+        return j_value;
+    }
+
+    hk_base64_encode(value->ptr, value->size, encoded);
+    j_value->type = cJSON_String;
+    j_value->valuestring = encoded;
+
+    return j_value;
+}
+
+cJSON *hk_accessories_serializer_format_mem(hk_format_t format, hk_mem *value)
 {
     switch (format)
     {
-    case HK_FORMAT_BOOL:
-        return cJSON_CreateBool(*(bool *)value);
-    case HK_FORMAT_UINT8:
-    case HK_FORMAT_UINT32:
-    case HK_FORMAT_UINT64:
-    case HK_FORMAT_INT:
-        return cJSON_CreateNumber(*(int *)value);
-    case HK_FORMAT_FLOAT:
-        return cJSON_CreateNumber(*(double *)value);
-    case HK_FORMAT_STRING:
-        return cJSON_CreateString((char *)value);
     case HK_FORMAT_TLV8:
-        HK_LOGE("Formatting for tlv values is not implemented for now.");
-        return cJSON_CreateNull();
     case HK_FORMAT_DATA:
-        HK_LOGE("Formatting for data values is not implemented for now.");
-        return cJSON_CreateNull();
+        return hk_accessories_serializer_format_data(value);
+    case HK_FORMAT_STRING:
+        if (value->size < 1 || value->ptr[value->size - 1] != 0)
+        {
+            hk_mem_append_string_terminator(value);
+        }
+        return cJSON_CreateString(value->ptr);
     default:
-        HK_LOGE("Unknown format found: %d", format);
-        return cJSON_CreateNull();
+    {
+        hk_value_t typed_value;
+        char formatted[HK_VALUE_MAX_FORMATTED_SIZE];
+        if (hk_value_decode(format, value->ptr, value->size, &typed_value) != ESP_OK ||
+            hk_value_format(&typed_value, formatted) == 0)
+        {
+            HK_LOGE("Could not format value of size %d with format %d.", value->size, format);
+            return cJSON_CreateNull();
+        }
+
+        // the number is written as formatted, without the double conversion of cjson
+        return cJSON_CreateRaw(formatted);
+    }
     }
 }
 
 esp_err_t hk_accessories_serializer_value(hk_chr_t *chr, cJSON *j_chr)
 {
-    hk_format_t format = hk_chrs_properties_get_type(chr->type);
     if (chr->read != NULL)
     {
+        hk_format_t format = hk_chrs_properties_get_type(chr->type);
         hk_mem* response = hk_mem_init();
         chr->read(response);
-        cJSON_AddItemToObject(j_chr, "value", hk_accessories_serializer_format_value(format, response->ptr));
+        cJSON_AddItemToObject(j_chr, "value", hk_accessories_serializer_format_mem(format, response));
         hk_mem_free(response);
     }
     else if (chr->static_value != NULL)
     {
-        cJSON_AddItemToObject(j_chr, "value", hk_accessories_serializer_format_value(format, chr->static_value));
+        // static values are strings only
+        cJSON_AddStringToObject(j_chr, "value", (const char *)chr->static_value);
     }
     else
     {
@@ -72,6 +100,9 @@ void hk_accessories_serializer_format(hk_chr_t *chr, cJSON *j_chr)
     case HK_FORMAT_UINT8:
         cJSON_AddStringToObject(j_chr, "format", "uint8");
         break;
+    case HK_FORMAT_UINT16:
+        cJSON_AddStringToObject(j_chr, "format", "uint16");
+        break;
     case HK_FORMAT_UINT32:
         cJSON_AddStringToObject(j_chr, "format", "uint32");
         break;
@@ -82,6 +113,7 @@ void hk_accessories_serializer_format(hk_chr_t *chr, cJSON *j_chr)
         cJSON_AddStringToObject(j_chr, "format", "int");
         break;
     case HK_FORMAT_FLOAT:
+    case HK_FORMAT_FLOAT_CELSIUS:
         cJSON_AddStringToObject(j_chr, "format", "float");
         break;
     case HK_FORMAT_STRING:
@@ -104,8 +136,10 @@ void hk_accessories_serializer_perms(hk_chr_t *chr, cJSON *j_chr)
     cJSON_AddItemToObject(j_chr, "perms", j_perms);
     if (chr->read != NULL || chr->static_value != NULL)
         cJSON_AddItemToArray(j_perms, cJSON_CreateString("pr"));
-    if (chr->write != NULL)
+    if (chr->write != NULL || chr->write_with_response != NULL)
         cJSON_AddItemToArray(j_perms, cJSON_CreateString("pw"));
+    if (chr->write_with_response != NULL)
+        cJSON_AddItemToArray(j_perms, cJSON_CreateString("wr"));
     if (chr->can_notify)
         cJSON_AddItemToArray(j_perms, cJSON_CreateString("ev"));
 }
@@ -171,16 +205,39 @@ esp_err_t hk_accessories_serializer_accessories(hk_mem *out)
     cJSON *j_accessories = cJSON_CreateArray();
     cJSON_AddItemToObject(j_root, "accessories", j_accessories);
 
-    hk_accessory_t *accessories = hk_accessories_store_get_accessories();
+    uint8_t reader;
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
     hk_ll_foreach(accessories, accessory)
     {
         hk_accessories_serializer_accessory(accessory, j_accessories);
     }
+    hk_accessories_store_read_unlock(reader);
+
+    // printed directly into out, so the serialization is allocated in the region of out only
+    esp_err_t ret = ESP_OK;
+    size_t offset = out->size;
+    size_t length = HK_ACCESSORIES_SERIALIZER_INITIAL_SIZE;
+    while (true)
+    {
+        hk_mem_set(out, offset + length);
+        if (out->ptr == NULL)
+        {
+            HK_LOGE("Could not allocate %d bytes to serialize accessories.", length);
+            out->size = 0;
+            ret = ESP_ERR_NO_MEM;
+            break;
+        }
+
+        if (cJSON_PrintPreallocated(j_root, out->ptr + offset, length, false))
+        {
+            hk_mem_set(out, offset + strlen(out->ptr + offset));
+            break;
+        }
+
+        length *= 2;
+    }
 
-    char *serialized = cJSON_PrintUnformatted(j_root);
-    hk_mem_append_string(out, (const char *)serialized);
-    free(serialized);
     cJSON_Delete(j_root);
 
-    return ESP_OK;
+    return ret;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../../include/hk_mem.h"
 #include "hk_accessories_store.h"
 
+cJSON *hk_accessories_serializer_format_mem(hk_format_t format, hk_mem *value);
 esp_err_t hk_accessories_serializer_value(hk_chr_t *chr, cJSON *j_chr);
 
 esp_err_t hk_accessories_serializer_accessories(hk_mem *out);
\ No newline at end of file
@@ -1,24 +1,142 @@
 #include "hk_accessories_store.h"
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_ll.h"
+#include "../../utils/hk_rcu.h"
+#include "../../common/hk_configuration.h"
 
+#include <string.h>
+
+// the accessories under construction, which are only visible to readers after being published
 hk_accessory_t *hk_accessories;
+hk_rcu_t hk_accessories_store_rcu;
+// the services removed since the last publishing, whose characteristics can be freed by the core task
+hk_srv_t *hk_accessories_removed_srvs = NULL;
+
+hk_accessory_t *hk_accessories_store_read_lock(uint8_t *reader)
+{
+    return (hk_accessory_t *)hk_rcu_read_lock(&hk_accessories_store_rcu, reader);
+}
 
-hk_accessory_t *hk_accessories_store_get_accessories()
+void hk_accessories_store_read_unlock(uint8_t reader)
 {
-    return hk_accessories;
+    hk_rcu_read_unlock(&hk_accessories_store_rcu, reader);
+}
+
+void hk_accessories_store_begin_config()
+{
+    uint8_t reader;
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
+
+    // Published accessories are immutable. We copy the accessories and services, in reversed order
+    // like they were while setting up. The characteristics are shared with the published version.
+    hk_accessories = NULL;
+    hk_ll_foreach(accessories, accessory)
+    {
+        hk_accessories = hk_ll_init(hk_accessories);
+        hk_accessories->aid = accessory->aid;
+        hk_accessories->srvs = NULL;
+
+        hk_ll_foreach(accessory->srvs, srv)
+        {
+            hk_accessories->srvs = hk_ll_init(hk_accessories->srvs);
+            *hk_accessories->srvs = *srv;
+        }
+    }
+
+    hk_accessories_store_read_unlock(reader);
 }
 
 void hk_accessories_store_add_accessory()
 {
     hk_accessories = hk_ll_init(hk_accessories);
+    hk_accessories->aid = 0;
     hk_accessories->srvs = NULL;
 }
 
+static bool hk_accessories_store_srv_has_chr(hk_srv_t *srv, void *chr_ptr)
+{
+    hk_ll_foreach(srv->chrs, chr)
+    {
+        if (chr == chr_ptr)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void hk_accessories_store_remove_srv_from(hk_accessory_t *accessory, hk_srv_t *srv)
+{
+    hk_accessories_removed_srvs = hk_ll_init(hk_accessories_removed_srvs);
+    *hk_accessories_removed_srvs = *srv;
+    accessory->srvs = hk_ll_remove(accessory->srvs, srv);
+}
+
+esp_err_t hk_accessories_store_remove_accessory(void *chr_ptr)
+{
+    hk_ll_foreach(hk_accessories, accessory)
+    {
+        hk_ll_foreach(accessory->srvs, srv)
+        {
+            if (hk_accessories_store_srv_has_chr(srv, chr_ptr))
+            {
+                while (accessory->srvs)
+                {
+                    hk_accessories_store_remove_srv_from(accessory, accessory->srvs);
+                }
+
+                hk_accessories = hk_ll_remove(hk_accessories, accessory);
+                return ESP_OK;
+            }
+        }
+    }
+
+    HK_LOGE("Could not find accessory to remove.");
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t hk_accessories_store_remove_srv(void *chr_ptr)
+{
+    hk_ll_foreach(hk_accessories, accessory)
+    {
+        hk_ll_foreach(accessory->srvs, srv)
+        {
+            if (hk_accessories_store_srv_has_chr(srv, chr_ptr))
+            {
+                hk_accessories_store_remove_srv_from(accessory, srv);
+                return ESP_OK;
+            }
+        }
+    }
+
+    HK_LOGE("Could not find service to remove.");
+    return ESP_ERR_NOT_FOUND;
+}
+
+hk_srv_t *hk_accessories_store_take_removed_srvs()
+{
+    hk_srv_t *srvs = hk_accessories_removed_srvs;
+    hk_accessories_removed_srvs = NULL;
+
+    return srvs;
+}
+
+void hk_accessories_store_free_srvs(hk_srv_t *srvs)
+{
+    hk_ll_foreach(srvs, srv)
+    {
+        hk_ll_free(srv->chrs);
+    }
+
+    hk_ll_free(srvs);
+}
+
 void hk_accessories_store_add_srv(hk_srv_types_t type, bool primary, bool hidden)
 {
     hk_srv_t *srv = hk_ll_init(hk_accessories->srvs);
 
+    srv->iid = 0;
     srv->type = type;
     srv->primary = primary;
     srv->hidden = hidden;
@@ -31,10 +149,12 @@ esp_err_t hk_accessories_store_add_chr(hk_chr_types_t type, esp_err_t (*read)(hk
 {
     hk_chr_t *chr = hk_ll_init(hk_accessories->srvs->chrs);
 
+    chr->iid = 0;
     chr->type = type;
     chr->static_value = NULL;
     chr->read = read;
     chr->write = write;
+    chr->write_with_response = NULL;
     chr->can_notify = can_notify;
 
     hk_accessories->srvs->chrs = chr;
@@ -43,56 +163,164 @@ esp_err_t hk_accessories_store_add_chr(hk_chr_types_t type, esp_err_t (*read)(hk
     return ESP_OK;
 }
 
+esp_err_t hk_accessories_store_add_chr_with_response(hk_chr_types_t type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write_with_response)(hk_mem* request, hk_mem* response), bool can_notify, void **chr_ptr)
+{
+    esp_err_t ret = hk_accessories_store_add_chr(type, read, NULL, can_notify, chr_ptr);
+    hk_accessories->srvs->chrs->write_with_response = write_with_response;
+
+    return ret;
+}
+
 void hk_accessories_store_add_chr_static_read(hk_chr_types_t type, void *value)
 {
     hk_chr_t *chr = hk_ll_init(hk_accessories->srvs->chrs);
 
+    chr->iid = 0;
     chr->type = type;
     chr->static_value = value;
     chr->read = NULL;
     chr->write = NULL;
+    chr->write_with_response = NULL;
     chr->can_notify = false;
 
     hk_accessories->srvs->chrs = chr;
 }
 
+static size_t hk_accessories_store_max_iid(hk_accessory_t *accessory)
+{
+    size_t iid = 0;
+    hk_ll_foreach(accessory->srvs, srv)
+    {
+        iid = srv->iid > iid ? srv->iid : iid;
+        hk_ll_foreach(srv->chrs, chr)
+        {
+            iid = chr->iid > iid ? chr->iid : iid;
+        }
+    }
+
+    return iid;
+}
+
+static size_t hk_accessories_store_assign_added_chrs(hk_accessory_t *accessory, hk_srv_t *srv, size_t iid)
+{
+    // The list of a published service is shared with the published version, so it cannot be reversed. Added
+    // characteristics are in front of it, in reversed order, and are numbered from the back.
+    size_t added_count = 0;
+    hk_ll_foreach(srv->chrs, chr)
+    {
+        added_count += chr->iid == 0 ? 1 : 0;
+    }
+
+    size_t chr_iid = iid + added_count;
+    hk_ll_foreach(srv->chrs, chr)
+    {
+        if (chr->iid == 0)
+        {
+            chr->iid = chr_iid--;
+            chr->aid = accessory->aid;
+        }
+    }
+
+    return iid + added_count;
+}
+
 void hk_accessories_store_end_config()
 {
-    if (hk_accessories)
+    size_t aid = 0;
+    hk_ll_foreach(hk_accessories, accessory)
     {
-        size_t aid = 0;
-        size_t iid = 0;
-        hk_accessories = hk_ll_reverse(hk_accessories);
-        hk_ll_foreach(hk_accessories, accessory)
+        aid = accessory->aid > aid ? accessory->aid : aid;
+    }
+
+    // Ids of published accessories, services and characteristics stay stable. New ones continue after
+    // the highest id in use. New ones have an id of 0.
+    hk_accessories = hk_ll_reverse(hk_accessories);
+    hk_ll_foreach(hk_accessories, accessory)
+    {
+        if (accessory->aid == 0)
         {
-            iid = 0;
             accessory->aid = ++aid;
-            if (accessory->srvs)
+        }
+
+        size_t iid = hk_accessories_store_max_iid(accessory);
+        accessory->srvs = hk_ll_reverse(accessory->srvs);
+        hk_ll_foreach(accessory->srvs, srv)
+        {
+            if (srv->iid == 0)
             {
-                accessory->srvs = hk_ll_reverse(accessory->srvs);
-                hk_ll_foreach(accessory->srvs, srv)
+                srv->iid = ++iid;
+                srv->chrs = hk_ll_reverse(srv->chrs);
+                hk_ll_foreach(srv->chrs, chr)
                 {
-                    srv->iid = ++iid;
-                    if (srv->chrs)
-                    {
-                        srv->chrs = hk_ll_reverse(srv->chrs);
-                        hk_ll_foreach(srv->chrs, chr)
-                        {
-                            chr->iid = ++iid;
-                            chr->aid = accessory->aid;
-                        }
-                    }
+                    chr->iid = ++iid;
+                    chr->aid = accessory->aid;
                 }
             }
+            else
+            {
+                iid = hk_accessories_store_assign_added_chrs(accessory, srv, iid);
+            }
         }
     }
+
+    // from now on the accessories are immutable
+    hk_accessory_t *old_accessories = hk_rcu_publish(&hk_accessories_store_rcu, hk_accessories);
+
+    // no reader uses the copies of the previous version anymore
+    hk_ll_foreach(old_accessories, accessory)
+    {
+        hk_ll_free(accessory->srvs);
+    }
+    hk_ll_free(old_accessories);
+}
+
+static void hk_accessories_store_hash_chr(uint32_t *hash, hk_chr_t *chr)
+{
+    uint8_t features[] = {
+        chr->read != NULL,
+        chr->write != NULL,
+        chr->write_with_response != NULL,
+        chr->can_notify};
+
+    hk_configuration_hash_append(hash, &chr->iid, sizeof(chr->iid));
+    hk_configuration_hash_append(hash, &chr->type, sizeof(chr->type));
+    hk_configuration_hash_append(hash, features, sizeof(features));
+    if (chr->static_value != NULL)
+    {
+        // static values are strings, like the firmware revision
+        hk_configuration_hash_append(hash, chr->static_value, strlen((const char *)chr->static_value) + 1);
+    }
+}
+
+uint32_t hk_accessories_store_hash(hk_accessory_t *accessories)
+{
+    uint32_t hash;
+    hk_configuration_hash_init(&hash);
+
+    hk_ll_foreach(accessories, accessory)
+    {
+        hk_configuration_hash_append(&hash, &accessory->aid, sizeof(accessory->aid));
+        hk_ll_foreach(accessory->srvs, srv)
+        {
+            uint8_t features[] = {srv->primary, srv->hidden};
+            hk_configuration_hash_append(&hash, &srv->iid, sizeof(srv->iid));
+            hk_configuration_hash_append(&hash, &srv->type, sizeof(srv->type));
+            hk_configuration_hash_append(&hash, features, sizeof(features));
+            hk_ll_foreach(srv->chrs, chr)
+            {
+                hk_accessories_store_hash_chr(&hash, chr);
+            }
+        }
+    }
+
+    return hash;
 }
 
-hk_chr_t *hk_accessories_store_get_chr(size_t aid, size_t iid)
+hk_chr_t *hk_accessories_store_get_chr(hk_accessory_t *accessories, size_t aid, size_t iid)
 {
-    if (hk_accessories)
+    if (accessories)
     {
-        hk_ll_foreach(hk_accessories, accessory)
+        hk_ll_foreach(accessories, accessory)
         {
             if (aid == accessory->aid && accessory->srvs)
             {
@@ -116,11 +344,11 @@ hk_chr_t *hk_accessories_store_get_chr(size_t aid, size_t iid)
     return NULL;
 }
 
-hk_chr_t *hk_accessories_store_get_identify_chr()
+hk_chr_t *hk_accessories_store_get_identify_chr(hk_accessory_t *accessories)
 {
-    if (hk_accessories)
+    if (accessories)
     {
-        hk_ll_foreach(hk_accessories, accessory)
+        hk_ll_foreach(accessories, accessory)
         {
             if (accessory->srvs)
             {
@@ -148,5 +376,6 @@ void hk_accessories_free()
 {
     // we do not free ressources, because this method is used in unit testing only
     hk_accessories = NULL;
+    hk_rcu_publish(&hk_accessories_store_rcu, NULL);
     HK_LOGW("Freeing accessories is not implemented.");
 }
\ No newline at end of file
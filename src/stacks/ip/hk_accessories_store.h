@@ -7,6 +7,7 @@
 #include "../../common/hk_chrs_properties.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 typedef struct
@@ -17,6 +18,7 @@ typedef struct
     void *static_value;
     esp_err_t (*read)(hk_mem* response);
     esp_err_t (*write)(hk_mem* request);
+    esp_err_t (*write_with_response)(hk_mem* request, hk_mem* response);
     bool can_notify;
 } hk_chr_t;
 
@@ -35,13 +37,21 @@ typedef struct
     hk_srv_t *srvs;
 } hk_accessory_t;
 
+void hk_accessories_store_begin_config();
 void hk_accessories_store_add_accessory();
 void hk_accessories_store_add_srv(hk_srv_types_t srv_type, bool primary, bool hidden);
 esp_err_t hk_accessories_store_add_chr(hk_chr_types_t chr_type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write)(hk_mem* request), bool can_notify, void **chr_ptr);
+esp_err_t hk_accessories_store_add_chr_with_response(hk_chr_types_t chr_type, esp_err_t (*read)(hk_mem* response), esp_err_t (*write_with_response)(hk_mem* request, hk_mem* response), bool can_notify, void **chr_ptr);
 void hk_accessories_store_add_chr_static_read(hk_chr_types_t type, void *value);
+esp_err_t hk_accessories_store_remove_accessory(void *chr_ptr);
+esp_err_t hk_accessories_store_remove_srv(void *chr_ptr);
 void hk_accessories_store_end_config();
+hk_srv_t *hk_accessories_store_take_removed_srvs();
+void hk_accessories_store_free_srvs(hk_srv_t *srvs);
+uint32_t hk_accessories_store_hash(hk_accessory_t *accessories);
 
-hk_accessory_t *hk_accessories_store_get_accessories();
-hk_chr_t *hk_accessories_store_get_chr(size_t aid, size_t iid);
-hk_chr_t *hk_accessories_store_get_identify_chr();
+hk_accessory_t *hk_accessories_store_read_lock(uint8_t *reader);
+void hk_accessories_store_read_unlock(uint8_t reader);
+hk_chr_t *hk_accessories_store_get_chr(hk_accessory_t *accessories, size_t aid, size_t iid);
+hk_chr_t *hk_accessories_store_get_identify_chr(hk_accessory_t *accessories);
 void hk_accessories_free();
\ No newline at end of file
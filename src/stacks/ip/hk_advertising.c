@@ -1,6 +1,8 @@
 #include "hk_advertising.h"
 
 #include <mdns.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include "../../utils/hk_logging.h"
 #include "../../common/hk_pairings_store.h"
@@ -9,81 +11,133 @@
 #include "../../utils/hk_util.h"
 #include "../../include/hk_categories.h"
 
+#define HK_ADVERTISING_TXT_VALUE_SIZE 64
+
+typedef enum
+{
+    HK_ADVERTISING_TXT_ID,
+    HK_ADVERTISING_TXT_MD,
+    HK_ADVERTISING_TXT_PV,
+    HK_ADVERTISING_TXT_C,
+    HK_ADVERTISING_TXT_S,
+    HK_ADVERTISING_TXT_FF,
+    HK_ADVERTISING_TXT_CI,
+    HK_ADVERTISING_TXT_SF,
+    HK_ADVERTISING_TXT_COUNT
+} hk_advertising_txt_t;
+
+const char *hk_advertising_txt_keys[HK_ADVERTISING_TXT_COUNT] = {"id", "md", "pv", "c#", "s#", "ff", "ci", "sf"};
+char hk_advertising_txt_values[HK_ADVERTISING_TXT_COUNT][HK_ADVERTISING_TXT_VALUE_SIZE] = {{0}}; // empty values are not advertised
 bool hk_advertising_is_running = false;
+SemaphoreHandle_t hk_advertising_mutex = NULL; // the text is set from the core, the server and the application tasks
+portMUX_TYPE hk_advertising_mutex_lock = portMUX_INITIALIZER_UNLOCKED;
 
-static void hk_advertising_add_txt(const char *key, const char *format, ...)
+static void hk_advertising_lock()
 {
+    if (hk_advertising_mutex == NULL)
+    {
+        // the first callers can race, so only one of the created mutexes is kept
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&hk_advertising_mutex_lock);
+        if (hk_advertising_mutex == NULL)
+        {
+            hk_advertising_mutex = mutex;
+            mutex = NULL;
+        }
+        portEXIT_CRITICAL(&hk_advertising_mutex_lock);
+
+        if (mutex != NULL)
+        {
+            vSemaphoreDelete(mutex);
+        }
+    }
+
+    xSemaphoreTake(hk_advertising_mutex, portMAX_DELAY);
+}
+
+static void hk_advertising_unlock()
+{
+    xSemaphoreGive(hk_advertising_mutex);
+}
+
+// has to be called with the lock taken
+static esp_err_t hk_advertising_set_txt(hk_advertising_txt_t txt, const char *format, ...)
+{
+    esp_err_t ret = ESP_OK;
+    char value[HK_ADVERTISING_TXT_VALUE_SIZE];
+    const char *key = hk_advertising_txt_keys[txt];
+
     va_list arg_ptr;
     va_start(arg_ptr, format);
-
-    char value[128];
     int value_len = vsnprintf(value, sizeof(value), format, arg_ptr);
-
     va_end(arg_ptr);
 
-    if (value_len && value_len < sizeof(value) - 1)
-    {
-        HK_LOGD("Adding service text: %s (%s)", key, value);
-        ESP_ERROR_CHECK(mdns_service_txt_item_set("_hap", "_tcp", key, value));
-    }
-    else
+    if (value_len < 0 || value_len >= sizeof(value) - 1)
     {
         HK_LOGE("Could not add service text: %s (%s)", key, value);
+        return ESP_ERR_INVALID_SIZE;
     }
-}
 
-void hk_advertising_init(const char *name, hk_categories_t category, size_t config_version)
-{
-    // spec 6.4 Discovery
+    if (strcmp(value, hk_advertising_txt_values[txt]) == 0)
+    {
+        // unchanged values are not announced again
+        return ESP_OK;
+    }
 
-    // Free in case of reconnecting to wifi
-    mdns_free();
+    strcpy(hk_advertising_txt_values[txt], value);
 
-    // initialize mDNS
-    ESP_ERROR_CHECK(mdns_init());
-    // set mDNS hostname (required if you want to advertise services)
-    ESP_ERROR_CHECK(mdns_hostname_set(name));
-    // set mDNS instance name
-    ESP_ERROR_CHECK(mdns_instance_name_set(name));
-    ESP_ERROR_CHECK(mdns_service_add(name, "_hap", "_tcp", 5556, NULL, 0)); // accessory model name (required)
+    // before mdns runs, only the cache is updated
+    if (hk_advertising_is_running && value_len > 0)
+    {
+        HK_LOGD("Setting service text: %s (%s)", key, value);
+        ret = mdns_service_txt_item_set("_hap", "_tcp", key, value);
+    }
+    else if (hk_advertising_is_running)
+    {
+        HK_LOGD("Removing service text: %s", key);
+        ret = mdns_service_txt_item_remove("_hap", "_tcp", key);
+    }
 
-    // device ID (required), should be in format XX:XX:XX:XX:XX:XX, otherwise devices will ignore it
-    hk_mem *accessory_id = hk_mem_init();
-    hk_accessory_id_get_serialized(accessory_id);
-    char *id_str = strndup(accessory_id->ptr, accessory_id->size);
-    hk_advertising_add_txt("id", "%s", id_str);
-    hk_mem_free(accessory_id);
-    free(id_str);
-
-    hk_advertising_add_txt("md", "%s", name);                  // model name
-    hk_advertising_add_txt("pv", "1.1");                       // protocol version (required)
-    hk_advertising_add_txt("c#", "%d", config_version);        // current configuration number (required)
-    hk_advertising_add_txt("s#", "%d", hk_global_state_get()); // current state number (required)
-    hk_advertising_add_txt("ff", "0");                         // see spec table 5.4 - its completely unclear what that is for.
-    hk_advertising_add_txt("ci", "%d", category);              // accessory category identifier
-    hk_advertising_update_paired();
-    hk_advertising_is_running = true;
+    return ret;
 }
 
-esp_err_t hk_advertising_global_state_next()
+static size_t hk_advertising_get_txt_items(mdns_txt_item_t *items)
 {
-    hk_global_state_next();
-    hk_advertising_add_txt("s#", "%d", hk_global_state_get()); // current state number (required)
-    return ESP_OK;
+    size_t count = 0;
+
+    for (size_t i = 0; i < HK_ADVERTISING_TXT_COUNT; i++)
+    {
+        if (hk_advertising_txt_values[i][0] != '\0')
+        {
+            items[count].key = hk_advertising_txt_keys[i];
+            items[count].value = hk_advertising_txt_values[i];
+            count++;
+        }
+    }
+
+    return count;
 }
 
-esp_err_t hk_advertising_update_paired()
+static esp_err_t hk_advertising_update_id_txt()
 {
-    esp_err_t ret = ESP_OK;
+    // device ID (required), should be in format XX:XX:XX:XX:XX:XX, otherwise devices will ignore it
+    hk_slice_t accessory_id = {0};
+    esp_err_t ret = hk_accessory_id_get_serialized(&accessory_id);
 
-    // if item is not paired, we need this flag. Otherwise not.
-    if (hk_advertising_is_running)
+    if (ret == ESP_OK)
     {
-        ret = mdns_service_txt_item_remove("_hap", "_tcp", "sf");
+        ret = hk_advertising_set_txt(HK_ADVERTISING_TXT_ID, "%.*s", (int)accessory_id.size, accessory_id.ptr);
     }
 
+    return ret;
+}
+
+// has to be called with the lock taken
+static void hk_advertising_update_paired_txt()
+{
     bool paired = false;
     hk_pairings_store_has_pairing(&paired);
+
     if (!paired)
     {
         // spec Table 6.8 - status flags
@@ -91,23 +145,111 @@ esp_err_t hk_advertising_update_paired()
         //   bit 2 - not configured to join WiFi
         //   bit 3 - problem detected on accessory
         //   bits 4-8 - reserved
-        hk_advertising_add_txt("sf", "1");
+        hk_advertising_set_txt(HK_ADVERTISING_TXT_SF, "1");
     }
     else
     {
+        // if item is not paired, we need this flag. Otherwise not.
         HK_LOGI("Not advertising for pairing, because we are coupled already.");
-        //hk_advertising_add_txt("sf", "0");
+        hk_advertising_set_txt(HK_ADVERTISING_TXT_SF, "");
     }
+}
+
+void hk_advertising_init(const char *name, hk_categories_t category, size_t config_version)
+{
+    // spec 6.4 Discovery
+    mdns_txt_item_t items[HK_ADVERTISING_TXT_COUNT];
+
+    hk_advertising_lock();
+
+    // the whole text is refreshed, as the accessory may have been reset since the last start
+    hk_advertising_update_id_txt();
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_MD, "%s", name);                  // model name
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_PV, "1.1");                       // protocol version (required)
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_C, "%d", config_version);         // current configuration number (required)
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_S, "%d", hk_global_state_get()); // current state number (required)
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_FF, "0");                         // see spec table 5.4 - its completely unclear what that is for.
+    hk_advertising_set_txt(HK_ADVERTISING_TXT_CI, "%d", category);              // accessory category identifier
+    hk_advertising_update_paired_txt();
+
+    if (hk_advertising_is_running)
+    {
+        // mDNS is kept alive when the wifi reconnects. It announces the service on the interface again, as soon as
+        // the interface has an address. So only the changed values were set above.
+        HK_LOGD("Advertising is running already, announced changed service text.");
+        hk_advertising_unlock();
+        return;
+    }
+
+    // initialize mDNS
+    ESP_ERROR_CHECK(mdns_init());
+    // set mDNS hostname (required if you want to advertise services)
+    ESP_ERROR_CHECK(mdns_hostname_set(name));
+    // set mDNS instance name
+    ESP_ERROR_CHECK(mdns_instance_name_set(name));
+    // the service is added with its whole text, so it is announced once
+    size_t count = hk_advertising_get_txt_items(items);
+    ESP_ERROR_CHECK(mdns_service_add(name, "_hap", "_tcp", 5556, items, count)); // accessory model name (required)
+    hk_advertising_is_running = true;
+
+    hk_advertising_unlock();
+}
+
+esp_err_t hk_advertising_global_state_next()
+{
+    hk_advertising_lock();
+    hk_global_state_next();
+    esp_err_t ret = hk_advertising_set_txt(HK_ADVERTISING_TXT_S, "%d", hk_global_state_get()); // current state number (required)
+    hk_advertising_unlock();
+
+    return ret;
+}
+
+esp_err_t hk_advertising_update_configuration(size_t config_version)
+{
+    hk_advertising_lock();
+    esp_err_t ret = hk_advertising_set_txt(HK_ADVERTISING_TXT_C, "%d", config_version); // current configuration number (required)
+    hk_advertising_unlock();
 
     return ret;
 }
 
+esp_err_t hk_advertising_update_paired()
+{
+    hk_advertising_lock();
+    hk_advertising_update_paired_txt();
+    hk_advertising_unlock();
+
+    return ESP_OK;
+}
+
 esp_err_t hk_advertising_reset()
 {
-    if (hk_advertising_is_running)
+    // the accessory id is created again after a reset, so controllers see a new accessory
+    hk_advertising_lock();
+    esp_err_t ret = hk_advertising_update_id_txt();
+    hk_advertising_update_paired_txt();
+    hk_advertising_unlock();
+
+    return ret;
+}
+
+esp_err_t hk_advertising_get_txt(const char *key, hk_mem *value)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    hk_advertising_lock();
+    for (size_t i = 0; i < HK_ADVERTISING_TXT_COUNT; i++)
     {
-        return hk_advertising_update_paired();
+        if (strcmp(hk_advertising_txt_keys[i], key) == 0)
+        {
+            hk_mem_set(value, 0);
+            hk_mem_append_string(value, hk_advertising_txt_values[i]);
+            ret = ESP_OK;
+            break;
+        }
     }
+    hk_advertising_unlock();
 
-    return ESP_OK;
+    return ret;
 }
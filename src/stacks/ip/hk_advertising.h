@@ -4,7 +4,11 @@
 #include <stdbool.h>
 #include <esp_err.h>
 
+#include "../../include/hk_mem.h"
+
 void hk_advertising_init(const char *name, size_t category, size_t config_version);
 esp_err_t hk_advertising_update_paired();
 esp_err_t hk_advertising_global_state_next();
+esp_err_t hk_advertising_update_configuration(size_t config_version);
 esp_err_t hk_advertising_reset();
+esp_err_t hk_advertising_get_txt(const char *key, hk_mem *value);
@@ -1,11 +1,14 @@
 #include "hk_chrs.h"
 
 #include "../../common/hk_chrs_properties.h"
+#include "../../common/hk_value.h"
 #include "../../include/hk_srvs.h"
 #include "../../include/hk_chrs.h"
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_ll.h"
 #include "../../utils/hk_util.h"
+#include "../../utils/hk_base64.h"
+#include "../../utils/hk_json.h"
 #include "hk_server.h"
 #include "hk_accessories_serializer.h"
 #include "hk_subscription_store.h"
@@ -14,6 +17,26 @@
 #include <cJSON.h>
 #include <stdbool.h>
 
+#define HK_CHRS_PUT_MAX_ITEMS 16 // characteristics of one write request, the items are kept on the stack of the server
+
+typedef struct
+{
+    size_t aid;
+    size_t iid;
+    hk_json_token_t value;
+    bool has_value;
+    bool has_ev;
+    bool ev;
+    bool response_requested;
+    hk_format_t format;                                                  // set when prepared
+    esp_err_t (*write)(hk_mem *request);                                 // set when prepared
+    esp_err_t (*write_with_response)(hk_mem *request, hk_mem *response); // set when prepared
+    hk_mem request;                                                      // the decoded value, set when prepared
+    hk_value_t number;                                                   // the value of numeric formats
+    int status;                                                          // set when prepared and written
+    hk_mem *write_response;                                              // set when written
+} hk_chrs_put_item_t;
+
 char *hk_chrs_get_next_id_pair(char *ids, int *result)
 {
     sscanf(ids, "%d.%d", &result[0], &result[1]);
@@ -32,6 +55,8 @@ esp_err_t hk_chrs_get(char *ids, hk_mem *response)
     esp_err_t ret = ESP_OK;
 
     int results[2];
+    uint8_t reader;
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
     cJSON *j_root = cJSON_CreateObject();
     cJSON *j_chrs = cJSON_CreateArray();
     cJSON_AddItemToObject(j_root, "characteristics", j_chrs);
@@ -39,7 +64,7 @@ esp_err_t hk_chrs_get(char *ids, hk_mem *response)
     while (ids != NULL)
     {
         ids = hk_chrs_get_next_id_pair(ids, results);
-        hk_chr_t *chr = hk_accessories_store_get_chr(results[0], results[1]);
+        hk_chr_t *chr = hk_accessories_store_get_chr(accessories, results[0], results[1]);
         if (chr == NULL)
         {
             HK_LOGE("Could not find chr %d.%d.", results[0], results[1]);
@@ -62,6 +87,7 @@ esp_err_t hk_chrs_get(char *ids, hk_mem *response)
     }
 
     cJSON_Delete(j_root);
+    hk_accessories_store_read_unlock(reader);
 
     return ret;
 }
@@ -136,140 +162,214 @@ esp_err_t hk_chrs_notify(void *chr_ptr)
     return ret;
 }
 
-static esp_err_t hk_chrs_write(int socket, int aid, int iid, cJSON *j_chr)
+void hk_chrs_handle_event(hk_core_event_t *event)
 {
     esp_err_t ret = ESP_OK;
-    hk_chr_t *chr = hk_accessories_store_get_chr(aid, iid);
-    if (chr == NULL)
+    uint8_t reader;
+
+    // keeps the characteristic of the event alive
+    hk_accessories_store_read_lock(&reader);
+
+    switch (event->type)
     {
-        HK_LOGE("%d - Could not find chr %d.%d.", socket, aid, iid);
-        ret = ESP_FAIL;
+    case HK_CORE_EVENT_NOTIFY:
+        ret = hk_chrs_notify(event->chr);
+        break;
+    case HK_CORE_EVENT_SUBSCRIBE:
+        ret = hk_subscription_store_add((hk_chr_t *)event->chr, event->socket);
+        break;
+    case HK_CORE_EVENT_UNSUBSCRIBE:
+        ret = hk_subscription_store_remove((hk_chr_t *)event->chr, event->socket);
+        break;
+    case HK_CORE_EVENT_UNSUBSCRIBE_ALL:
+        ret = hk_subscription_store_remove_all(event->socket);
+        break;
+    case HK_CORE_EVENT_RECLAIM:
+        // the removed services are unpublished, so no new events can reference them
+        hk_ll_foreach((hk_srv_t *)event->chr, srv)
+        {
+            hk_ll_foreach(srv->chrs, chr)
+            {
+                hk_subscription_store_remove_chr(chr);
+            }
+        }
+        hk_accessories_store_free_srvs(event->chr);
+        break;
+    }
+
+    hk_accessories_store_read_unlock(reader);
+
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND)
+    {
+        HK_LOGE("%d - Error handling core event %d: %s", event->socket, event->type, esp_err_to_name(ret));
     }
+}
+
+static esp_err_t hk_chrs_write_prepare(int socket, hk_chr_t *chr, hk_chrs_put_item_t *item)
+{
+    esp_err_t ret = ESP_OK;
+    const size_t aid = chr->aid;
+    const size_t iid = chr->iid;
+    hk_json_token_t *j_value = &item->value;
 
-    if (chr->write == NULL)
+    if (chr->write == NULL && chr->write_with_response == NULL)
     {
         HK_LOGE("%d - Could not write chr %d.%d. It has no write function.", socket, aid, iid);
-        ret = ESP_FAIL;
+        return ESP_ERR_NOT_SUPPORTED;
     }
 
-    if (!ret)
+    hk_format_t format = hk_chrs_properties_get_type(chr->type);
+    hk_mem *write_request = &item->request;
+    // strings are unescaped and decoded in place of the request, they never become longer
+    char *string = (char *)j_value->ptr;
+
+    switch (format)
     {
-        cJSON *j_value = cJSON_GetObjectItem(j_chr, "value");
-        hk_format_t format = hk_chrs_properties_get_type(chr->type);
-        bool bool_value = false;
-        hk_mem *write_request = hk_mem_init();
+    case HK_FORMAT_STRING:
+        if (j_value->type != HK_JSON_STRING)
+        {
+            HK_LOGE("%d - Failed to update %d.%d: value is not a string", socket, aid, iid);
+            ret = ESP_ERR_INVALID_ARG;
+        }
 
-        switch (format)
+        RUN_AND_CHECK(ret, hk_json_unescape, string, j_value->length, &write_request->size);
+        write_request->ptr = string;
+        break;
+    case HK_FORMAT_TLV8:
+    case HK_FORMAT_DATA:
+        if (j_value->type != HK_JSON_STRING)
         {
-        case HK_FORMAT_BOOL:
-            if (j_value->type == cJSON_True)
-            {
-                bool_value = true;
-            }
-            else if (j_value->type == cJSON_False)
-            {
-                bool_value = false;
-            }
-            else if (j_value->type == cJSON_Number && (j_value->valueint == 0 || j_value->valueint == 1))
-            {
-                bool_value = j_value->valueint == 1;
-            }
-            else
-            {
-                HK_LOGE("%d - Failed to update %d.%d: value is not a boolean or 0/1", socket, aid, iid);
-                ret = ESP_FAIL;
-            }
-            hk_mem_append_buffer(write_request, (char *)&bool_value, sizeof(bool));
-            break;
-        case HK_FORMAT_UINT8:
-        case HK_FORMAT_UINT16:
-        case HK_FORMAT_UINT32:
-        case HK_FORMAT_UINT64:
-        case HK_FORMAT_INT:
-            // We accept boolean values here in order to fix a bug in HomeKit. HomeKit sometimes sends a boolean
-            // instead of an integer of value 0 or 1.
-            if (j_value->type != cJSON_Number && j_value->type != cJSON_False && j_value->type != cJSON_True)
-            {
-                HK_LOGE("%d - Failed to update %d.%d: value is not a number", socket, aid, iid);
-                ret = ESP_FAIL;
-            }
+            HK_LOGE("%d - Failed to update %d.%d: value is not a base64 string", socket, aid, iid);
+            ret = ESP_ERR_INVALID_ARG;
+        }
 
-            hk_mem_append_buffer(write_request, (char *)&j_value->valueint, sizeof(int));
+        // slashes of base64 can be escaped in json
+        RUN_AND_CHECK(ret, hk_json_unescape, string, j_value->length, &write_request->size);
+        RUN_AND_CHECK(ret, hk_base64_decode_buffer, string, write_request->size, string, &write_request->size);
+        write_request->ptr = string;
+        break;
+    case HK_FORMAT_UNKNOWN:
+        HK_LOGE("%d - Error: unknown format.", socket);
+        ret = ESP_ERR_INVALID_ARG;
+        break;
+    default:
+        // We accept boolean values for numbers in order to fix a bug in HomeKit. HomeKit sometimes sends a boolean
+        // instead of an integer of value 0 or 1. The codec checks the range of the format.
+        if ((j_value->type != HK_JSON_NUMBER && j_value->type != HK_JSON_TRUE && j_value->type != HK_JSON_FALSE) ||
+            hk_value_parse(format, j_value->ptr, j_value->length, &item->number) != ESP_OK)
+        {
+            HK_LOGE("%d - Failed to update %d.%d: value does not match format %d", socket, aid, iid, format);
+            ret = ESP_ERR_INVALID_ARG;
+        }
 
-            break;
-        case HK_FORMAT_FLOAT:
-            if (j_value->type != cJSON_Number)
-            {
-                HK_LOGE("%d - Failed to update %d.%d: value is not a number", socket, aid, iid);
-                ret = ESP_FAIL;
-            }
+        // every number starts at the beginning of the union, with the exact width of its format
+        write_request->ptr = (char *)&item->number.u8;
+        write_request->size = hk_value_size(format);
+        break;
+    }
 
-            hk_mem_append_buffer(write_request, (char *)&j_value->valuedouble, sizeof(double));
+    if (ret == ESP_OK)
+    {
+        // the callbacks are called after the accessories are unlocked, as they may reconfigure them
+        item->format = format;
+        item->write = chr->write;
+        item->write_with_response = chr->write_with_response;
+    }
 
-            break;
-        case HK_FORMAT_STRING:
-            if (j_value->type != cJSON_String)
-            {
-                HK_LOGE("%d - Failed to update %d.%d: value is not a string", socket, aid, iid);
-                ret = ESP_FAIL;
-            }
+    return ret;
+}
 
-            hk_mem_append_string(write_request, j_value->valuestring);
-            break;
-        case HK_FORMAT_TLV8:
-            HK_LOGW("%d - Writing tlv not implemented.", socket);
-            break;
-        case HK_FORMAT_DATA:
-            HK_LOGW("%d - Writing data not implemented.", socket);
-            break;
-        case HK_FORMAT_UNKNOWN:
-            HK_LOGE("%d - Error: unknown format.", socket);
-            break;
-        }
+static esp_err_t hk_chrs_write(int socket, hk_chrs_put_item_t *item)
+{
+    esp_err_t ret = ESP_OK;
 
-        if (!ret)
-        {
-            HK_LOGD("%d - Writing chr %d.%d.", socket, aid, iid);
+    HK_LOGD("%d - Writing chr %d.%d.", socket, item->aid, item->iid);
 
-            ret = chr->write(write_request);
-            if (ret == ESP_OK)
-            {
-                //todo: hk_chrs_notify(chr);
-            }
-            else
-            {
-                HK_LOGE("%d - Error writing characteristic.", socket);
-            }
-        }
+    if (item->write_with_response != NULL)
+    {
+        item->write_response = hk_mem_init();
+        ret = item->write_with_response(&item->request, item->write_response);
+    }
+    else
+    {
+        ret = item->write(&item->request);
+    }
 
-        hk_mem_free(write_request);
+    if (ret == ESP_OK)
+    {
+        //todo: hk_chrs_notify(chr);
+    }
+    else
+    {
+        HK_LOGE("%d - Error writing characteristic.", socket);
+        ret = ESP_FAIL;
     }
 
     return ret;
 }
 
-static esp_err_t hk_chr_subscribe(int socket, int aid, int iid)
+static void hk_chrs_write_response_value(hk_accessory_t *accessories, hk_chrs_put_item_t *item, cJSON *j_result)
+{
+    if (item->write_response != NULL && item->write_response->size > 0)
+    {
+        if (item->format == HK_FORMAT_STRING)
+        {
+            hk_mem_append_string_terminator(item->write_response);
+        }
+
+        cJSON_AddItemToObject(j_result, "value", hk_accessories_serializer_format_mem(item->format, item->write_response));
+    }
+    else
+    {
+        // the write callback did not produce a value, so we answer with the current one, if it still exists
+        hk_chr_t *chr = hk_accessories_store_get_chr(accessories, item->aid, item->iid);
+        if (chr != NULL)
+        {
+            hk_accessories_serializer_value(chr, j_result);
+        }
+    }
+}
+
+static int hk_chrs_status(esp_err_t ret)
+{
+    switch (ret)
+    {
+    case ESP_OK:
+        return HK_CHRS_STATUS_SUCCESS;
+    case ESP_ERR_NOT_FOUND:
+        return HK_CHRS_STATUS_RESOURCE_DOES_NOT_EXIST;
+    case ESP_ERR_NOT_SUPPORTED:
+        return HK_CHRS_STATUS_READ_ONLY;
+    case ESP_ERR_INVALID_ARG:
+        return HK_CHRS_STATUS_INVALID_VALUE;
+    default:
+        return HK_CHRS_STATUS_COMMUNICATION_FAILURE;
+    }
+}
+
+static esp_err_t hk_chr_subscribe(hk_accessory_t *accessories, int socket, int aid, int iid)
 {
     esp_err_t ret = ESP_OK;
     HK_LOGV("%d - Subscription request for chr %d.%d.", socket, aid, iid);
 
-    hk_chr_t *chr = hk_accessories_store_get_chr(aid, iid);
+    hk_chr_t *chr = hk_accessories_store_get_chr(accessories, aid, iid);
     if (chr == NULL)
     {
         HK_LOGE("Could not find chr %d.%d.", aid, iid);
         ret = ESP_ERR_NOT_FOUND;
     }
 
-    RUN_AND_CHECK(ret, hk_subscription_store_add, chr, socket);
+    // the subscriptions are owned by the core task
+    RUN_AND_CHECK(ret, hk_core_post, HK_CORE_EVENT_SUBSCRIBE, chr, socket);
 
     //todo: hk_chrs_notify(chr);
     return ret;
 }
 
-static esp_err_t hk_chr_unsubscribe(int socket, int aid, int iid)
+static esp_err_t hk_chr_unsubscribe(hk_accessory_t *accessories, int socket, int aid, int iid)
 {
     esp_err_t ret = ESP_OK;
-    hk_chr_t *chr = hk_accessories_store_get_chr(aid, iid);
+    hk_chr_t *chr = hk_accessories_store_get_chr(accessories, aid, iid);
     HK_LOGD("%d - Request for removing subscription for chr %d.%d (%x).", socket, aid, iid, (unsigned int)chr);
     if (chr == NULL)
     {
@@ -277,80 +377,357 @@ static esp_err_t hk_chr_unsubscribe(int socket, int aid, int iid)
         ret = ESP_ERR_NOT_FOUND;
     }
 
-    RUN_AND_CHECK(ret, hk_subscription_store_remove, chr, socket);
+    RUN_AND_CHECK(ret, hk_core_post, HK_CORE_EVENT_UNSUBSCRIBE, chr, socket);
+
+    return ret;
+}
+
+static esp_err_t hk_chrs_read_bool(hk_json_token_t *token, bool *result)
+{
+    hk_value_t value;
+    if ((token->type != HK_JSON_TRUE && token->type != HK_JSON_FALSE && token->type != HK_JSON_NUMBER) ||
+        hk_value_parse(HK_FORMAT_BOOL, token->ptr, token->length, &value) != ESP_OK)
+    {
+        HK_LOGE("Expected a boolean in chrs put.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *result = value.b;
+    return ESP_OK;
+}
+
+static esp_err_t hk_chrs_read_id(hk_json_token_t *token, size_t *result)
+{
+    hk_value_t value;
+    if (token->type != HK_JSON_NUMBER || hk_value_parse(HK_FORMAT_UINT32, token->ptr, token->length, &value) != ESP_OK)
+    {
+        HK_LOGE("Expected an id in chrs put.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *result = value.u32;
+    return ESP_OK;
+}
+
+static esp_err_t hk_chrs_read_put_item(hk_json_reader_t *reader, hk_chrs_put_item_t *item)
+{
+    esp_err_t ret = ESP_OK;
+    bool has_aid = false;
+    bool has_iid = false;
+    hk_json_token_t key;
+    hk_json_token_t token;
+
+    memset(item, 0, sizeof(hk_chrs_put_item_t));
+
+    while (ret == ESP_OK)
+    {
+        ret = hk_json_reader_next(reader, &key);
+        if (ret != ESP_OK || key.type == HK_JSON_OBJECT_END)
+        {
+            break;
+        }
+
+        RUN_AND_CHECK(ret, hk_json_reader_next, reader, &token);
+        if (ret != ESP_OK)
+        {
+            break;
+        }
+
+        if (hk_json_token_equal_str(&key, "aid"))
+        {
+            ret = hk_chrs_read_id(&token, &item->aid);
+            has_aid = true;
+        }
+        else if (hk_json_token_equal_str(&key, "iid"))
+        {
+            ret = hk_chrs_read_id(&token, &item->iid);
+            has_iid = true;
+        }
+        else if (hk_json_token_equal_str(&key, "value"))
+        {
+            item->value = token;
+            item->has_value = true;
+            ret = hk_json_reader_skip(reader, &token);
+        }
+        else if (hk_json_token_equal_str(&key, "ev"))
+        {
+            ret = hk_chrs_read_bool(&token, &item->ev);
+            item->has_ev = true;
+        }
+        else if (hk_json_token_equal_str(&key, "r"))
+        {
+            ret = hk_chrs_read_bool(&token, &item->response_requested);
+        }
+        else
+        {
+            // e.g. authData, remote or pid
+            ret = hk_json_reader_skip(reader, &token);
+        }
+    }
+
+    if (ret == ESP_OK && (!has_aid || !has_iid))
+    {
+        HK_LOGE("Could not find aid and iid of element in chrs put.");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    return ret;
+}
+
+static void hk_chrs_put_prepare(hk_accessory_t *accessories, int socket, hk_chrs_put_item_t *item)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (item->has_ev)
+    {
+        if (item->ev)
+        {
+            ret = hk_chr_subscribe(accessories, socket, item->aid, item->iid);
+        }
+        else
+        {
+            ret = hk_chr_unsubscribe(accessories, socket, item->aid, item->iid);
+        }
+    }
+    else
+    {
+        hk_chr_t *chr = hk_accessories_store_get_chr(accessories, item->aid, item->iid);
+        if (chr == NULL)
+        {
+            HK_LOGE("%d - Could not find chr %d.%d.", socket, item->aid, item->iid);
+            ret = ESP_ERR_NOT_FOUND;
+        }
+        else if (!item->has_value)
+        {
+            HK_LOGE("%d - Could not write chr %d.%d. No value was given.", socket, item->aid, item->iid);
+            ret = ESP_ERR_INVALID_ARG;
+        }
+
+        RUN_AND_CHECK(ret, hk_chrs_write_prepare, socket, chr, item);
+    }
+
+    item->status = hk_chrs_status(ret);
+}
+
+static esp_err_t hk_chrs_put_chrs(hk_json_reader_t *reader, size_t skip, hk_chrs_put_item_t *items, size_t *count)
+{
+    esp_err_t ret = ESP_OK;
+    hk_json_token_t token;
+    hk_chrs_put_item_t item;
+
+    RUN_AND_CHECK(ret, hk_json_reader_next, reader, &token);
+    if (ret == ESP_OK && token.type != HK_JSON_ARRAY_START)
+    {
+        HK_LOGE("Expected characteristics to be an array.");
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    while (ret == ESP_OK)
+    {
+        ret = hk_json_reader_next(reader, &token);
+        if (ret != ESP_OK || token.type == HK_JSON_ARRAY_END)
+        {
+            break;
+        }
+
+        if (token.type != HK_JSON_OBJECT_START)
+        {
+            HK_LOGE("Expected characteristic to be an object.");
+            ret = ESP_ERR_INVALID_ARG;
+        }
+
+        // items outside of the window are read for validation and counted only
+        RUN_AND_CHECK(ret, hk_chrs_read_put_item, reader, &item);
+        if (ret == ESP_OK && *count >= skip && *count < skip + HK_CHRS_PUT_MAX_ITEMS)
+        {
+            items[*count - skip] = item;
+        }
+
+        (*count)++;
+    }
 
     return ret;
 }
 
-esp_err_t hk_chrs_put(hk_mem *request, void *http_handle, int socket)
+static esp_err_t hk_chrs_put_read(hk_mem *request, size_t skip, hk_chrs_put_item_t *items, size_t *count)
 {
     esp_err_t ret = ESP_OK;
+    hk_json_reader_t reader;
+    hk_json_token_t token;
+
+    *count = 0;
+    hk_json_reader_init(&reader, request->ptr, request->size);
 
-    char *content = hk_mem_to_string(request);
-    cJSON *j_root = cJSON_Parse((const char *)content);
-    if (j_root == NULL)
+    RUN_AND_CHECK(ret, hk_json_reader_next, &reader, &token);
+    if (ret == ESP_OK && token.type != HK_JSON_OBJECT_START)
     {
         HK_LOGE("Failed to parse request for chrs put.");
         ret = ESP_ERR_INVALID_ARG;
     }
 
+    while (ret == ESP_OK)
+    {
+        ret = hk_json_reader_next(&reader, &token);
+        if (ret != ESP_OK || token.type == HK_JSON_OBJECT_END)
+        {
+            break;
+        }
+
+        if (hk_json_token_equal_str(&token, "characteristics"))
+        {
+            ret = hk_chrs_put_chrs(&reader, skip, items, count);
+        }
+        else
+        {
+            RUN_AND_CHECK(ret, hk_json_reader_next, &reader, &token);
+            RUN_AND_CHECK(ret, hk_json_reader_skip, &reader, &token);
+        }
+    }
+
+    RUN_AND_CHECK(ret, hk_json_reader_next, &reader, &token);
+
+    return ret;
+}
+
+static void hk_chrs_put_results(hk_accessory_t *accessories, hk_chrs_put_item_t *items, size_t count, cJSON *j_results)
+{
+    // a multi status response lists every characteristic of the request, successful writes with status 0
+    for (size_t i = 0; i < count; i++)
+    {
+        cJSON *j_result = cJSON_CreateObject();
+        cJSON_AddNumberToObject(j_result, "aid", items[i].aid);
+        cJSON_AddNumberToObject(j_result, "iid", items[i].iid);
+        cJSON_AddNumberToObject(j_result, "status", items[i].status);
+        if (items[i].status == HK_CHRS_STATUS_SUCCESS && items[i].response_requested && !items[i].has_ev)
+        {
+            hk_chrs_write_response_value(accessories, &items[i], j_result);
+        }
+
+        cJSON_AddItemToArray(j_results, j_result);
+    }
+}
+
+static void hk_chrs_put_respond(cJSON *j_results, hk_mem *response)
+{
+    cJSON *j_root = cJSON_CreateObject();
+    cJSON_AddItemToObject(j_root, "characteristics", j_results);
+
+    char *serialized = cJSON_PrintUnformatted(j_root);
+    hk_mem_append_string(response, (const char *)serialized);
+    free(serialized);
+    cJSON_Delete(j_root);
+}
+
+static void hk_chrs_put_reject(hk_mem *request, size_t count, hk_chrs_put_item_t *items, hk_mem *response)
+{
+    // the request is read again in windows of the item array, to list every characteristic as not written
+    cJSON *j_results = cJSON_CreateArray();
+    size_t window_count = 0;
+
+    HK_LOGE("Could not write %d chrs in one request, at most %d are supported.", count, HK_CHRS_PUT_MAX_ITEMS);
+    for (size_t skip = 0; skip < count; skip += HK_CHRS_PUT_MAX_ITEMS)
+    {
+        hk_chrs_put_read(request, skip, items, &window_count);
+        size_t window_size = MIN(count - skip, HK_CHRS_PUT_MAX_ITEMS);
+        for (size_t i = 0; i < window_size; i++)
+        {
+            items[i].status = HK_CHRS_STATUS_OUT_OF_RESOURCES;
+        }
+
+        hk_chrs_put_results(NULL, items, window_size, j_results);
+    }
+
+    hk_chrs_put_respond(j_results, response);
+}
+
+esp_err_t hk_chrs_put(hk_mem *request, void *http_handle, int socket, hk_mem *response)
+{
+    esp_err_t ret = ESP_OK;
+    hk_chrs_put_item_t items[HK_CHRS_PUT_MAX_ITEMS];
+    size_t count = 0;
+
+    // the request is read in place, strings are unescaped inside of it
+    ret = hk_chrs_put_read(request, 0, items, &count);
+
+    if (ret == ESP_OK && count > HK_CHRS_PUT_MAX_ITEMS)
+    {
+        // nothing is written
+        hk_chrs_put_reject(request, count, items, response);
+        return ESP_OK;
+    }
+
+    // the whole request is valid, before the first characteristic is written
+    bool needs_results = false;
     if (ret == ESP_OK)
     {
-        cJSON *j_chrs = cJSON_GetObjectItem(j_root, "characteristics");
-        for (int i = 0; i < cJSON_GetArraySize(j_chrs) && ret == ESP_OK; i++)
+        uint8_t store_reader;
+        hk_accessory_t *accessories = hk_accessories_store_read_lock(&store_reader);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            hk_chrs_put_prepare(accessories, socket, &items[i]);
+        }
+
+        hk_accessories_store_read_unlock(store_reader);
+
+        // write callbacks may reconfigure the accessories, which waits for all readers
+        for (size_t i = 0; i < count; i++)
         {
-            cJSON *j_chr = cJSON_GetArrayItem(j_chrs, i);
-            if (j_chr == NULL)
+            if (items[i].status == HK_CHRS_STATUS_SUCCESS && !items[i].has_ev)
             {
-                HK_LOGE("Could not find first element in chrs put.");
-                ret = ESP_ERR_INVALID_ARG;
-                break;
+                items[i].status = hk_chrs_status(hk_chrs_write(socket, &items[i]));
             }
 
-            cJSON *j_aid = cJSON_GetObjectItem(j_chr, "aid");
-            cJSON *j_iid = cJSON_GetObjectItem(j_chr, "iid");
+            needs_results |= items[i].status != HK_CHRS_STATUS_SUCCESS || items[i].response_requested;
+        }
 
-            int aid = j_aid->valueint;
-            int iid = j_iid->valueint;
+        if (needs_results)
+        {
+            accessories = hk_accessories_store_read_lock(&store_reader);
+            cJSON *j_results = cJSON_CreateArray();
+            hk_chrs_put_results(accessories, items, count, j_results);
+            hk_chrs_put_respond(j_results, response);
+            hk_accessories_store_read_unlock(store_reader);
+        }
 
-            if (cJSON_HasObjectItem(j_chr, "ev"))
-            {
-                cJSON *j_ev = cJSON_GetObjectItem(j_chr, "ev");
-
-                if (cJSON_IsTrue(j_ev))
-                {
-                    RUN_AND_CHECK(ret, hk_chr_subscribe, socket, aid, iid);
-                }
-                else
-                {
-                    RUN_AND_CHECK(ret, hk_chr_unsubscribe, socket, aid, iid);
-                }
-            }
-            else
+        for (size_t i = 0; i < count; i++)
+        {
+            if (items[i].write_response != NULL)
             {
-                RUN_AND_CHECK(ret, hk_chrs_write, socket, aid, iid, j_chr);
+                hk_mem_free(items[i].write_response);
             }
         }
     }
 
-    cJSON_Delete(j_root);
-    free(content);
-
     return ret;
 }
 
 esp_err_t hk_chrs_identify(int socket)
 {
-    hk_chr_t *chr = hk_accessories_store_get_identify_chr();
+    esp_err_t ret = ESP_OK;
+    esp_err_t (*write)(hk_mem *request) = NULL;
+    uint8_t reader;
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
+
+    hk_chr_t *chr = hk_accessories_store_get_identify_chr(accessories);
     if (chr == NULL)
     {
         HK_LOGE("Could not find identify chr.");
-        return ESP_ERR_NOT_FOUND;
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    else
+    {
+        write = chr->write;
     }
 
-    esp_err_t ret = ESP_OK;
-    HK_LOGD("%d - Calling write on identify chr!", socket);
-    RUN_AND_CHECK(ret, chr->write, NULL);
+    hk_accessories_store_read_unlock(reader);
+
+    // like the write of other characteristics, the callback is called after the accessories are unlocked
+    if (ret == ESP_OK)
+    {
+        HK_LOGD("%d - Calling write on identify chr!", socket);
+        RUN_AND_CHECK(ret, write, NULL);
+    }
 
     return ret;
 }
\ No newline at end of file
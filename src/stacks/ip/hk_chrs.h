@@ -1,11 +1,20 @@
 #pragma once
 
 #include "../../include/hk_mem.h"
+#include "../../common/hk_core.h"
 
 #include <stdio.h>
 #include <esp_err.h>
 
+#define HK_CHRS_STATUS_SUCCESS 0
+#define HK_CHRS_STATUS_COMMUNICATION_FAILURE -70402
+#define HK_CHRS_STATUS_READ_ONLY -70404
+#define HK_CHRS_STATUS_OUT_OF_RESOURCES -70407
+#define HK_CHRS_STATUS_RESOURCE_DOES_NOT_EXIST -70409
+#define HK_CHRS_STATUS_INVALID_VALUE -70410
+
 esp_err_t hk_chrs_get(char *ids, hk_mem *response);
-esp_err_t hk_chrs_put(hk_mem *request, void *http_handle, int socket);
+esp_err_t hk_chrs_put(hk_mem *request, void *http_handle, int socket, hk_mem *response);
 esp_err_t hk_chrs_identify(int socket);
-esp_err_t hk_chrs_notify(void *chr);
\ No newline at end of file
+esp_err_t hk_chrs_notify(void *chr);
+void hk_chrs_handle_event(hk_core_event_t *event);
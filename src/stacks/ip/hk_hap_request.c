@@ -0,0 +1,134 @@
+#include "hk_hap_request.h"
+
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+
+#include "../../utils/hk_slice.h"
+
+#define HK_HAP_REQUEST_CONTENT_LENGTH "Content-Length:"
+
+static size_t hk_hap_request_find_headers_end(hk_mem *received)
+{
+    size_t size = received->size < HK_HAP_REQUEST_MAX_SIZE ? received->size : HK_HAP_REQUEST_MAX_SIZE;
+
+    for (size_t i = 3; i < size; i++)
+    {
+        if (memcmp(received->ptr + i - 3, "\r\n\r\n", 4) == 0)
+        {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+static hk_slice_t hk_hap_request_trim(hk_slice_t slice)
+{
+    while (slice.size > 0 && (slice.ptr[0] == ' ' || slice.ptr[0] == '\t'))
+    {
+        slice = hk_slice_sub(slice, 1, slice.size - 1);
+    }
+
+    while (slice.size > 0 && (slice.ptr[slice.size - 1] == ' ' || slice.ptr[slice.size - 1] == '\t'))
+    {
+        slice.size--;
+    }
+
+    return slice;
+}
+
+static esp_err_t hk_hap_request_get_content_size(hk_slice_t headers, size_t *content_size)
+{
+    size_t name_size = strlen(HK_HAP_REQUEST_CONTENT_LENGTH);
+    bool found = false;
+
+    *content_size = 0;
+
+    // the headers begin with the request line and every line is terminated by \r\n
+    while (headers.size > 0)
+    {
+        const char *end = memchr(headers.ptr, '\r', headers.size);
+        size_t line_size = end != NULL ? end - headers.ptr : headers.size;
+        hk_slice_t line = hk_slice_sub(headers, 0, line_size);
+        headers = hk_slice_sub(headers, line_size + 2, headers.size);
+
+        if (line.size < name_size || strncasecmp(line.ptr, HK_HAP_REQUEST_CONTENT_LENGTH, name_size) != 0)
+        {
+            continue;
+        }
+
+        if (found)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        hk_slice_t value = hk_hap_request_trim(hk_slice_sub(line, name_size, line.size));
+        if (hk_slice_to_size(value, content_size) != ESP_OK)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        found = true;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hk_hap_request_parse(hk_mem *received, hk_hap_request_t *request)
+{
+    memset(request, 0, sizeof(hk_hap_request_t));
+
+    size_t headers_size = hk_hap_request_find_headers_end(received);
+    if (headers_size == 0)
+    {
+        return received->size > HK_HAP_REQUEST_MAX_SIZE ? ESP_ERR_INVALID_SIZE : ESP_OK;
+    }
+
+    // the request line looks like: METHOD URI VERSION
+    hk_slice_t headers = hk_slice_init(received->ptr, headers_size);
+    const char *line_end = memchr(headers.ptr, '\r', headers.size);
+    char *uri = memchr(received->ptr, ' ', line_end - headers.ptr);
+    char *version = uri != NULL ? memchr(uri + 1, ' ', line_end - uri - 1) : NULL;
+    if (version == NULL || uri == received->ptr || version == uri + 1)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t content_size = 0;
+    esp_err_t ret = hk_hap_request_get_content_size(hk_slice_sub(headers, line_end - headers.ptr + 2, headers.size), &content_size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    // compared without adding, as the content size is controlled by the peer
+    if (content_size > HK_HAP_REQUEST_MAX_SIZE - headers_size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (received->size - headers_size < content_size)
+    {
+        // the content is not complete yet
+        return ESP_OK;
+    }
+
+    *uri++ = '\0';
+    *version = '\0';
+
+    request->method = received->ptr;
+    request->uri = uri;
+    request->content.ptr = received->ptr + headers_size;
+    request->content.size = content_size;
+    request->size = headers_size + content_size;
+
+    return ESP_OK;
+}
+
+void hk_hap_request_consume(hk_mem *received, hk_hap_request_t *request)
+{
+    memmove(received->ptr, received->ptr + request->size, received->size - request->size);
+    hk_mem_set(received, received->size - request->size);
+    memset(request, 0, sizeof(hk_hap_request_t));
+}
@@ -0,0 +1,50 @@
+/**
+ * @file hk_hap_request.h
+ *
+ * Frames the http requests of the built-in HAP server.
+ *
+ * Requests are taken from the plain data received on a connection. The data may contain a part of a request or
+ * several pipelined requests. Only Content-Length is supported to frame the content.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <esp_err.h>
+
+#include "../../include/hk_mem.h"
+
+#define HK_HAP_REQUEST_MAX_SIZE 8192 // headers and content of one request
+
+typedef struct
+{
+    char *method;   // zero terminated, in the received data
+    char *uri;      // zero terminated, in the received data
+    hk_mem content; // points into the received data, does not own it
+    size_t size;    // size of headers and content, 0 if the request is not complete yet
+} hk_hap_request_t;
+
+/**
+ * @brief Parses the first request of the received data.
+ *
+ * Parses the first request. If it is complete, method and uri are terminated in place and the content points into the
+ * received data. If it is not complete, the received data is not changed and the size of the request is 0.
+ *
+ * @param received The received plain data.
+ * @param request The request.
+ *
+ * @return Returns ESP_ERR_INVALID_SIZE, if the request is larger than HK_HAP_REQUEST_MAX_SIZE, and ESP_ERR_INVALID_ARG,
+ * if the request line or the Content-Length is invalid.
+ */
+esp_err_t hk_hap_request_parse(hk_mem *received, hk_hap_request_t *request);
+
+/**
+ * @brief Removes a parsed request from the received data.
+ *
+ * Removes the request, so the next request begins at the start of the received data. Method, uri and content of the
+ * request are invalid afterwards.
+ *
+ * @param received The received plain data.
+ * @param request The request, which was parsed completely.
+ */
+void hk_hap_request_consume(hk_mem *received, hk_hap_request_t *request);
@@ -0,0 +1,785 @@
+#include "hk_server.h"
+
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "../../crypto/hk_chacha20poly1305.h"
+#include "../../utils/hk_logging.h"
+#include "../../utils/hk_util.h"
+#include "../../utils/hk_alloc.h"
+#include "../../utils/hk_queue.h"
+#include "../../utils/hk_recorder.h"
+#include "../../utils/hk_tasks.h"
+#include "../../common/hk_core.h"
+#include "../../common/hk_conn_key_store.h"
+#include "../../common/hk_pair_setup.h"
+#include "../../common/hk_pair_verify.h"
+#include "../../common/hk_pairings.h"
+#include "../../common/hk_pairings_store.h"
+#include "hk_chrs.h"
+#include "hk_advertising.h"
+#include "hk_accessories_serializer.h"
+#include "hk_server_transport.h"
+#include "hk_hap_request.h"
+
+#define HK_HAP_SERVER_PORT 5556
+#define HK_HAP_SERVER_MAX_CONNECTIONS 8     // refer to spec 6.2.3, at least eight connections are required
+#define HK_HAP_SERVER_MAX_TX_SIZE 32768    // responses and events, which were not sent yet
+#define HK_HAP_SERVER_FRAME_SIZE 1024       // refer to spec 6.5.2
+#define HK_HAP_SERVER_AAD_SIZE 2
+#define HK_HAP_SERVER_AUTHTAG_SIZE 16
+#define HK_HAP_SERVER_QUEUE_SIZE 32
+#define HK_HAP_SERVER_TASK_STACK_SIZE 8192
+
+#define HK_HAP_SERVER_CONTENT_TLV "application/pairing+tlv8"
+#define HK_HAP_SERVER_CONTENT_JSON "application/hap+json"
+#define HK_HAP_SERVER_STATUS_200 "200 OK"
+#define HK_HAP_SERVER_STATUS_204 "204 No Content"
+#define HK_HAP_SERVER_STATUS_207 "207 Multi-Status"
+#define HK_HAP_SERVER_STATUS_404 "404 Not Found"
+#define HK_HAP_SERVER_STATUS_470 "470 Connection Authorization Required"
+#define HK_HAP_SERVER_REJECTED_RESPONSE "{\"status\":-70401}" // spec table 6.11: insufficient privileges
+
+typedef struct
+{
+    int socket; // -1 if the slot is unused
+    bool is_secure;
+    size_t received_frame_count;
+    size_t sent_frame_count;
+    hk_conn_key_store_t *keys;
+    hk_mem *device_id;
+    hk_mem *encrypted; // received frames, which are not complete yet
+    hk_mem *received;  // received plain data of requests, which are not complete yet
+    hk_mem *tx;        // data to send, already encrypted if the session is secure
+    size_t tx_sent;
+    bool close_after_tx;
+} hk_hap_server_connection_t;
+
+typedef struct
+{
+    const char *status;
+    const char *type;
+    hk_mem *content;
+    bool session_secure; // the session is secure after this response
+    bool session_close;  // the session is closed after this response
+} hk_hap_server_response_t;
+
+typedef enum
+{
+    HK_HAP_SERVER_ACCESS_ALWAYS,
+    HK_HAP_SERVER_ACCESS_UNPAIRED_OR_VERIFIED,
+    HK_HAP_SERVER_ACCESS_VERIFIED
+} hk_hap_server_access_t;
+
+typedef struct
+{
+    const char *method;
+    const char *path;
+    hk_hap_server_access_t access;
+    esp_err_t (*handler)(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response);
+} hk_hap_server_route_t;
+
+typedef struct
+{
+    int socket;
+    hk_mem *message;
+} hk_hap_server_event_t;
+
+hk_hap_server_connection_t hk_hap_server_connections[HK_HAP_SERVER_MAX_CONNECTIONS];
+hk_queue_t hk_hap_server_events;
+int hk_hap_server_listen_socket = -1;
+int hk_hap_server_control_socket = -1;
+struct sockaddr_in hk_hap_server_control_address;
+size_t hk_hap_server_rejected_count = 0;
+bool hk_hap_server_started = false;
+
+static esp_err_t hk_hap_server_accessories_get(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    // the content is empty yet, so it can be moved to the region of the accessories
+    response->content->subsystem = HK_ALLOC_ACCESSORIES;
+    esp_err_t ret = hk_accessories_serializer_accessories(response->content);
+    response->type = HK_HAP_SERVER_CONTENT_JSON;
+
+    return ret;
+}
+
+static esp_err_t hk_hap_server_characteristics_get(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    char *ids = NULL;
+
+    // the query is zero terminated and looks like id=1.2,1.3&ev=1
+    for (char *parameter = query; parameter != NULL && *parameter != '\0'; parameter = strchr(parameter, '&'))
+    {
+        parameter += *parameter == '&' ? 1 : 0;
+        if (strncmp(parameter, "id=", 3) == 0)
+        {
+            ids = parameter + 3;
+        }
+    }
+
+    if (ids == NULL)
+    {
+        HK_LOGE("%d - Could not find ids in query of characteristics get.", connection->socket);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char *ids_end = strchr(ids, '&');
+    if (ids_end != NULL)
+    {
+        *ids_end = '\0';
+    }
+
+    response->type = HK_HAP_SERVER_CONTENT_JSON;
+    return hk_chrs_get(ids, response->content);
+}
+
+static esp_err_t hk_hap_server_characteristics_put(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    esp_err_t ret = hk_chrs_put(content, NULL, connection->socket, response->content);
+
+    if (response->content->size > 0)
+    {
+        // write responses or errors were requested, so we answer with the status of every characteristic
+        response->status = HK_HAP_SERVER_STATUS_207;
+        response->type = HK_HAP_SERVER_CONTENT_JSON;
+    }
+    else
+    {
+        response->status = HK_HAP_SERVER_STATUS_204;
+    }
+
+    return ret;
+}
+
+static esp_err_t hk_hap_server_identify_post(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    response->status = HK_HAP_SERVER_STATUS_204;
+    return hk_chrs_identify(connection->socket);
+}
+
+static esp_err_t hk_hap_server_pair_setup_post(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    response->type = HK_HAP_SERVER_CONTENT_TLV;
+    return hk_pair_setup(content, response->content, connection->keys);
+}
+
+static esp_err_t hk_hap_server_pair_verify_post(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    response->type = HK_HAP_SERVER_CONTENT_TLV;
+    return hk_pair_verify(content, response->content, connection->keys, connection->device_id, &response->session_secure);
+}
+
+static esp_err_t hk_hap_server_pairings_post(hk_hap_server_connection_t *connection, char *query, hk_mem *content, hk_hap_server_response_t *response)
+{
+    bool is_paired = false;
+    esp_err_t ret = hk_pairings(connection->device_id, content, response->content, &response->session_close, &is_paired);
+    response->type = HK_HAP_SERVER_CONTENT_TLV;
+
+    if (!is_paired)
+    {
+        hk_advertising_update_paired();
+    }
+
+    return ret;
+}
+
+static const hk_hap_server_route_t hk_hap_server_routes[] = {
+    {"GET", "/accessories", HK_HAP_SERVER_ACCESS_VERIFIED, hk_hap_server_accessories_get},
+    {"GET", "/characteristics", HK_HAP_SERVER_ACCESS_VERIFIED, hk_hap_server_characteristics_get},
+    {"PUT", "/characteristics", HK_HAP_SERVER_ACCESS_VERIFIED, hk_hap_server_characteristics_put},
+    {"POST", "/identify", HK_HAP_SERVER_ACCESS_UNPAIRED_OR_VERIFIED, hk_hap_server_identify_post},
+    {"POST", "/pair-setup", HK_HAP_SERVER_ACCESS_ALWAYS, hk_hap_server_pair_setup_post},
+    {"POST", "/pair-verify", HK_HAP_SERVER_ACCESS_ALWAYS, hk_hap_server_pair_verify_post},
+    {"POST", "/pairings", HK_HAP_SERVER_ACCESS_VERIFIED, hk_hap_server_pairings_post},
+};
+
+static void hk_hap_server_consume(hk_mem *mem, size_t size)
+{
+    memmove(mem->ptr, mem->ptr + size, mem->size - size);
+    hk_mem_set(mem, mem->size - size);
+}
+
+static esp_err_t hk_hap_server_queue(hk_hap_server_connection_t *connection, const char *data, size_t size)
+{
+    // a peer, which does not read, must not make us buffer without limit; one message is always taken, as the
+    // accessories of a large bridge may exceed the limit on their own
+    size_t pending = connection->tx->size - connection->tx_sent;
+    if (pending > 0 && size > HK_HAP_SERVER_MAX_TX_SIZE - MIN(pending, HK_HAP_SERVER_MAX_TX_SIZE))
+    {
+        HK_LOGE("%d - Could not queue %d bytes, as the peer does not read.", connection->socket, size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!connection->is_secure)
+    {
+        hk_mem_append_buffer(connection->tx, (void *)data, size);
+        return ESP_OK;
+    }
+
+    char nonce[12] = {
+        0,
+    };
+
+    while (size > 0)
+    {
+        size_t chunk_size = MIN(size, HK_HAP_SERVER_FRAME_SIZE);
+        size_t offset = connection->tx->size;
+        hk_mem_set(connection->tx, offset + HK_HAP_SERVER_AAD_SIZE + chunk_size + HK_HAP_SERVER_AUTHTAG_SIZE);
+
+        char *frame = connection->tx->ptr + offset;
+        frame[0] = chunk_size % 256;
+        frame[1] = chunk_size / 256;
+        nonce[4] = connection->sent_frame_count % 256;
+        nonce[5] = connection->sent_frame_count++ / 256;
+
+        esp_err_t ret = hk_chacha20poly1305_encrypt_buffer(HK_CONN_KEY_STORE_MEM(connection->keys->response_key), nonce, frame, HK_HAP_SERVER_AAD_SIZE,
+                                                           (char *)data, frame + HK_HAP_SERVER_AAD_SIZE, chunk_size);
+        if (ret != ESP_OK)
+        {
+            HK_LOGE("%d - Could not encrypt frame.", connection->socket);
+            return ret;
+        }
+
+        data += chunk_size;
+        size -= chunk_size;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_hap_server_decrypt(hk_hap_server_connection_t *connection)
+{
+    char nonce[12] = {
+        0,
+    };
+
+    while (connection->encrypted->size >= HK_HAP_SERVER_AAD_SIZE)
+    {
+        char *frame = connection->encrypted->ptr;
+        size_t message_size = (uint8_t)frame[0] + (uint8_t)frame[1] * 256;
+        size_t frame_size = HK_HAP_SERVER_AAD_SIZE + message_size + HK_HAP_SERVER_AUTHTAG_SIZE;
+
+        if (message_size > HK_HAP_SERVER_FRAME_SIZE)
+        {
+            HK_LOGE("%d - Received frame of %d bytes, which is too large.", connection->socket, message_size);
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        if (connection->encrypted->size < frame_size)
+        {
+            // the frame is not complete yet
+            break;
+        }
+
+        nonce[4] = connection->received_frame_count % 256;
+        nonce[5] = connection->received_frame_count++ / 256;
+
+        size_t offset = connection->received->size;
+        hk_mem_set(connection->received, offset + message_size);
+        esp_err_t ret = hk_chacha20poly1305_decrypt_buffer(HK_CONN_KEY_STORE_MEM(connection->keys->request_key), nonce, frame, HK_HAP_SERVER_AAD_SIZE,
+                                                           frame + HK_HAP_SERVER_AAD_SIZE, connection->received->ptr + offset, message_size);
+        if (ret != ESP_OK)
+        {
+            HK_LOGE("%d - Could not decrypt frame.", connection->socket);
+            return ret;
+        }
+
+        HK_RECORDER_RECORD(HK_RECORDER_IP_REQUEST, connection->socket, connection->received->ptr + offset, message_size);
+        hk_hap_server_consume(connection->encrypted, frame_size);
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_hap_server_respond(hk_hap_server_connection_t *connection, hk_hap_server_response_t *response)
+{
+    esp_err_t ret = ESP_OK;
+    char headers[128];
+    int headers_size = 0;
+
+    if (response->type != NULL)
+    {
+        headers_size = snprintf(headers, sizeof(headers), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n\r\n",
+                                response->status, response->type, response->content->size);
+    }
+    else
+    {
+        headers_size = snprintf(headers, sizeof(headers), "HTTP/1.1 %s\r\nContent-Length: %d\r\n\r\n",
+                                response->status, response->content->size);
+    }
+
+    // headers and content are encrypted together, to send as few frames as possible
+    hk_mem *message = hk_mem_init();
+    hk_mem_append_buffer(message, headers, headers_size);
+    hk_mem_append(message, response->content);
+
+    HK_RECORDER_RECORD(HK_RECORDER_IP_RESPONSE, connection->socket, message->ptr, message->size);
+    RUN_AND_CHECK(ret, hk_hap_server_queue, connection, message->ptr, message->size);
+    HK_LOGV("%d - Responding: \n%.*s", connection->socket, message->size, message->ptr);
+
+    hk_mem_free(message);
+
+    return ret;
+}
+
+static bool hk_hap_server_is_allowed(hk_hap_server_connection_t *connection, const hk_hap_server_route_t *route)
+{
+    bool paired = true;
+
+    switch (route->access)
+    {
+    case HK_HAP_SERVER_ACCESS_ALWAYS:
+        return true;
+    case HK_HAP_SERVER_ACCESS_UNPAIRED_OR_VERIFIED:
+        // spec 5.7.6: identify is allowed without verification, as long as the accessory is not paired
+        hk_pairings_store_has_pairing(&paired);
+        return !paired || connection->is_secure;
+    default:
+        return connection->is_secure;
+    }
+}
+
+static esp_err_t hk_hap_server_dispatch(hk_hap_server_connection_t *connection, char *method, char *uri, hk_mem *content)
+{
+    esp_err_t ret = ESP_OK;
+    hk_hap_server_response_t response = {
+        .status = HK_HAP_SERVER_STATUS_200,
+        .type = NULL,
+        .content = hk_mem_init(),
+        .session_secure = false,
+        .session_close = false};
+
+    char *query = strchr(uri, '?');
+    if (query != NULL)
+    {
+        *query++ = '\0';
+    }
+
+    const hk_hap_server_route_t *route = NULL;
+    for (size_t i = 0; i < sizeof(hk_hap_server_routes) / sizeof(hk_hap_server_route_t); i++)
+    {
+        if (strcmp(hk_hap_server_routes[i].method, method) == 0 && strcmp(hk_hap_server_routes[i].path, uri) == 0)
+        {
+            route = &hk_hap_server_routes[i];
+            break;
+        }
+    }
+
+    if (route == NULL)
+    {
+        HK_LOGW("%d - No route for %s %s.", connection->socket, method, uri);
+        response.status = HK_HAP_SERVER_STATUS_404;
+    }
+    else if (!hk_hap_server_is_allowed(connection, route))
+    {
+        hk_hap_server_rejected_count++;
+        HK_LOGW("%d - Rejecting %s, as the session is not verified (%d rejected).", connection->socket, uri, hk_hap_server_rejected_count);
+        response.status = HK_HAP_SERVER_STATUS_470;
+        response.type = HK_HAP_SERVER_CONTENT_JSON;
+        hk_mem_append_string(response.content, HK_HAP_SERVER_REJECTED_RESPONSE);
+    }
+    else
+    {
+        ret = route->handler(connection, query, content, &response);
+    }
+
+    // like esp_http_server, the connection is closed if a handler fails
+    RUN_AND_CHECK(ret, hk_hap_server_respond, connection, &response);
+
+    if (response.session_secure)
+    {
+        connection->is_secure = true;
+        HK_LOGD("%d - Pairing verified, now communicating encrypted.", connection->socket);
+    }
+
+    if (response.session_close)
+    {
+        connection->close_after_tx = true;
+    }
+
+    hk_mem_free(response.content);
+
+    return ret;
+}
+
+static esp_err_t hk_hap_server_process(hk_hap_server_connection_t *connection)
+{
+    esp_err_t ret = ESP_OK;
+    hk_hap_request_t request;
+
+    while (ret == ESP_OK && !connection->close_after_tx)
+    {
+        bool was_secure = connection->is_secure;
+        ret = hk_hap_request_parse(connection->received, &request);
+        if (ret != ESP_OK)
+        {
+            HK_LOGE("%d - Received invalid request: %s", connection->socket, esp_err_to_name(ret));
+            break;
+        }
+
+        if (request.size == 0)
+        {
+            // the request is not complete yet
+            break;
+        }
+
+        HK_LOGV("%d - Received %s %s with %d bytes.", connection->socket, request.method, request.uri, request.content.size);
+
+        // the content is passed without copying, handlers may change it in place
+        ret = hk_hap_server_dispatch(connection, request.method, request.uri, &request.content);
+
+        hk_hap_request_consume(connection->received, &request);
+
+        if (!was_secure && connection->is_secure && connection->received->size > 0)
+        {
+            // plain data sent along with pair verify must not be taken as a request of the verified session
+            HK_LOGE("%d - Received %d plain bytes after pair verify.", connection->socket, connection->received->size);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    return ret;
+}
+
+static void hk_hap_server_close(hk_hap_server_connection_t *connection)
+{
+    HK_LOGD("%d - Closing connection.", connection->socket);
+
+    // the socket number can be reused by the next connection, so the subscriptions must not stay behind
+    if (hk_core_post_blocking(HK_CORE_EVENT_UNSUBSCRIBE_ALL, NULL, connection->socket) != ESP_OK)
+    {
+        HK_LOGE("%d - Could not remove subscriptions.", connection->socket);
+    }
+
+    close(connection->socket);
+    hk_conn_key_store_free(connection->keys);
+    hk_mem_free(connection->device_id);
+    hk_mem_free(connection->encrypted);
+    hk_mem_free(connection->received);
+    hk_mem_free(connection->tx);
+    connection->socket = -1;
+}
+
+static esp_err_t hk_hap_server_send(hk_hap_server_connection_t *connection)
+{
+    size_t pending = connection->tx->size - connection->tx_sent;
+    if (pending > 0)
+    {
+        int sent = send(connection->socket, connection->tx->ptr + connection->tx_sent, pending, 0);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            HK_LOGW("%d - Error in send: %d", connection->socket, errno);
+            return ESP_FAIL;
+        }
+
+        connection->tx_sent += sent > 0 ? sent : 0;
+    }
+
+    if (connection->tx_sent == connection->tx->size)
+    {
+        hk_mem_set(connection->tx, 0);
+        connection->tx_sent = 0;
+
+        if (connection->close_after_tx)
+        {
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_hap_server_receive(hk_hap_server_connection_t *connection)
+{
+    esp_err_t ret = ESP_OK;
+    char buffer[HK_HAP_SERVER_AAD_SIZE + HK_HAP_SERVER_FRAME_SIZE + HK_HAP_SERVER_AUTHTAG_SIZE];
+
+    int received = recv(connection->socket, buffer, sizeof(buffer), 0);
+    if (received == 0)
+    {
+        HK_LOGD("%d - Connection closed by controller.", connection->socket);
+        return ESP_FAIL;
+    }
+    else if (received < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return ESP_OK;
+        }
+
+        HK_LOGW("%d - Error in recv: %d", connection->socket, errno);
+        return ESP_FAIL;
+    }
+
+    if (connection->is_secure)
+    {
+        hk_mem_append_buffer(connection->encrypted, buffer, received);
+        RUN_AND_CHECK(ret, hk_hap_server_decrypt, connection);
+    }
+    else
+    {
+        hk_mem_append_buffer(connection->received, buffer, received);
+        HK_RECORDER_RECORD(HK_RECORDER_IP_REQUEST, connection->socket, buffer, received);
+    }
+
+    RUN_AND_CHECK(ret, hk_hap_server_process, connection);
+    RUN_AND_CHECK(ret, hk_hap_server_send, connection);
+
+    return ret;
+}
+
+static void hk_hap_server_accept()
+{
+    struct sockaddr_in address;
+    socklen_t address_size = sizeof(address);
+    int socket = accept(hk_hap_server_listen_socket, (struct sockaddr *)&address, &address_size);
+    if (socket < 0)
+    {
+        HK_LOGW("Error in accept: %d", errno);
+        return;
+    }
+
+    hk_hap_server_connection_t *connection = NULL;
+    for (size_t i = 0; i < HK_HAP_SERVER_MAX_CONNECTIONS; i++)
+    {
+        if (hk_hap_server_connections[i].socket < 0)
+        {
+            connection = &hk_hap_server_connections[i];
+            break;
+        }
+    }
+
+    if (connection == NULL)
+    {
+        HK_LOGW("%d - Closing connection, as the maximum of connections is reached.", socket);
+        close(socket);
+        return;
+    }
+
+    HK_LOGV("%d - Connection open", socket);
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    int no_delay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    connection->socket = socket;
+    connection->is_secure = false;
+    connection->received_frame_count = 0;
+    connection->sent_frame_count = 0;
+    connection->keys = hk_conn_key_store_init();
+    connection->keys->source = address.sin_addr.s_addr; // pair verify is limited per peer address
+    connection->device_id = hk_mem_init();
+    connection->encrypted = hk_mem_init();
+    connection->received = hk_mem_init();
+    connection->tx = hk_mem_init();
+    connection->tx_sent = 0;
+    connection->close_after_tx = false;
+}
+
+static void hk_hap_server_handle_events()
+{
+    char signal[8];
+    hk_hap_server_event_t event;
+
+    // the signals only wake up the task, the events are in the queue
+    while (recv(hk_hap_server_control_socket, signal, sizeof(signal), MSG_DONTWAIT) > 0)
+    {
+    }
+
+    while (hk_queue_pop(&hk_hap_server_events, &event))
+    {
+        for (size_t i = 0; i < HK_HAP_SERVER_MAX_CONNECTIONS; i++)
+        {
+            hk_hap_server_connection_t *connection = &hk_hap_server_connections[i];
+            if (connection->socket == event.socket && connection->is_secure)
+            {
+                HK_RECORDER_RECORD(HK_RECORDER_IP_EVENT, connection->socket, event.message->ptr, event.message->size);
+                if (hk_hap_server_queue(connection, event.message->ptr, event.message->size) != ESP_OK ||
+                    hk_hap_server_send(connection) != ESP_OK)
+                {
+                    hk_hap_server_close(connection);
+                }
+            }
+        }
+
+        hk_mem_free(event.message);
+    }
+}
+
+static void hk_hap_server_task(void *args)
+{
+    while (true)
+    {
+        fd_set read_set;
+        fd_set write_set;
+        int max_socket = MAX(hk_hap_server_listen_socket, hk_hap_server_control_socket);
+
+        FD_ZERO(&read_set);
+        FD_ZERO(&write_set);
+        FD_SET(hk_hap_server_listen_socket, &read_set);
+        FD_SET(hk_hap_server_control_socket, &read_set);
+
+        for (size_t i = 0; i < HK_HAP_SERVER_MAX_CONNECTIONS; i++)
+        {
+            hk_hap_server_connection_t *connection = &hk_hap_server_connections[i];
+            if (connection->socket >= 0)
+            {
+                FD_SET(connection->socket, &read_set);
+                if (connection->tx->size > connection->tx_sent)
+                {
+                    FD_SET(connection->socket, &write_set);
+                }
+
+                max_socket = MAX(max_socket, connection->socket);
+            }
+        }
+
+        int ready = select(max_socket + 1, &read_set, &write_set, NULL, NULL);
+        if (ready < 0)
+        {
+            HK_LOGE("Error in select: %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        for (size_t i = 0; i < HK_HAP_SERVER_MAX_CONNECTIONS; i++)
+        {
+            hk_hap_server_connection_t *connection = &hk_hap_server_connections[i];
+            if (connection->socket < 0)
+            {
+                continue;
+            }
+
+            esp_err_t ret = ESP_OK;
+            if (FD_ISSET(connection->socket, &write_set))
+            {
+                ret = hk_hap_server_send(connection);
+            }
+
+            if (ret == ESP_OK && FD_ISSET(connection->socket, &read_set))
+            {
+                ret = hk_hap_server_receive(connection);
+            }
+
+            if (ret != ESP_OK)
+            {
+                hk_hap_server_close(connection);
+            }
+        }
+
+        if (FD_ISSET(hk_hap_server_control_socket, &read_set))
+        {
+            hk_hap_server_handle_events();
+        }
+
+        if (FD_ISSET(hk_hap_server_listen_socket, &read_set))
+        {
+            hk_hap_server_accept();
+        }
+    }
+}
+
+static esp_err_t hk_hap_server_open_sockets()
+{
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(HK_HAP_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY)};
+    int reuse = 1;
+
+    hk_hap_server_listen_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hk_hap_server_listen_socket < 0 ||
+        setsockopt(hk_hap_server_listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+        bind(hk_hap_server_listen_socket, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        listen(hk_hap_server_listen_socket, HK_HAP_SERVER_MAX_CONNECTIONS) < 0)
+    {
+        HK_LOGE("Could not open server socket: %d", errno);
+        return ESP_FAIL;
+    }
+
+    // other tasks wake up the server task by sending to this socket
+    socklen_t address_size = sizeof(hk_hap_server_control_address);
+    hk_hap_server_control_address.sin_family = AF_INET;
+    hk_hap_server_control_address.sin_port = 0;
+    hk_hap_server_control_address.sin_addr.s_addr = inet_addr("127.0.0.1");
+    hk_hap_server_control_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (hk_hap_server_control_socket < 0 ||
+        bind(hk_hap_server_control_socket, (struct sockaddr *)&hk_hap_server_control_address, address_size) < 0 ||
+        getsockname(hk_hap_server_control_socket, (struct sockaddr *)&hk_hap_server_control_address, &address_size) < 0)
+    {
+        HK_LOGE("Could not open control socket: %d", errno);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hk_server_start(void)
+{
+    esp_err_t ret = ESP_OK;
+    TaskHandle_t task_handle = NULL;
+
+    if (hk_hap_server_started)
+    {
+        // hk_init is called again on reconnect, the running server keeps its connections
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < HK_HAP_SERVER_MAX_CONNECTIONS; i++)
+    {
+        hk_hap_server_connections[i].socket = -1;
+    }
+
+    HK_LOGD("Starting server on port: '%d'", HK_HAP_SERVER_PORT);
+    RUN_AND_CHECK(ret, hk_queue_init, &hk_hap_server_events, sizeof(hk_hap_server_event_t), HK_HAP_SERVER_QUEUE_SIZE);
+    RUN_AND_CHECK(ret, hk_hap_server_open_sockets);
+
+    if (ret == ESP_OK && xTaskCreatePinnedToCore(hk_hap_server_task, "hk_hap_server", HK_HAP_SERVER_TASK_STACK_SIZE, NULL, HK_SERVER_TASK_PRIORITY, &task_handle, HK_UTIL_TASK_CORE_ID(HK_SERVER_TASK_CORE_ID)) != pdPASS)
+    {
+        HK_LOGE("Could not create server task.");
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK)
+    {
+        hk_tasks_register(task_handle, "hk_hap_server", HK_HAP_SERVER_TASK_STACK_SIZE);
+        hk_hap_server_started = true;
+        HK_LOGD("Server started!");
+    }
+
+    return ret;
+}
+
+esp_err_t hk_server_send_async(int socket, hk_mem *message)
+{
+    hk_hap_server_event_t event = {
+        .socket = socket,
+        .message = message};
+
+    if (!hk_queue_push(&hk_hap_server_events, &event))
+    {
+        HK_LOGW("%d - Dropping event, as the server queue is full.", socket);
+        hk_mem_free(message);
+        return ESP_ERR_NO_MEM;
+    }
+
+    char signal = 0;
+    sendto(hk_hap_server_control_socket, &signal, sizeof(signal), 0,
+           (struct sockaddr *)&hk_hap_server_control_address, sizeof(hk_hap_server_control_address));
+
+    return ESP_OK;
+}
+
+size_t hk_server_transport_get_rejected_count()
+{
+    return hk_hap_server_rejected_count;
+}
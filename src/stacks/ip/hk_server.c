@@ -7,13 +7,16 @@
 
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_store.h"
+#include "../../utils/hk_tasks.h"
 #include "../../utils/hk_util.h"
 #include "../../common/hk_pair_setup.h"
 #include "../../common/hk_pair_verify.h"
 #include "../../common/hk_pairings.h"
+#include "../../common/hk_pairings_store.h"
 #include "hk_chrs.h"
 #include "hk_server_handlers.h"
 #include "hk_server_transport.h"
+#include "hk_server_transport_context.h"
 #include "hk_accessories_serializer.h"
 
 typedef struct
@@ -24,29 +27,56 @@ typedef struct
 
 httpd_handle_t hk_server_handle;
 
+// Only /pair-setup and /pair-verify are allowed before the session is verified. All other handlers are wrapped by this
+// handler, which rejects the request before its content is received.
+static esp_err_t hk_server_handle_verified(httpd_req_t *request)
+{
+    if (!hk_server_transport_is_session_secure(request->handle, httpd_req_to_sockfd(request)))
+    {
+        return hk_server_transport_reject_unsecured(request);
+    }
+
+    esp_err_t (*handler)(httpd_req_t *request) = request->user_ctx;
+    return handler(request);
+}
+
+// spec 5.7.6: identify is allowed without verification, as long as the accessory is not paired
+static esp_err_t hk_server_handle_unpaired_or_verified(httpd_req_t *request)
+{
+    bool paired = true;
+    hk_pairings_store_has_pairing(&paired);
+    if (paired)
+    {
+        return hk_server_handle_verified(request);
+    }
+
+    esp_err_t (*handler)(httpd_req_t *request) = request->user_ctx;
+    return handler(request);
+}
+
 static httpd_uri_t hk_server_accessories_get = {
     .uri = "/accessories",
     .method = HTTP_GET,
-    .handler = hk_server_handlers_accessories_get,
-    .user_ctx = NULL};
+    .handler = hk_server_handle_verified,
+    .user_ctx = hk_server_handlers_accessories_get};
 
 static httpd_uri_t hk_server_characteristics_get = {
     .uri = "/characteristics",
     .method = HTTP_GET,
-    .handler = hk_server_handlers_characteristics_get,
-    .user_ctx = NULL};
+    .handler = hk_server_handle_verified,
+    .user_ctx = hk_server_handlers_characteristics_get};
 
 static httpd_uri_t hk_server_characteristics_put = {
     .uri = "/characteristics",
     .method = HTTP_PUT,
-    .handler = hk_server_handlers_characteristics_put,
-    .user_ctx = NULL};
+    .handler = hk_server_handle_verified,
+    .user_ctx = hk_server_handlers_characteristics_put};
 
 static httpd_uri_t hk_server_identify_post = {
     .uri = "/identify",
     .method = HTTP_POST,
-    .handler = hk_server_handlers_identify_post,
-    .user_ctx = NULL};
+    .handler = hk_server_handle_unpaired_or_verified,
+    .user_ctx = hk_server_handlers_identify_post};
 
 static httpd_uri_t hk_server_pair_setup_post = {
     .uri = "/pair-setup",
@@ -57,8 +87,8 @@ static httpd_uri_t hk_server_pair_setup_post = {
 static httpd_uri_t hk_server_pairings_post = {
     .uri = "/pairings",
     .method = HTTP_POST,
-    .handler = hk_server_handlers_pairings_post,
-    .user_ctx = NULL};
+    .handler = hk_server_handle_verified,
+    .user_ctx = hk_server_handlers_pairings_post};
 
 static httpd_uri_t hk_server_pair_verify_post = {
     .uri = "/pair-verify",
@@ -72,10 +102,20 @@ esp_err_t hk_server_start(void)
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = 5556;
+    config.max_open_sockets = HK_SERVER_TRANSPORT_MAX_CONNECTIONS;
     config.open_fn = hk_server_transport_on_open_connection;
+    config.task_priority = HK_SERVER_TASK_PRIORITY;
+    config.core_id = HK_UTIL_TASK_CORE_ID(HK_SERVER_TASK_CORE_ID);
+
+    if (hk_server_handle != NULL)
+    {
+        // hk_init is called again on reconnect, the running server keeps its connections
+        return ESP_OK;
+    }
 
     // Start the httpd server
     HK_LOGD("Starting server on port: '%d'", config.server_port);
+    RUN_AND_CHECK(ret, hk_server_transport_context_pool_init);
     RUN_AND_CHECK(ret, httpd_start, &hk_server_handle, &config);
     RUN_AND_CHECK(ret, httpd_register_uri_handler, hk_server_handle, &hk_server_accessories_get);
     RUN_AND_CHECK(ret, httpd_register_uri_handler, hk_server_handle, &hk_server_characteristics_get);
@@ -87,6 +127,8 @@ esp_err_t hk_server_start(void)
 
     if (ret == ESP_OK)
     {
+        // the http server creates its task by the name httpd
+        hk_tasks_register(xTaskGetHandle("httpd"), "httpd", config.stack_size);
         HK_LOGD("Server started!");
     }
 
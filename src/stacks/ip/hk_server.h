@@ -1,7 +1,11 @@
 #pragma once
 
 #include <esp_err.h>
+#include <sdkconfig.h>
 #include "../../include/hk_mem.h"
 
+#define HK_SERVER_TASK_PRIORITY CONFIG_ESP32_HAP_SERVER_TASK_PRIORITY
+#define HK_SERVER_TASK_CORE_ID CONFIG_ESP32_HAP_SERVER_TASK_CORE_ID
+
 esp_err_t hk_server_start(void);
 esp_err_t hk_server_send_async(int socket, hk_mem *message);
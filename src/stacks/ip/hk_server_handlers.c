@@ -4,6 +4,7 @@
 #include "../../include/hk_mem.h"
 #include "../../utils/hk_store.h"
 #include "../../utils/hk_util.h"
+#include "../../utils/hk_alloc.h"
 #include "../../common/hk_pair_setup.h"
 #include "../../common/hk_pair_verify.h"
 #include "../../common/hk_pairings.h"
@@ -44,7 +45,7 @@ static esp_err_t hk_server_handlers_get_request_content(httpd_req_t *request, hk
 esp_err_t hk_server_handlers_accessories_get(httpd_req_t *request)
 {
     esp_err_t ret = ESP_OK;
-    hk_mem *response_content = hk_mem_init();
+    hk_mem *response_content = hk_mem_init_for(HK_ALLOC_ACCESSORIES);
 
     RUN_AND_CHECK(ret, hk_accessories_serializer_accessories, response_content);
 
@@ -61,17 +62,23 @@ esp_err_t hk_server_handlers_characteristics_get(httpd_req_t *request)
     esp_err_t ret = ESP_OK;
     hk_mem *response_content = hk_mem_init();
     size_t query_length = httpd_req_get_url_query_len(request) + 1;
-    char query[query_length];
 
-    RUN_AND_CHECK(ret, httpd_req_get_url_query_str, request, query, query_length);
-    char ids[query_length];
-    RUN_AND_CHECK(ret, httpd_query_key_value, query, "id", ids, query_length);
+    // the query is given by the controller, so it is not put on the stack
+    hk_mem *query = hk_mem_init();
+    hk_mem *ids = hk_mem_init();
+    hk_mem_set(query, query_length);
+    hk_mem_set(ids, query_length);
+
+    RUN_AND_CHECK(ret, httpd_req_get_url_query_str, request, query->ptr, query_length);
+    RUN_AND_CHECK(ret, httpd_query_key_value, query->ptr, "id", ids->ptr, query_length);
 
-    RUN_AND_CHECK(ret, hk_chrs_get, ids, response_content);
+    RUN_AND_CHECK(ret, hk_chrs_get, ids->ptr, response_content);
 
     RUN_AND_CHECK(ret, httpd_resp_set_type, request, HK_SERVER_CONTENT_JSON);
     RUN_AND_CHECK(ret, httpd_resp_send, request, response_content->ptr, response_content->size);
 
+    hk_mem_free(query);
+    hk_mem_free(ids);
     hk_mem_free(response_content);
 
     return ret;
@@ -83,15 +90,27 @@ esp_err_t hk_server_handlers_characteristics_put(httpd_req_t *request)
 
     esp_err_t ret = ESP_OK;
     hk_mem *request_content = hk_mem_init();
+    hk_mem *response_content = hk_mem_init();
 
     RUN_AND_CHECK(ret, hk_server_handlers_get_request_content, request, request_content);
     int socket = httpd_req_to_sockfd(request);
-    RUN_AND_CHECK(ret, hk_chrs_put, request_content, request->handle, socket);
+    RUN_AND_CHECK(ret, hk_chrs_put, request_content, request->handle, socket, response_content);
 
-    RUN_AND_CHECK(ret, httpd_resp_set_status, request, HTTPD_204);
-    RUN_AND_CHECK(ret, httpd_resp_send, request, NULL, 0);
+    if (response_content->size > 0)
+    {
+        // write responses or errors were requested, so we answer with the status of every characteristic
+        RUN_AND_CHECK(ret, httpd_resp_set_status, request, HTTPD_207);
+        RUN_AND_CHECK(ret, httpd_resp_set_type, request, HK_SERVER_CONTENT_JSON);
+        RUN_AND_CHECK(ret, httpd_resp_send, request, response_content->ptr, response_content->size);
+    }
+    else
+    {
+        RUN_AND_CHECK(ret, httpd_resp_set_status, request, HTTPD_204);
+        RUN_AND_CHECK(ret, httpd_resp_send, request, NULL, 0);
+    }
 
     hk_mem_free(request_content);
+    hk_mem_free(response_content);
 
     return ret;
 }
@@ -146,7 +165,7 @@ esp_err_t hk_server_handlers_pair_verify_post(httpd_req_t *request)
     hk_server_transport_context_t *transport_context = hk_server_transport_context_get(request->handle, socket);
 
     RUN_AND_CHECK(ret, hk_server_handlers_get_request_content, request, request_content);
-    RUN_AND_CHECK(ret, hk_pair_verify, request_content, response_content, transport_context->keys, &session_is_secure);
+    RUN_AND_CHECK(ret, hk_pair_verify, request_content, response_content, transport_context->keys, transport_context->device_id, &session_is_secure);
     RUN_AND_CHECK(ret, httpd_resp_set_type, request, HK_SERVER_CONTENT_TLV);
     RUN_AND_CHECK(ret, httpd_resp_send, request, response_content->ptr, response_content->size);
 
@@ -173,9 +192,10 @@ esp_err_t hk_server_handlers_pairings_post(httpd_req_t *request)
     bool is_paired = false;
 
     int socket = httpd_req_to_sockfd(request);
+    hk_server_transport_context_t *transport_context = hk_server_transport_context_get(request->handle, socket);
     RUN_AND_CHECK(ret, hk_server_handlers_get_request_content, request, request_content);
 
-    RUN_AND_CHECK(ret, hk_pairings, request_content, response_content, &kill_session, &is_paired);
+    RUN_AND_CHECK(ret, hk_pairings, transport_context->device_id, request_content, response_content, &kill_session, &is_paired);
 
     RUN_AND_CHECK(ret, httpd_resp_set_type, request, HK_SERVER_CONTENT_TLV);
     RUN_AND_CHECK(ret, httpd_resp_send, request, response_content->ptr, response_content->size);
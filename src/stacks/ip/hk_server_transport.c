@@ -6,8 +6,14 @@
 #include "../../crypto/hk_chacha20poly1305.h"
 #include "../../utils/hk_logging.h"
 #include "../../utils/hk_util.h"
+#include "../../utils/hk_recorder.h"
 #include "hk_server_transport_context.h"
 
+#define HK_SERVER_TRANSPORT_STATUS_470 "470 Connection Authorization Required"
+#define HK_SERVER_TRANSPORT_REJECTED_RESPONSE "{\"status\":-70401}" // spec table 6.11: insufficient privileges
+
+size_t hk_server_transport_rejected_count = 0;
+
 static int hk_server_transport_sock_err(const char *context, int socket)
 {
     int errval;
@@ -39,7 +45,21 @@ static int hk_server_transport_decrypt(hk_server_transport_context_t *context, c
     while (offset_in < length)
     {
         char *encrypted = in + offset_in;
-        size_t message_size = encrypted[0] + encrypted[1] * 256;
+        size_t remaining = length - offset_in;
+        if (remaining < HK_AAD_SIZE + HK_AUTHTAG_SIZE)
+        {
+            HK_LOGE("Received truncated frame of %d bytes.", remaining);
+            return HTTPD_SOCK_ERR_FAIL;
+        }
+
+        // the length is controlled by the peer, so it has to fit into the received data and the output block
+        size_t message_size = (uint8_t)encrypted[0] + (uint8_t)encrypted[1] * 256;
+        if (message_size > remaining - HK_AAD_SIZE - HK_AUTHTAG_SIZE || message_size > HK_MAX_RECV_SIZE - offset_out)
+        {
+            HK_LOGE("Received frame of %d bytes, which does not fit into %d bytes.", message_size, remaining);
+            return HTTPD_SOCK_ERR_FAIL;
+        }
+
         char nonce[12] = {
             0,
         };
@@ -47,7 +67,7 @@ static int hk_server_transport_decrypt(hk_server_transport_context_t *context, c
         nonce[5] = context->received_frame_count++ / 256;
 
         esp_err_t ret = hk_chacha20poly1305_decrypt_buffer(
-            context->keys->request_key, nonce, encrypted, HK_AAD_SIZE, encrypted + HK_AAD_SIZE, out + offset_out, message_size);
+            HK_CONN_KEY_STORE_MEM(context->keys->request_key), nonce, encrypted, HK_AAD_SIZE, encrypted + HK_AAD_SIZE, out + offset_out, message_size);
 
         if (ret)
         {
@@ -85,25 +105,41 @@ static int hk_server_transport_recv(httpd_handle_t handle, int socket, char *buf
         size_t size_to_submit_from_buffer = transport_context->received_length - transport_context->received_submitted_length;
         if (size_to_submit_from_buffer < 1)
         {
+            // the buffers are only taken while a message is processed, so idle connections hold no buffers
+            char *buffer_recv = hk_server_transport_context_pool_take();
+            if (transport_context->received_buffer == NULL)
+            {
+                transport_context->received_buffer = hk_server_transport_context_pool_take();
+            }
+
+            if (buffer_recv == NULL || transport_context->received_buffer == NULL)
+            {
+                hk_server_transport_context_pool_give(buffer_recv);
+                return HTTPD_SOCK_ERR_FAIL;
+            }
+
             // recv with max package size. Refer to spec 6.5.2
-            char buffer_recv[HK_MAX_RECV_SIZE];
             ret = recv(socket, buffer_recv, HK_MAX_RECV_SIZE, flags);
             if (ret < 0)
             {
+                hk_server_transport_context_pool_give(buffer_recv);
                 return hk_server_transport_sock_err("recv", socket);
             }
 
             // decrypt the received message into transport context buffer
-            memset(transport_context->received_buffer, 0, HK_MAX_RECV_SIZE);
             transport_context->received_submitted_length = 0;
             size_to_submit_from_buffer = transport_context->received_length =
                 ret = hk_server_transport_decrypt(transport_context, buffer_recv, transport_context->received_buffer, ret);
+            hk_server_transport_context_pool_give(buffer_recv);
 
             if (ret < 0)
             {
+                transport_context->received_length = 0;
                 HK_LOGE("%d - Could not pre process received data.", socket);
                 return HTTPD_SOCK_ERR_FAIL;
             }
+
+            HK_RECORDER_RECORD(HK_RECORDER_IP_REQUEST, socket, transport_context->received_buffer, ret);
         }
 
         // find max length to submit to server and copy it into buffer
@@ -113,6 +149,13 @@ static int hk_server_transport_recv(httpd_handle_t handle, int socket, char *buf
         // set offset for next block and returned data length
         transport_context->received_submitted_length += copy_length;
         ret = copy_length;
+
+        if (transport_context->received_submitted_length >= transport_context->received_length)
+        {
+            // everything was submitted, so the connection is idle until the next message
+            hk_server_transport_context_pool_give(transport_context->received_buffer);
+            transport_context->received_buffer = NULL;
+        }
     }
     else
     {
@@ -121,6 +164,8 @@ static int hk_server_transport_recv(httpd_handle_t handle, int socket, char *buf
         {
             return hk_server_transport_sock_err("recv", socket);
         }
+
+        HK_RECORDER_RECORD(HK_RECORDER_IP_REQUEST, socket, buffer, ret);
     }
 
     HK_LOGV("%d - Received: \n%s", socket, buffer);
@@ -134,35 +179,45 @@ static int hk_server_transport_encrypt_and_send(int socket, hk_server_transport_
     };
     size_t pending_size = in_length;
     char *pending = (char *)in;
+
+    // a frame has at most HK_MAX_RECV_SIZE bytes, so the buffers of the receive pool fit
+    char *encrypted = hk_server_transport_context_pool_take();
+    if (encrypted == NULL)
+    {
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+
     while (pending_size > 0)
     {
         size_t chunk_size = pending_size < HK_MAX_DATA_SIZE ? pending_size : HK_MAX_DATA_SIZE;
         pending_size -= chunk_size;
         size_t encrypted_size = HK_AAD_SIZE + chunk_size + HK_AUTHTAG_SIZE;
-        char encrypted[encrypted_size];
         encrypted[0] = chunk_size % 256;
         encrypted[1] = chunk_size / 256;
 
         nonce[4] = context->sent_frame_count % 256;
         nonce[5] = context->sent_frame_count++ / 256;
 
-        esp_err_t ret = hk_chacha20poly1305_encrypt_buffer(context->keys->response_key, nonce, encrypted, HK_AAD_SIZE,
+        esp_err_t ret = hk_chacha20poly1305_encrypt_buffer(HK_CONN_KEY_STORE_MEM(context->keys->response_key), nonce, encrypted, HK_AAD_SIZE,
                                                            pending, encrypted + HK_AAD_SIZE, chunk_size);
         if (ret != ESP_OK)
         {
             HK_LOGE("%d - Encrypting content.", socket);
+            hk_server_transport_context_pool_give(encrypted);
             return HTTPD_SOCK_ERR_FAIL;
         }
 
         ret = send(socket, encrypted, encrypted_size, flags);
         if (ret < 0)
         {
+            hk_server_transport_context_pool_give(encrypted);
             return hk_server_transport_sock_err("send", socket);
         }
 
         pending += chunk_size;
     }
 
+    hk_server_transport_context_pool_give(encrypted);
     return in_length;
 }
 
@@ -170,6 +225,7 @@ esp_err_t hk_server_transport_send_unsolicited(httpd_handle_t handle, int socket
 {
     hk_server_transport_context_t *transport_context = hk_server_transport_context_get(handle, socket);
 
+    HK_RECORDER_RECORD(HK_RECORDER_IP_EVENT, socket, message->ptr, message->size);
     int ret = hk_server_transport_encrypt_and_send(socket, transport_context, message->ptr, message->size, 0);
 
     if (ret < 0)
@@ -184,11 +240,6 @@ esp_err_t hk_server_transport_send_unsolicited(httpd_handle_t handle, int socket
 
 static int hk_server_transport_send(httpd_handle_t handle, int socket, const char *buffer, size_t buffer_length, int flags)
 {
-    char content[buffer_length + 1];
-    memcpy(content, buffer, buffer_length);
-    content[buffer_length] = '\0';
-    HK_LOGV("%d - Sending: \n%s", socket, content);
-
     int ret = 0;
     (void)handle;
     if (buffer == NULL)
@@ -196,9 +247,12 @@ static int hk_server_transport_send(httpd_handle_t handle, int socket, const cha
         return HTTPD_SOCK_ERR_INVALID;
     }
 
+    HK_LOGV("%d - Sending: \n%.*s", socket, buffer_length, buffer);
+
     // getting contexts
     hk_server_transport_context_t *transport_context = hk_server_transport_context_get(handle, socket);
 
+    HK_RECORDER_RECORD(HK_RECORDER_IP_RESPONSE, socket, buffer, buffer_length);
     if (transport_context->is_secure)
     {
         ret = hk_server_transport_encrypt_and_send(socket, transport_context, buffer, buffer_length, flags);
@@ -235,4 +289,32 @@ esp_err_t hk_server_transport_set_session_secure(httpd_handle_t handle, int sock
     hk_server_transport_context_t *transport_context = hk_server_transport_context_get(handle, socket);
     transport_context->is_secure = true;
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+bool hk_server_transport_is_session_secure(httpd_handle_t handle, int socket)
+{
+    hk_server_transport_context_t *transport_context = hk_server_transport_context_get(handle, socket);
+    return transport_context != NULL && transport_context->is_secure;
+}
+
+esp_err_t hk_server_transport_reject_unsecured(httpd_req_t *request)
+{
+    esp_err_t ret = ESP_OK;
+
+    // only called by the http server task, so counting needs no synchronization
+    hk_server_transport_rejected_count++;
+    HK_LOGW("%d - Rejecting %s, as the session is not verified (%d rejected).",
+            httpd_req_to_sockfd(request), request->uri, hk_server_transport_rejected_count);
+
+    // the content of the request is not parsed, the http server discards it
+    RUN_AND_CHECK(ret, httpd_resp_set_status, request, HK_SERVER_TRANSPORT_STATUS_470);
+    RUN_AND_CHECK(ret, httpd_resp_set_type, request, "application/hap+json");
+    RUN_AND_CHECK(ret, httpd_resp_send, request, HK_SERVER_TRANSPORT_REJECTED_RESPONSE, strlen(HK_SERVER_TRANSPORT_REJECTED_RESPONSE));
+
+    return ret;
+}
+
+size_t hk_server_transport_get_rejected_count()
+{
+    return hk_server_transport_rejected_count;
+}
@@ -9,4 +9,7 @@
 
 esp_err_t hk_server_transport_on_open_connection(httpd_handle_t hd, int sockfd);
 esp_err_t hk_server_transport_set_session_secure(httpd_handle_t handle, int socket);
+bool hk_server_transport_is_session_secure(httpd_handle_t handle, int socket);
+esp_err_t hk_server_transport_reject_unsecured(httpd_req_t *request);
+size_t hk_server_transport_get_rejected_count();
 esp_err_t hk_server_transport_send_unsolicited(httpd_handle_t handle, int socket, hk_mem *message);
\ No newline at end of file
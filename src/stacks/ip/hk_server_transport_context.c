@@ -1,19 +1,36 @@
 #include "hk_server_transport_context.h"
 
+#include <sys/socket.h>
+#include <netinet/in.h>
+
 #include "../../utils/hk_logging.h"
+#include "../../utils/hk_pool.h"
+#include "../../common/hk_core.h"
+
+hk_pool_t hk_server_transport_context_pool = {0};
 
-hk_server_transport_context_t *hk_server_transport_context_init()
+hk_server_transport_context_t *hk_server_transport_context_init(int socket)
 {
     hk_server_transport_context_t *context = (hk_server_transport_context_t *)malloc(sizeof(hk_server_transport_context_t));
 
+    context->socket = socket;
     context->sent_frame_count = 0;
     context->received_frame_count = 0;
     context->received_submitted_length = 0;
     context->received_length = 0;
-    context->received_buffer = (char *)malloc(HK_MAX_RECV_SIZE);
+    context->received_buffer = NULL;
     context->is_secure = false;
 
     context->keys = hk_conn_key_store_init();
+    context->device_id = hk_mem_init();
+
+    // pair verify is limited per peer address
+    struct sockaddr_in address;
+    socklen_t address_size = sizeof(address);
+    if (getpeername(socket, (struct sockaddr *)&address, &address_size) == 0)
+    {
+        context->keys->source = address.sin_addr.s_addr;
+    }
 
     return context;
 }
@@ -23,13 +40,47 @@ void hk_server_transport_context_free(void *context)
     HK_LOGD("Freeing transport context.");
     hk_server_transport_context_t *transport_context = (hk_server_transport_context_t *)context;
 
+    // the socket number can be reused by the next connection, so the subscriptions must not stay behind
+    if (hk_core_post_blocking(HK_CORE_EVENT_UNSUBSCRIBE_ALL, NULL, transport_context->socket) != ESP_OK)
+    {
+        HK_LOGE("%d - Could not remove subscriptions.", transport_context->socket);
+    }
+
     hk_conn_key_store_free(transport_context->keys);
+    hk_mem_free(transport_context->device_id);
 
-    free(transport_context->received_buffer);
+    hk_server_transport_context_pool_give(transport_context->received_buffer);
     free(transport_context);
 }
 
 hk_server_transport_context_t *hk_server_transport_context_get(httpd_handle_t handle, int socket)
 {
     return (hk_server_transport_context_t *)httpd_sess_get_transport_ctx(handle, socket);
-}
\ No newline at end of file
+}
+
+esp_err_t hk_server_transport_context_pool_init()
+{
+    if (hk_server_transport_context_pool.blocks != NULL)
+    {
+        return ESP_OK;
+    }
+
+    return hk_pool_init(&hk_server_transport_context_pool, HK_ALLOC_TRANSPORT, HK_MAX_RECV_SIZE, HK_SERVER_TRANSPORT_POOL_CAPACITY);
+}
+
+char *hk_server_transport_context_pool_take()
+{
+    char *buffer = hk_pool_take(&hk_server_transport_context_pool);
+
+    if (buffer == NULL)
+    {
+        HK_LOGE("Could not take receive buffer, %d are taken.", hk_pool_get_taken_count(&hk_server_transport_context_pool));
+    }
+
+    return buffer;
+}
+
+void hk_server_transport_context_pool_give(char *buffer)
+{
+    hk_pool_give(&hk_server_transport_context_pool, buffer);
+}
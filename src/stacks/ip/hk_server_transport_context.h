@@ -4,24 +4,32 @@
 #include <esp_http_server.h>
 #include <stdbool.h>
 
+#include "../../include/hk_mem.h"
 #include "../../common/hk_conn_key_store.h"
 
 #define HK_MAX_RECV_SIZE 1024 // refer to spec 6.5.2
 #define HK_AAD_SIZE 2
 #define HK_AUTHTAG_SIZE 16 //16 = CHACHA20_POLY1305_AUTH_TAG_LENGTH
 #define HK_MAX_DATA_SIZE HK_MAX_RECV_SIZE - HK_AAD_SIZE - HK_AUTHTAG_SIZE
+#define HK_SERVER_TRANSPORT_MAX_CONNECTIONS 7 // esp_http_server uses 3 of the 10 sockets of lwip itself
+#define HK_SERVER_TRANSPORT_POOL_CAPACITY (2 * HK_SERVER_TRANSPORT_MAX_CONNECTIONS) // every connection may keep partially read data, while another one receives or sends
 
 typedef struct hk_server_transport_context
 {
-    char *received_buffer;
+    int socket;
+    char *received_buffer; // taken from the pool while decrypted data is pending, NULL while idle
     size_t received_submitted_length;
     size_t received_length;
     size_t received_frame_count;
     size_t sent_frame_count;
     bool is_secure;
     hk_conn_key_store_t *keys;
+    hk_mem *device_id;
 } hk_server_transport_context_t;
 
-hk_server_transport_context_t *hk_server_transport_context_init();
+hk_server_transport_context_t *hk_server_transport_context_init(int socket);
 void hk_server_transport_context_free(void *context);
 hk_server_transport_context_t *hk_server_transport_context_get(httpd_handle_t handle, int socket);
+esp_err_t hk_server_transport_context_pool_init();
+char *hk_server_transport_context_pool_take();
+void hk_server_transport_context_pool_give(char *buffer);
@@ -163,6 +163,22 @@ esp_err_t hk_subscription_store_remove_all(int socket)
     return ret;
 }
 
+esp_err_t hk_subscription_store_remove_chr(hk_chr_t *chr)
+{
+    hk_ll_foreach(subscriptions, current_subscription)
+    {
+        if (current_subscription->chr == chr)
+        {
+            HK_LOGD("Removing all subscriptions for %x.", (uint)chr);
+            free(current_subscription->sockets);
+            subscriptions = hk_ll_remove(subscriptions, current_subscription);
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
 void hk_subscription_store_free()
 {
     hk_ll_foreach(subscriptions, subscription_item)
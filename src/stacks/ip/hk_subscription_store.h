@@ -49,6 +49,15 @@ esp_err_t hk_subscription_store_remove_all(int socket);
  */
 esp_err_t hk_subscription_store_remove(hk_chr_t *chr, int socket);
 
+/**
+ * @brief Removes all subscriptions for the characteristic.
+ *
+ * Removes the subscriptions of all sockets for the given characteristic. Used when the characteristic is removed.
+ *
+ * @param chr The characteristic to remove the subscriptions for.
+ */
+esp_err_t hk_subscription_store_remove_chr(hk_chr_t *chr);
+
 /**
  * @brief Frees all ressources used by this module.
  */
@@ -0,0 +1,174 @@
+#include "hk_alloc.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <esp_heap_caps.h>
+
+#include "hk_logging.h"
+
+#define HK_ALLOC_CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define HK_ALLOC_CAPS_SPIRAM (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+// precedes every counted allocation, 8 bytes keep the alignment of malloc
+typedef struct
+{
+    uint32_t size;
+    uint32_t is_spiram;
+} hk_alloc_header_t;
+
+const char *hk_alloc_subsystem_names[HK_ALLOC_COUNT] = {"default", "transport", "accessories", "pairing", "ble", "recorder"};
+atomic_size_t hk_alloc_internal_usage[HK_ALLOC_COUNT];
+atomic_size_t hk_alloc_spiram_usage[HK_ALLOC_COUNT];
+
+static bool hk_alloc_prefers_spiram(hk_alloc_subsystem_t subsystem, size_t size)
+{
+#ifdef CONFIG_ESP32_HAP_SPIRAM
+    if (size < CONFIG_ESP32_HAP_SPIRAM_MIN_SIZE)
+    {
+        // small buffers are used often, so they stay in the faster internal memory
+        return false;
+    }
+
+    switch (subsystem)
+    {
+#ifdef CONFIG_ESP32_HAP_SPIRAM_TRANSPORT
+    case HK_ALLOC_TRANSPORT:
+#endif
+#ifdef CONFIG_ESP32_HAP_SPIRAM_ACCESSORIES
+    case HK_ALLOC_ACCESSORIES:
+#endif
+#ifdef CONFIG_ESP32_HAP_SPIRAM_PAIRING
+    case HK_ALLOC_PAIRING:
+#endif
+#ifdef CONFIG_ESP32_HAP_SPIRAM_BLE
+    case HK_ALLOC_BLE:
+#endif
+#ifdef CONFIG_ESP32_HAP_SPIRAM_RECORDER
+    case HK_ALLOC_RECORDER:
+#endif
+        return true;
+    default:
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+static void hk_alloc_count(hk_alloc_subsystem_t subsystem, hk_alloc_header_t *header, bool is_allocated)
+{
+    atomic_size_t *usage = header->is_spiram ? &hk_alloc_spiram_usage[subsystem] : &hk_alloc_internal_usage[subsystem];
+
+    if (is_allocated)
+    {
+        atomic_fetch_add(usage, header->size);
+    }
+    else
+    {
+        atomic_fetch_sub(usage, header->size);
+    }
+}
+
+static hk_alloc_header_t *hk_alloc_place(hk_alloc_subsystem_t subsystem, hk_alloc_header_t *header, size_t size)
+{
+    hk_alloc_header_t *placed = NULL;
+    bool is_spiram = false;
+
+    if (hk_alloc_prefers_spiram(subsystem, size))
+    {
+        placed = (hk_alloc_header_t *)heap_caps_realloc(header, sizeof(hk_alloc_header_t) + size, HK_ALLOC_CAPS_SPIRAM);
+        is_spiram = placed != NULL;
+    }
+
+    if (placed == NULL)
+    {
+        placed = (hk_alloc_header_t *)heap_caps_realloc(header, sizeof(hk_alloc_header_t) + size, HK_ALLOC_CAPS_INTERNAL);
+    }
+
+    if (placed != NULL)
+    {
+        placed->size = size;
+        placed->is_spiram = is_spiram;
+        hk_alloc_count(subsystem, placed, true);
+    }
+
+    return placed;
+}
+
+void *hk_alloc_malloc(hk_alloc_subsystem_t subsystem, size_t size)
+{
+    return hk_alloc_realloc(subsystem, NULL, size);
+}
+
+void *hk_alloc_realloc(hk_alloc_subsystem_t subsystem, void *ptr, size_t size)
+{
+    if (subsystem == HK_ALLOC_DEFAULT || subsystem >= HK_ALLOC_COUNT)
+    {
+        return realloc(ptr, size);
+    }
+
+    if (size == 0)
+    {
+        hk_alloc_free(subsystem, ptr);
+        return NULL;
+    }
+
+    hk_alloc_header_t *header = NULL;
+    hk_alloc_header_t previous = {0};
+    if (ptr != NULL)
+    {
+        header = (hk_alloc_header_t *)ptr - 1;
+        previous = *header;
+    }
+
+    hk_alloc_header_t *placed = hk_alloc_place(subsystem, header, size);
+    if (placed == NULL)
+    {
+        return NULL;
+    }
+
+    if (ptr != NULL)
+    {
+        hk_alloc_count(subsystem, &previous, false);
+    }
+
+    return placed + 1;
+}
+
+void hk_alloc_free(hk_alloc_subsystem_t subsystem, void *ptr)
+{
+    if (subsystem == HK_ALLOC_DEFAULT || subsystem >= HK_ALLOC_COUNT)
+    {
+        free(ptr);
+        return;
+    }
+
+    if (ptr != NULL)
+    {
+        hk_alloc_header_t *header = (hk_alloc_header_t *)ptr - 1;
+        hk_alloc_count(subsystem, header, false);
+        heap_caps_free(header);
+    }
+}
+
+hk_alloc_usage_t hk_alloc_get_usage(hk_alloc_subsystem_t subsystem)
+{
+    hk_alloc_usage_t usage = {0};
+
+    if (subsystem < HK_ALLOC_COUNT)
+    {
+        usage.internal = atomic_load(&hk_alloc_internal_usage[subsystem]);
+        usage.spiram = atomic_load(&hk_alloc_spiram_usage[subsystem]);
+    }
+
+    return usage;
+}
+
+void hk_alloc_print_usage()
+{
+    for (size_t i = HK_ALLOC_DEFAULT + 1; i < HK_ALLOC_COUNT; i++)
+    {
+        hk_alloc_usage_t usage = hk_alloc_get_usage(i);
+        HK_LOGI("Memory of %s: %d bytes internal, %d bytes in spiram.", hk_alloc_subsystem_names[i], usage.internal, usage.spiram);
+    }
+}
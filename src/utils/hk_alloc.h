@@ -0,0 +1,85 @@
+/**
+ * @file hk_alloc.h
+ *
+ * Allocates the buffers of a subsystem in the heap region, which is configured for it, and counts their usage.
+ *
+ * With ESP32_HAP_SPIRAM, large allocations of the selected subsystems are placed in SPIRAM, to leave the internal
+ * memory to wifi and bluetooth. All other allocations of the subsystems are placed in internal memory. If SPIRAM is
+ * exhausted, internal memory is used.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <sdkconfig.h>
+
+typedef enum
+{
+    HK_ALLOC_DEFAULT = 0, // uses malloc and is not counted
+    HK_ALLOC_TRANSPORT,   // receive buffers of the ip transport
+    HK_ALLOC_ACCESSORIES, // serialized accessories of the ip stack
+    HK_ALLOC_PAIRING,     // srp keys of pair setup
+    HK_ALLOC_BLE,         // responses of bluetooth transactions
+    HK_ALLOC_RECORDER,    // ring buffer of the recorder
+    HK_ALLOC_COUNT
+} hk_alloc_subsystem_t;
+
+typedef struct
+{
+    size_t internal;
+    size_t spiram;
+} hk_alloc_usage_t;
+
+/**
+ * @brief Allocates memory for a subsystem.
+ *
+ * Allocates memory in the region, which is configured for the subsystem.
+ *
+ * @param subsystem The subsystem.
+ * @param size The size in bytes.
+ *
+ * @return Returns the memory, or NULL if no memory is left.
+ */
+void *hk_alloc_malloc(hk_alloc_subsystem_t subsystem, size_t size);
+
+/**
+ * @brief Reallocates memory of a subsystem.
+ *
+ * Reallocates memory like realloc. The memory can move to another region, if its new size falls below or exceeds
+ * the minimum size for SPIRAM.
+ *
+ * @param subsystem The subsystem, which allocated the memory.
+ * @param ptr The memory, or NULL.
+ * @param size The new size in bytes.
+ *
+ * @return Returns the memory, or NULL if no memory is left. Then the old memory is kept.
+ */
+void *hk_alloc_realloc(hk_alloc_subsystem_t subsystem, void *ptr, size_t size);
+
+/**
+ * @brief Frees memory of a subsystem.
+ *
+ * Frees memory, which was allocated by hk_alloc_malloc or hk_alloc_realloc.
+ *
+ * @param subsystem The subsystem, which allocated the memory.
+ * @param ptr The memory, or NULL.
+ */
+void hk_alloc_free(hk_alloc_subsystem_t subsystem, void *ptr);
+
+/**
+ * @brief Returns the usage of a subsystem.
+ *
+ * Returns the bytes, which a subsystem currently uses in internal memory and in SPIRAM.
+ *
+ * @param subsystem The subsystem.
+ *
+ * @return Returns the usage.
+ */
+hk_alloc_usage_t hk_alloc_get_usage(hk_alloc_subsystem_t subsystem);
+
+/**
+ * @brief Prints the usage of all subsystems.
+ *
+ * Logs the bytes, which every subsystem uses in internal memory and in SPIRAM.
+ */
+void hk_alloc_print_usage();
@@ -0,0 +1,122 @@
+#include "hk_base64.h"
+
+#include "hk_logging.h"
+
+static const char hk_base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int hk_base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+
+    return -1;
+}
+
+size_t hk_base64_encoded_size(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+size_t hk_base64_encode(const char *data, size_t size, char *out)
+{
+    const unsigned char *in = (const unsigned char *)data;
+    char *current = out;
+    size_t i = 0;
+
+    for (; i + 2 < size; i += 3)
+    {
+        *current++ = hk_base64_alphabet[in[i] >> 2];
+        *current++ = hk_base64_alphabet[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+        *current++ = hk_base64_alphabet[((in[i + 1] & 0x0f) << 2) | (in[i + 2] >> 6)];
+        *current++ = hk_base64_alphabet[in[i + 2] & 0x3f];
+    }
+
+    if (i < size)
+    {
+        *current++ = hk_base64_alphabet[in[i] >> 2];
+        if (i + 1 < size)
+        {
+            *current++ = hk_base64_alphabet[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+            *current++ = hk_base64_alphabet[(in[i + 1] & 0x0f) << 2];
+        }
+        else
+        {
+            *current++ = hk_base64_alphabet[(in[i] & 0x03) << 4];
+            *current++ = '=';
+        }
+        *current++ = '=';
+    }
+
+    *current = 0;
+
+    return current - out;
+}
+
+esp_err_t hk_base64_decode_buffer(const char *data, size_t size, char *out, size_t *out_size)
+{
+    unsigned char *current = (unsigned char *)out;
+    unsigned int buffer = 0;
+    size_t bits = 0;
+    size_t padding = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        char c = data[i];
+        if (c == '=')
+        {
+            padding++;
+            continue;
+        }
+
+        int value = hk_base64_value(c);
+        if (value < 0 || padding > 0)
+        {
+            HK_LOGE("Invalid base64 character at position %d.", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        buffer = (buffer << 6) | value;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            *current++ = (buffer >> bits) & 0xff;
+        }
+    }
+
+    if (padding > 2)
+    {
+        HK_LOGE("Invalid base64 padding.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_size = (char *)current - out;
+
+    return ESP_OK;
+}
+
+esp_err_t hk_base64_decode(const char *data, size_t size, hk_mem *out)
+{
+    size_t decoded_size = 0;
+    hk_mem_set(out, size / 4 * 3 + 3);
+
+    esp_err_t ret = hk_base64_decode_buffer(data, size, out->ptr, &decoded_size);
+    if (ret == ESP_OK)
+    {
+        hk_mem_set(out, decoded_size);
+    }
+    else
+    {
+        hk_mem_set(out, 0);
+    }
+
+    return ret;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file hk_base64.h
+ *
+ * Functions to encode and decode base64 without intermediate copies.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <esp_err.h>
+
+#include "../include/hk_mem.h"
+
+/**
+ * @brief Returns the encoded size.
+ *
+ * Returns the size of the base64 representation of a buffer, without the string terminator.
+ *
+ * @param size The size of the buffer to encode.
+ * 
+ * @return Returns the encoded size.
+ */
+size_t hk_base64_encoded_size(size_t size);
+
+/**
+ * @brief Encodes a buffer.
+ *
+ * Encodes a buffer directly into the output, which has to hold hk_base64_encoded_size(size) + 1 bytes.
+ * The output is null terminated.
+ *
+ * @param data The buffer to encode.
+ * @param size The size of the buffer to encode.
+ * @param out The output.
+ * 
+ * @return Returns the number of characters written, without the string terminator.
+ */
+size_t hk_base64_encode(const char *data, size_t size, char *out);
+
+/**
+ * @brief Decodes a buffer into a buffer.
+ *
+ * Decodes a base64 buffer into an output buffer, which needs size * 3 / 4 bytes. The output may be the
+ * input itself, as the decoder never writes ahead of the position it reads.
+ *
+ * @param data The base64 buffer.
+ * @param size The size of the base64 buffer.
+ * @param out The output buffer.
+ * @param out_size The decoded size.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_ARG if the input is no valid base64.
+ */
+esp_err_t hk_base64_decode_buffer(const char *data, size_t size, char *out, size_t *out_size);
+
+/**
+ * @brief Decodes a buffer.
+ *
+ * Decodes a base64 buffer directly into the output. The output is resized once to the maximum size
+ * and shrinked to the decoded size afterwards.
+ *
+ * @param data The base64 buffer.
+ * @param size The size of the base64 buffer.
+ * @param out The output.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_ARG if the input is no valid base64.
+ */
+esp_err_t hk_base64_decode(const char *data, size_t size, hk_mem *out);
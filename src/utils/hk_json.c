@@ -0,0 +1,492 @@
+#include "hk_json.h"
+
+#include <string.h>
+
+#include "hk_logging.h"
+
+// what the reader accepts next
+enum
+{
+    HK_JSON_STATE_VALUE,
+    HK_JSON_STATE_VALUE_OR_CLOSE,
+    HK_JSON_STATE_KEY,
+    HK_JSON_STATE_KEY_OR_CLOSE,
+    HK_JSON_STATE_SEPARATOR_OR_CLOSE,
+    HK_JSON_STATE_END,
+    HK_JSON_STATE_DONE
+};
+
+static bool hk_json_is_in_object(hk_json_reader_t *reader)
+{
+    return reader->depth > 0 && (reader->objects >> (reader->depth - 1)) & 1;
+}
+
+static void hk_json_skip_whitespace(hk_json_reader_t *reader)
+{
+    while (reader->ptr < reader->end &&
+           (*reader->ptr == ' ' || *reader->ptr == '\t' || *reader->ptr == '\n' || *reader->ptr == '\r'))
+    {
+        reader->ptr++;
+    }
+}
+
+static esp_err_t hk_json_error(hk_json_reader_t *reader, const char *message)
+{
+    HK_LOGE("Invalid json: %s (%d bytes before end).", message, (int)(reader->end - reader->ptr));
+    reader->state = HK_JSON_STATE_DONE;
+    return ESP_ERR_INVALID_ARG;
+}
+
+static void hk_json_set_token(hk_json_token_t *token, hk_json_token_type_t type, const char *ptr, size_t length)
+{
+    token->type = type;
+    token->ptr = ptr;
+    token->length = length;
+}
+
+static void hk_json_value_done(hk_json_reader_t *reader)
+{
+    reader->state = reader->depth == 0 ? HK_JSON_STATE_END : HK_JSON_STATE_SEPARATOR_OR_CLOSE;
+}
+
+static esp_err_t hk_json_read_string(hk_json_reader_t *reader, hk_json_token_t *token, hk_json_token_type_t type)
+{
+    // the opening quote was checked before
+    const char *start = ++reader->ptr;
+    while (reader->ptr < reader->end && *reader->ptr != '"')
+    {
+        if ((unsigned char)*reader->ptr < 0x20)
+        {
+            return hk_json_error(reader, "control character in string");
+        }
+
+        if (*reader->ptr == '\\')
+        {
+            reader->ptr++;
+        }
+
+        reader->ptr++;
+    }
+
+    if (reader->ptr >= reader->end)
+    {
+        return hk_json_error(reader, "unterminated string");
+    }
+
+    hk_json_set_token(token, type, start, reader->ptr - start);
+    reader->ptr++;
+
+    return ESP_OK;
+}
+
+static const char *hk_json_read_digits(const char *ptr, const char *end)
+{
+    while (ptr < end && *ptr >= '0' && *ptr <= '9')
+    {
+        ptr++;
+    }
+
+    return ptr;
+}
+
+static esp_err_t hk_json_read_number(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    const char *ptr = reader->ptr;
+    const char *digits = NULL;
+
+    if (*ptr == '-')
+    {
+        ptr++;
+    }
+
+    digits = ptr;
+    ptr = hk_json_read_digits(ptr, reader->end);
+    if (ptr == digits)
+    {
+        return hk_json_error(reader, "number without digits");
+    }
+    else if (*digits == '0' && ptr - digits > 1)
+    {
+        return hk_json_error(reader, "number with leading zero");
+    }
+
+    if (ptr < reader->end && *ptr == '.')
+    {
+        digits = ++ptr;
+        ptr = hk_json_read_digits(ptr, reader->end);
+        if (ptr == digits)
+        {
+            return hk_json_error(reader, "number without fraction digits");
+        }
+    }
+
+    if (ptr < reader->end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        ptr++;
+        if (ptr < reader->end && (*ptr == '+' || *ptr == '-'))
+        {
+            ptr++;
+        }
+
+        digits = ptr;
+        ptr = hk_json_read_digits(ptr, reader->end);
+        if (ptr == digits)
+        {
+            return hk_json_error(reader, "number without exponent digits");
+        }
+    }
+
+    hk_json_set_token(token, HK_JSON_NUMBER, reader->ptr, ptr - reader->ptr);
+    reader->ptr = ptr;
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_json_read_literal(hk_json_reader_t *reader, hk_json_token_t *token, const char *literal, hk_json_token_type_t type)
+{
+    size_t length = strlen(literal);
+    if (reader->end - reader->ptr < length || memcmp(reader->ptr, literal, length) != 0)
+    {
+        return hk_json_error(reader, "unknown literal");
+    }
+
+    hk_json_set_token(token, type, reader->ptr, length);
+    reader->ptr += length;
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_json_open(hk_json_reader_t *reader, hk_json_token_t *token, bool object)
+{
+    if (reader->depth >= HK_JSON_MAX_DEPTH)
+    {
+        return hk_json_error(reader, "nested too deep");
+    }
+
+    if (object)
+    {
+        reader->objects |= 1u << reader->depth;
+    }
+    else
+    {
+        reader->objects &= ~(1u << reader->depth);
+    }
+
+    reader->depth++;
+    reader->state = object ? HK_JSON_STATE_KEY_OR_CLOSE : HK_JSON_STATE_VALUE_OR_CLOSE;
+    hk_json_set_token(token, object ? HK_JSON_OBJECT_START : HK_JSON_ARRAY_START, reader->ptr++, 1);
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_json_close(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    bool object = *reader->ptr == '}';
+    if (hk_json_is_in_object(reader) != object)
+    {
+        return hk_json_error(reader, "mismatched closing bracket");
+    }
+
+    reader->depth--;
+    hk_json_value_done(reader);
+    hk_json_set_token(token, object ? HK_JSON_OBJECT_END : HK_JSON_ARRAY_END, reader->ptr++, 1);
+
+    return ESP_OK;
+}
+
+static esp_err_t hk_json_read_value(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    esp_err_t ret = ESP_OK;
+
+    switch (*reader->ptr)
+    {
+    case '{':
+        return hk_json_open(reader, token, true);
+    case '[':
+        return hk_json_open(reader, token, false);
+    case '"':
+        ret = hk_json_read_string(reader, token, HK_JSON_STRING);
+        break;
+    case 't':
+        ret = hk_json_read_literal(reader, token, "true", HK_JSON_TRUE);
+        break;
+    case 'f':
+        ret = hk_json_read_literal(reader, token, "false", HK_JSON_FALSE);
+        break;
+    case 'n':
+        ret = hk_json_read_literal(reader, token, "null", HK_JSON_NULL);
+        break;
+    default:
+        if (*reader->ptr == '-' || (*reader->ptr >= '0' && *reader->ptr <= '9'))
+        {
+            ret = hk_json_read_number(reader, token);
+        }
+        else
+        {
+            return hk_json_error(reader, "unexpected character");
+        }
+    }
+
+    if (ret == ESP_OK)
+    {
+        hk_json_value_done(reader);
+    }
+
+    return ret;
+}
+
+static esp_err_t hk_json_read_key(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    if (*reader->ptr != '"')
+    {
+        return hk_json_error(reader, "expected key");
+    }
+
+    esp_err_t ret = hk_json_read_string(reader, token, HK_JSON_KEY);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    hk_json_skip_whitespace(reader);
+    if (reader->ptr >= reader->end || *reader->ptr != ':')
+    {
+        return hk_json_error(reader, "missing colon after key");
+    }
+
+    reader->ptr++;
+    reader->state = HK_JSON_STATE_VALUE;
+
+    return ESP_OK;
+}
+
+void hk_json_reader_init(hk_json_reader_t *reader, const char *data, size_t size)
+{
+    reader->ptr = data;
+    reader->end = data + size;
+    reader->objects = 0;
+    reader->depth = 0;
+    reader->state = HK_JSON_STATE_VALUE;
+}
+
+esp_err_t hk_json_reader_next(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    if (reader->state == HK_JSON_STATE_DONE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    hk_json_skip_whitespace(reader);
+
+    if (reader->state == HK_JSON_STATE_END)
+    {
+        if (reader->ptr != reader->end)
+        {
+            return hk_json_error(reader, "content after root value");
+        }
+
+        reader->state = HK_JSON_STATE_DONE;
+        hk_json_set_token(token, HK_JSON_END, reader->ptr, 0);
+        return ESP_OK;
+    }
+
+    if (reader->ptr >= reader->end)
+    {
+        return hk_json_error(reader, "unexpected end");
+    }
+
+    char c = *reader->ptr;
+    switch (reader->state)
+    {
+    case HK_JSON_STATE_SEPARATOR_OR_CLOSE:
+        if (c == '}' || c == ']')
+        {
+            return hk_json_close(reader, token);
+        }
+        else if (c != ',')
+        {
+            return hk_json_error(reader, "missing separator");
+        }
+
+        reader->ptr++;
+        hk_json_skip_whitespace(reader);
+        if (reader->ptr >= reader->end)
+        {
+            return hk_json_error(reader, "unexpected end");
+        }
+
+        return hk_json_is_in_object(reader) ? hk_json_read_key(reader, token) : hk_json_read_value(reader, token);
+    case HK_JSON_STATE_KEY_OR_CLOSE:
+        if (c == '}')
+        {
+            return hk_json_close(reader, token);
+        }
+        return hk_json_read_key(reader, token);
+    case HK_JSON_STATE_VALUE_OR_CLOSE:
+        if (c == ']')
+        {
+            return hk_json_close(reader, token);
+        }
+        return hk_json_read_value(reader, token);
+    case HK_JSON_STATE_KEY:
+        return hk_json_read_key(reader, token);
+    default:
+        return hk_json_read_value(reader, token);
+    }
+}
+
+esp_err_t hk_json_reader_skip(hk_json_reader_t *reader, hk_json_token_t *token)
+{
+    if (token->type != HK_JSON_OBJECT_START && token->type != HK_JSON_ARRAY_START)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+    uint8_t depth = reader->depth - 1;
+    hk_json_token_t skipped;
+    while (ret == ESP_OK && reader->depth > depth)
+    {
+        ret = hk_json_reader_next(reader, &skipped);
+    }
+
+    return ret;
+}
+
+bool hk_json_token_equal_str(hk_json_token_t *token, const char *str)
+{
+    return strlen(str) == token->length && memcmp(token->ptr, str, token->length) == 0;
+}
+
+static int hk_json_hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+static esp_err_t hk_json_read_hex4(const char *ptr, const char *end, uint32_t *code_point)
+{
+    *code_point = 0;
+    if (end - ptr < 4)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        int value = hk_json_hex_value(ptr[i]);
+        if (value < 0)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        *code_point = (*code_point << 4) | value;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hk_json_unescape(char *ptr, size_t length, size_t *unescaped_length)
+{
+    const char *read = ptr;
+    const char *end = ptr + length;
+    char *write = ptr;
+
+    while (read < end)
+    {
+        if (*read != '\\')
+        {
+            *write++ = *read++;
+            continue;
+        }
+
+        if (++read >= end)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        char c = *read++;
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            *write++ = c;
+            break;
+        case 'b':
+            *write++ = '\b';
+            break;
+        case 'f':
+            *write++ = '\f';
+            break;
+        case 'n':
+            *write++ = '\n';
+            break;
+        case 'r':
+            *write++ = '\r';
+            break;
+        case 't':
+            *write++ = '\t';
+            break;
+        case 'u':
+        {
+            uint32_t code_point = 0;
+            if (hk_json_read_hex4(read, end, &code_point) != ESP_OK)
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+            read += 4;
+
+            if (code_point >= 0xd800 && code_point <= 0xdbff)
+            {
+                // a surrogate pair is written as one code point
+                uint32_t low = 0;
+                if (end - read < 6 || read[0] != '\\' || read[1] != 'u' ||
+                    hk_json_read_hex4(read + 2, end, &low) != ESP_OK || low < 0xdc00 || low > 0xdfff)
+                {
+                    return ESP_ERR_INVALID_ARG;
+                }
+                read += 6;
+                code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+            }
+
+            // utf8 is never longer than the escape sequence
+            if (code_point < 0x80)
+            {
+                *write++ = code_point;
+            }
+            else if (code_point < 0x800)
+            {
+                *write++ = 0xc0 | (code_point >> 6);
+                *write++ = 0x80 | (code_point & 0x3f);
+            }
+            else if (code_point < 0x10000)
+            {
+                *write++ = 0xe0 | (code_point >> 12);
+                *write++ = 0x80 | ((code_point >> 6) & 0x3f);
+                *write++ = 0x80 | (code_point & 0x3f);
+            }
+            else
+            {
+                *write++ = 0xf0 | (code_point >> 18);
+                *write++ = 0x80 | ((code_point >> 12) & 0x3f);
+                *write++ = 0x80 | ((code_point >> 6) & 0x3f);
+                *write++ = 0x80 | (code_point & 0x3f);
+            }
+            break;
+        }
+        default:
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    *unescaped_length = write - ptr;
+
+    return ESP_OK;
+}
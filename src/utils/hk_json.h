@@ -0,0 +1,120 @@
+/**
+ * @file hk_json.h
+ *
+ * A pull parser to read json in place, without allocating memory.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+/**
+ * @brief The maximum nesting depth of the json reader.
+ */
+#define HK_JSON_MAX_DEPTH 32
+
+/**
+ * @brief The type of a json token.
+ */
+typedef enum
+{
+    HK_JSON_OBJECT_START,
+    HK_JSON_OBJECT_END,
+    HK_JSON_ARRAY_START,
+    HK_JSON_ARRAY_END,
+    HK_JSON_KEY,
+    HK_JSON_STRING,
+    HK_JSON_NUMBER,
+    HK_JSON_TRUE,
+    HK_JSON_FALSE,
+    HK_JSON_NULL,
+    HK_JSON_END
+} hk_json_token_type_t;
+
+/**
+ * @brief A json token.
+ *
+ * A token points into the buffer that is read. Keys and strings point to the content between the quotes,
+ * escape sequences are not resolved.
+ */
+typedef struct
+{
+    hk_json_token_type_t type;
+    const char *ptr;
+    size_t length;
+} hk_json_token_t;
+
+/**
+ * @brief A json reader.
+ */
+typedef struct
+{
+    const char *ptr;
+    const char *end;
+    uint32_t objects;
+    uint8_t depth;
+    uint8_t state;
+} hk_json_reader_t;
+
+/**
+ * @brief Initializes a json reader.
+ *
+ * Initializes a json reader. The buffer has to stay valid while reading, it does not have to be null terminated.
+ *
+ * @param reader The reader.
+ * @param data The json buffer.
+ * @param size The size of the json buffer.
+ */
+void hk_json_reader_init(hk_json_reader_t *reader, const char *data, size_t size);
+
+/**
+ * @brief Reads the next token.
+ *
+ * Reads the next token and checks the json syntax on the way.
+ *
+ * @param reader The reader.
+ * @param token The token that was read.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_ARG if the json is invalid.
+ */
+esp_err_t hk_json_reader_next(hk_json_reader_t *reader, hk_json_token_t *token);
+
+/**
+ * @brief Skips a value.
+ *
+ * Skips the value, that starts with the given token. Objects and arrays are skipped with all their content.
+ *
+ * @param reader The reader.
+ * @param token The first token of the value.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_json_reader_skip(hk_json_reader_t *reader, hk_json_token_t *token);
+
+/**
+ * @brief Compares a token.
+ *
+ * Compares the content of a token with a null terminated string.
+ *
+ * @param token The token.
+ * @param str The string.
+ * 
+ * @return Returns true if the token equals the string.
+ */
+bool hk_json_token_equal_str(hk_json_token_t *token, const char *str);
+
+/**
+ * @brief Resolves escape sequences.
+ *
+ * Resolves the escape sequences of a string in place. The result is never longer than the escaped string.
+ *
+ * @param ptr The escaped string.
+ * @param length The length of the escaped string.
+ * @param unescaped_length The length of the unescaped string.
+ * 
+ * @return Returns an esp_err_t result. ESP_ERR_INVALID_ARG if an escape sequence is invalid.
+ */
+esp_err_t hk_json_unescape(char *ptr, size_t length, size_t *unescaped_length);
@@ -0,0 +1,79 @@
+#include "hk_pool.h"
+
+esp_err_t hk_pool_init(hk_pool_t *pool, hk_alloc_subsystem_t subsystem, size_t block_size, size_t capacity)
+{
+    if (block_size == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pool->blocks = (char **)malloc(sizeof(char *) * capacity);
+    if (pool->blocks == NULL && capacity > 0)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->subsystem = subsystem;
+    pool->block_size = block_size;
+    pool->capacity = capacity;
+    pool->count = 0;
+    pool->taken_count = 0;
+
+    return ESP_OK;
+}
+
+char *hk_pool_take(hk_pool_t *pool)
+{
+    char *block = NULL;
+
+    if (pool->count > 0)
+    {
+        block = pool->blocks[--pool->count];
+    }
+    else
+    {
+        block = (char *)hk_alloc_malloc(pool->subsystem, pool->block_size);
+    }
+
+    if (block != NULL)
+    {
+        pool->taken_count++;
+    }
+
+    return block;
+}
+
+void hk_pool_give(hk_pool_t *pool, char *block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+
+    pool->taken_count--;
+
+    if (pool->count < pool->capacity)
+    {
+        pool->blocks[pool->count++] = block;
+    }
+    else
+    {
+        hk_alloc_free(pool->subsystem, block);
+    }
+}
+
+size_t hk_pool_get_taken_count(hk_pool_t *pool)
+{
+    return pool->taken_count;
+}
+
+void hk_pool_free(hk_pool_t *pool)
+{
+    while (pool->count > 0)
+    {
+        hk_alloc_free(pool->subsystem, pool->blocks[--pool->count]);
+    }
+
+    free(pool->blocks);
+    pool->blocks = NULL;
+}
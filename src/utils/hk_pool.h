@@ -0,0 +1,77 @@
+/**
+ * @file hk_pool.h
+ *
+ * A pool of equally sized buffers, which keeps returned buffers for reuse.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <esp_err.h>
+
+#include "hk_alloc.h"
+
+typedef struct
+{
+    char **blocks;
+    hk_alloc_subsystem_t subsystem;
+    size_t block_size;
+    size_t capacity;
+    size_t count;
+    size_t taken_count;
+} hk_pool_t;
+
+/**
+ * @brief Initializes a pool.
+ *
+ * Allocates the list of kept buffers. Buffers are allocated on demand, so an unused pool costs no buffers.
+ *
+ * @param pool The pool to initialize.
+ * @param subsystem The subsystem, whose heap region the buffers are allocated in.
+ * @param block_size The size of a buffer.
+ * @param capacity The maximum number of returned buffers, which are kept for reuse.
+ *
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_pool_init(hk_pool_t *pool, hk_alloc_subsystem_t subsystem, size_t block_size, size_t capacity);
+
+/**
+ * @brief Takes a buffer.
+ *
+ * Takes a kept buffer, or allocates a new one if none is kept. Not synchronized, so take and give from one task only.
+ *
+ * @param pool The pool.
+ *
+ * @return Returns the buffer, or NULL if no memory is left.
+ */
+char *hk_pool_take(hk_pool_t *pool);
+
+/**
+ * @brief Gives a buffer back.
+ *
+ * Keeps the buffer for reuse, or frees it if the pool keeps capacity buffers already.
+ *
+ * @param pool The pool.
+ * @param block The buffer, which was taken from the pool. Can be NULL.
+ */
+void hk_pool_give(hk_pool_t *pool, char *block);
+
+/**
+ * @brief Returns the number of taken buffers.
+ *
+ * Returns the number of buffers, which were taken and not given back yet.
+ *
+ * @param pool The pool.
+ *
+ * @return Returns the number of taken buffers.
+ */
+size_t hk_pool_get_taken_count(hk_pool_t *pool);
+
+/**
+ * @brief Frees a pool.
+ *
+ * Frees the kept buffers. Taken buffers have to be given back before.
+ *
+ * @param pool The pool.
+ */
+void hk_pool_free(hk_pool_t *pool);
@@ -0,0 +1,91 @@
+#include "hk_queue.h"
+
+#include <string.h>
+
+esp_err_t hk_queue_init(hk_queue_t *queue, size_t item_size, size_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    queue->items = (char *)malloc(item_size * capacity);
+    queue->sequences = (atomic_size_t *)malloc(sizeof(atomic_size_t) * capacity);
+    if (queue->items == NULL || queue->sequences == NULL)
+    {
+        hk_queue_free(queue);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // the sequence of a slot tells, for which position it can be written (sequence == position)
+    // or read (sequence == position + 1)
+    for (size_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&queue->sequences[i], i);
+    }
+
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    atomic_init(&queue->head, 0);
+    queue->tail = 0;
+
+    return ESP_OK;
+}
+
+bool hk_queue_push(hk_queue_t *queue, const void *item)
+{
+    size_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    while (true)
+    {
+        size_t index = position & (queue->capacity - 1);
+        size_t sequence = atomic_load_explicit(&queue->sequences[index], memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0)
+        {
+            // claiming the slot; on failure the position is reloaded and we try the next one
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                memcpy(queue->items + index * queue->item_size, item, queue->item_size);
+                atomic_store_explicit(&queue->sequences[index], position + 1, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // the slot was not read yet, since the last round
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool hk_queue_pop(hk_queue_t *queue, void *item)
+{
+    size_t position = queue->tail;
+    size_t index = position & (queue->capacity - 1);
+    size_t sequence = atomic_load_explicit(&queue->sequences[index], memory_order_acquire);
+
+    if (sequence != position + 1)
+    {
+        return false;
+    }
+
+    memcpy(item, queue->items + index * queue->item_size, queue->item_size);
+    atomic_store_explicit(&queue->sequences[index], position + queue->capacity, memory_order_release);
+    queue->tail = position + 1;
+
+    return true;
+}
+
+void hk_queue_free(hk_queue_t *queue)
+{
+    free(queue->items);
+    free(queue->sequences);
+    queue->items = NULL;
+    queue->sequences = NULL;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file hk_queue.h
+ *
+ * A bounded lock-free queue for many producers and a single consumer.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <esp_err.h>
+
+typedef struct
+{
+    char *items;
+    atomic_size_t *sequences;
+    size_t item_size;
+    size_t capacity;
+    atomic_size_t head;
+    size_t tail;
+} hk_queue_t;
+
+/**
+ * @brief Initializes a queue.
+ *
+ * Allocates the slots of the queue. Pushing never allocates afterwards.
+ *
+ * @param queue The queue to initialize.
+ * @param item_size The size of an item.
+ * @param capacity The maximum number of items. Has to be a power of two.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_queue_init(hk_queue_t *queue, size_t item_size, size_t capacity);
+
+/**
+ * @brief Pushes an item.
+ *
+ * Copies an item into the queue. Can be called from any task and from interrupts, as it never blocks and
+ * never waits for other producers.
+ *
+ * @param queue The queue.
+ * @param item The item to copy.
+ * 
+ * @return Returns false if the queue is full.
+ */
+bool hk_queue_push(hk_queue_t *queue, const void *item);
+
+/**
+ * @brief Pops an item.
+ *
+ * Copies the oldest item out of the queue. Must only be called by the consumer.
+ *
+ * @param queue The queue.
+ * @param item The output for the item.
+ * 
+ * @return Returns false if the queue is empty, or the oldest item is still being written.
+ */
+bool hk_queue_pop(hk_queue_t *queue, void *item);
+
+/**
+ * @brief Frees a queue.
+ *
+ * Frees the slots of a queue.
+ *
+ * @param queue The queue.
+ */
+void hk_queue_free(hk_queue_t *queue);
@@ -0,0 +1,50 @@
+#include "hk_rcu.h"
+
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+void hk_rcu_init(hk_rcu_t *rcu, void *ptr)
+{
+    atomic_init(&rcu->ptr, ptr);
+    atomic_init(&rcu->epoch, 0);
+    atomic_init(&rcu->readers[0], 0);
+    atomic_init(&rcu->readers[1], 0);
+}
+
+void *hk_rcu_read_lock(hk_rcu_t *rcu, uint8_t *reader)
+{
+    while (true)
+    {
+        unsigned int epoch = atomic_load(&rcu->epoch);
+        atomic_fetch_add(&rcu->readers[epoch & 1], 1);
+
+        // if a writer flipped the epoch in between, it might not have seen us, so we retry in the new one
+        if (atomic_load(&rcu->epoch) == epoch)
+        {
+            *reader = epoch & 1;
+            return atomic_load(&rcu->ptr);
+        }
+
+        atomic_fetch_sub(&rcu->readers[epoch & 1], 1);
+    }
+}
+
+void hk_rcu_read_unlock(hk_rcu_t *rcu, uint8_t reader)
+{
+    atomic_fetch_sub(&rcu->readers[reader], 1);
+}
+
+void *hk_rcu_publish(hk_rcu_t *rcu, void *ptr)
+{
+    void *old_ptr = atomic_exchange(&rcu->ptr, ptr);
+    unsigned int old_epoch = atomic_fetch_add(&rcu->epoch, 1);
+
+    // new readers count in the other slot, so this one drains
+    while (atomic_load(&rcu->readers[old_epoch & 1]) > 0)
+    {
+        vTaskDelay(1);
+    }
+
+    return old_ptr;
+}
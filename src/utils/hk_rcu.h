@@ -0,0 +1,63 @@
+/**
+ * @file hk_rcu.h
+ *
+ * Publishing of immutable data to lock free readers, in the style of read-copy-update.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef struct
+{
+    _Atomic(void *) ptr;
+    atomic_uint epoch;
+    atomic_uint readers[2];
+} hk_rcu_t;
+
+/**
+ * @brief Initializes the publisher.
+ *
+ * Initializes the publisher with a first version of the data.
+ *
+ * @param rcu The publisher.
+ * @param ptr The first version, or NULL.
+ */
+void hk_rcu_init(hk_rcu_t *rcu, void *ptr);
+
+/**
+ * @brief Starts reading.
+ *
+ * Returns the current version, which stays valid until hk_rcu_read_unlock is called. Never blocks, so it
+ * can be used from any task and from interrupts.
+ *
+ * @param rcu The publisher.
+ * @param reader The output for the reader slot, to be passed to hk_rcu_read_unlock.
+ * 
+ * @return Returns the current version.
+ */
+void *hk_rcu_read_lock(hk_rcu_t *rcu, uint8_t *reader);
+
+/**
+ * @brief Ends reading.
+ *
+ * Ends reading. The version returned by hk_rcu_read_lock must not be used afterwards.
+ *
+ * @param rcu The publisher.
+ * @param reader The reader slot, returned by hk_rcu_read_lock.
+ */
+void hk_rcu_read_unlock(hk_rcu_t *rcu, uint8_t reader);
+
+/**
+ * @brief Publishes a new version.
+ *
+ * Publishes a new version and waits until all readers of the previous version are done. Writers have to be
+ * serialized by the caller, and must not hold a read lock themselves.
+ *
+ * @param rcu The publisher.
+ * @param ptr The new version.
+ * 
+ * @return Returns the previous version, which can be reclaimed by the caller.
+ */
+void *hk_rcu_publish(hk_rcu_t *rcu, void *ptr);
@@ -0,0 +1,200 @@
+#include "hk_recorder.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "hk_alloc.h"
+#include "hk_base64.h"
+#include "hk_logging.h"
+#include "hk_util.h"
+
+char *hk_recorder_buffer = NULL;
+size_t hk_recorder_size = 0;
+size_t hk_recorder_oldest = 0; // position of the oldest record
+size_t hk_recorder_used = 0;
+size_t hk_recorder_dropped_count = 0;
+SemaphoreHandle_t hk_recorder_mutex = NULL;
+
+static void hk_recorder_write(size_t position, const char *data, size_t length)
+{
+    position %= hk_recorder_size;
+    size_t first = MIN(length, hk_recorder_size - position);
+    memcpy(hk_recorder_buffer + position, data, first);
+    memcpy(hk_recorder_buffer, data + first, length - first);
+}
+
+static void hk_recorder_read(size_t position, char *data, size_t length)
+{
+    position %= hk_recorder_size;
+    size_t first = MIN(length, hk_recorder_size - position);
+    memcpy(data, hk_recorder_buffer + position, first);
+    memcpy(data + first, hk_recorder_buffer, length - first);
+}
+
+static void hk_recorder_drop_oldest()
+{
+    hk_recorder_header_t header;
+    hk_recorder_read(hk_recorder_oldest, (char *)&header, sizeof(hk_recorder_header_t));
+
+    size_t record_size = sizeof(hk_recorder_header_t) + header.length;
+    hk_recorder_oldest = (hk_recorder_oldest + record_size) % hk_recorder_size;
+    hk_recorder_used -= record_size;
+    hk_recorder_dropped_count++;
+}
+
+esp_err_t hk_recorder_init(size_t size)
+{
+    if (size < sizeof(hk_recorder_header_t))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (hk_recorder_mutex == NULL)
+    {
+        hk_recorder_mutex = xSemaphoreCreateMutex();
+    }
+
+    xSemaphoreTake(hk_recorder_mutex, portMAX_DELAY);
+
+    if (hk_recorder_buffer != NULL)
+    {
+        // hk_init is called again on reconnect, the records of the reconnect are kept
+        xSemaphoreGive(hk_recorder_mutex);
+        return ESP_OK;
+    }
+
+    hk_recorder_buffer = (char *)hk_alloc_malloc(HK_ALLOC_RECORDER, size);
+    hk_recorder_size = hk_recorder_buffer != NULL ? size : 0;
+    hk_recorder_oldest = 0;
+    hk_recorder_used = 0;
+    hk_recorder_dropped_count = 0;
+
+    xSemaphoreGive(hk_recorder_mutex);
+
+    if (hk_recorder_buffer == NULL)
+    {
+        HK_LOGE("Could not allocate %d bytes for recording.", size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    HK_LOGW("Recording plain traffic into %d bytes.", size);
+    return ESP_OK;
+}
+
+void hk_recorder_record(hk_recorder_kind_t kind, int connection, const char *data, size_t length)
+{
+    if (hk_recorder_buffer == NULL)
+    {
+        return;
+    }
+
+    hk_recorder_header_t header = {
+        .time = esp_timer_get_time(),
+        .free_heap = esp_get_free_heap_size(),
+        .connection = (uint16_t)connection,
+        .kind = (uint8_t)kind};
+
+    // records, which do not fit, are truncated
+    length = MIN(length, MIN(UINT16_MAX, hk_recorder_size - sizeof(hk_recorder_header_t)));
+    header.length = (uint16_t)length;
+    size_t record_size = sizeof(hk_recorder_header_t) + length;
+
+    xSemaphoreTake(hk_recorder_mutex, portMAX_DELAY);
+
+    while (hk_recorder_used + record_size > hk_recorder_size)
+    {
+        hk_recorder_drop_oldest();
+    }
+
+    size_t position = hk_recorder_oldest + hk_recorder_used;
+    hk_recorder_write(position, (char *)&header, sizeof(hk_recorder_header_t));
+    hk_recorder_write(position + sizeof(hk_recorder_header_t), data, length);
+    hk_recorder_used += record_size;
+
+    xSemaphoreGive(hk_recorder_mutex);
+}
+
+esp_err_t hk_recorder_export(hk_mem *trace)
+{
+    if (hk_recorder_buffer == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(hk_recorder_mutex, portMAX_DELAY);
+
+    hk_mem_set(trace, hk_recorder_used);
+    hk_recorder_read(hk_recorder_oldest, trace->ptr, hk_recorder_used);
+
+    xSemaphoreGive(hk_recorder_mutex);
+
+    return ESP_OK;
+}
+
+esp_err_t hk_recorder_print()
+{
+    hk_mem *trace = hk_mem_init();
+    esp_err_t ret = hk_recorder_export(trace);
+
+    if (ret == ESP_OK)
+    {
+        HK_LOGI("Printing %d bytes of records, %d records were dropped.", trace->size, hk_recorder_dropped_count);
+
+        size_t position = 0;
+        while (position < trace->size)
+        {
+            hk_recorder_header_t *header = (hk_recorder_header_t *)(trace->ptr + position);
+            size_t record_size = sizeof(hk_recorder_header_t) + header->length;
+            char *encoded = (char *)malloc(hk_base64_encoded_size(record_size) + 1);
+
+            hk_base64_encode(trace->ptr + position, record_size, encoded);
+            printf("hk_recorder %s\n", encoded);
+
+            free(encoded);
+            position += record_size;
+        }
+    }
+
+    hk_mem_free(trace);
+
+    return ret;
+}
+
+size_t hk_recorder_get_dropped_count()
+{
+    return hk_recorder_dropped_count;
+}
+
+void hk_recorder_clear()
+{
+    if (hk_recorder_buffer == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(hk_recorder_mutex, portMAX_DELAY);
+    hk_recorder_oldest = 0;
+    hk_recorder_used = 0;
+    hk_recorder_dropped_count = 0;
+    xSemaphoreGive(hk_recorder_mutex);
+}
+
+void hk_recorder_free()
+{
+    if (hk_recorder_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(hk_recorder_mutex, portMAX_DELAY);
+    hk_alloc_free(HK_ALLOC_RECORDER, hk_recorder_buffer);
+    hk_recorder_buffer = NULL;
+    hk_recorder_size = 0;
+    hk_recorder_oldest = 0;
+    hk_recorder_used = 0;
+    xSemaphoreGive(hk_recorder_mutex);
+}
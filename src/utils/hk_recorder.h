@@ -0,0 +1,111 @@
+/**
+ * @file hk_recorder.h
+ *
+ * Records the plain traffic of controllers into a ring buffer, to replay it for benchmarks.
+ *
+ * Every record consists of a packed header (time in microseconds since boot as int64, free heap as uint32, connection
+ * as uint16, length as uint16 and kind as uint8, all little endian) followed by the data. If the buffer is full, the
+ * oldest records are dropped. Recording is compiled in with ESP32_HAP_RECORDER only, as the records contain the
+ * decrypted traffic.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <sdkconfig.h>
+
+#include "../include/hk_mem.h"
+
+typedef enum
+{
+    HK_RECORDER_IP_REQUEST = 1,
+    HK_RECORDER_IP_RESPONSE = 2,
+    HK_RECORDER_IP_EVENT = 3,
+    HK_RECORDER_BLE_REQUEST = 4,
+    HK_RECORDER_BLE_RESPONSE = 5
+} hk_recorder_kind_t;
+
+typedef struct __attribute__((packed))
+{
+    int64_t time;
+    uint32_t free_heap;
+    uint16_t connection;
+    uint16_t length;
+    uint8_t kind;
+} hk_recorder_header_t;
+
+#ifdef CONFIG_ESP32_HAP_RECORDER
+#define HK_RECORDER_RECORD(kind, connection, data, length) hk_recorder_record(kind, connection, data, length)
+#else
+#define HK_RECORDER_RECORD(kind, connection, data, length)
+#endif
+
+/**
+ * @brief Initializes the recorder.
+ *
+ * Allocates the ring buffer. Records are only taken after the recorder was initialized. If the recorder is
+ * initialized already, the ring buffer and its records are kept. Call hk_recorder_free first to change the size.
+ *
+ * @param size The size of the ring buffer in bytes.
+ *
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_recorder_init(size_t size);
+
+/**
+ * @brief Records plain traffic.
+ *
+ * Records plain traffic. Use HK_RECORDER_RECORD in the stacks, so recording is compiled out if it is not configured.
+ *
+ * @param kind The kind of the traffic.
+ * @param connection The socket or the connection handle.
+ * @param data The plain data.
+ * @param length The length of the data.
+ */
+void hk_recorder_record(hk_recorder_kind_t kind, int connection, const char *data, size_t length);
+
+/**
+ * @brief Exports the records.
+ *
+ * Copies all records, beginning with the oldest, into the trace. The trace can be written to a file.
+ *
+ * @param trace The trace.
+ *
+ * @return Returns ESP_ERR_INVALID_STATE, if the recorder was not initialized.
+ */
+esp_err_t hk_recorder_export(hk_mem *trace);
+
+/**
+ * @brief Prints the records.
+ *
+ * Prints every record as a line of 'hk_recorder <base64 of header and data>' to stdout, beginning with the oldest.
+ * The output of the monitor can be read by tools/hk_replay.py.
+ *
+ * @return Returns ESP_ERR_INVALID_STATE, if the recorder was not initialized.
+ */
+esp_err_t hk_recorder_print();
+
+/**
+ * @brief Returns the number of dropped records.
+ *
+ * Returns the number of records, which were dropped, because the ring buffer was full.
+ *
+ * @return Returns the number of dropped records.
+ */
+size_t hk_recorder_get_dropped_count();
+
+/**
+ * @brief Removes all records.
+ *
+ * Removes all records.
+ */
+void hk_recorder_clear();
+
+/**
+ * @brief Frees the recorder.
+ *
+ * Frees the ring buffer and stops recording.
+ */
+void hk_recorder_free();
@@ -0,0 +1,75 @@
+#include "hk_slice.h"
+
+#include <string.h>
+#include <stdint.h>
+
+hk_slice_t hk_slice_init(const char *ptr, size_t size)
+{
+    hk_slice_t slice = {.ptr = ptr, .size = size};
+    return slice;
+}
+
+hk_slice_t hk_slice_from_mem(const hk_mem *mem)
+{
+    return hk_slice_init(mem->ptr, mem->size);
+}
+
+hk_slice_t hk_slice_from_str(const char *string)
+{
+    return hk_slice_init(string, strlen(string));
+}
+
+hk_slice_t hk_slice_sub(hk_slice_t slice, size_t offset, size_t size)
+{
+    if (offset > slice.size)
+    {
+        offset = slice.size;
+    }
+
+    if (size > slice.size - offset)
+    {
+        size = slice.size - offset;
+    }
+
+    return hk_slice_init(slice.ptr + offset, size);
+}
+
+bool hk_slice_equal(hk_slice_t slice1, hk_slice_t slice2)
+{
+    return slice1.size == slice2.size && (slice1.size == 0 || memcmp(slice1.ptr, slice2.ptr, slice1.size) == 0);
+}
+
+bool hk_slice_equal_str(hk_slice_t slice, const char *string)
+{
+    return hk_slice_equal(slice, hk_slice_from_str(string));
+}
+
+bool hk_slice_starts_with(hk_slice_t slice, const char *prefix)
+{
+    size_t prefix_size = strlen(prefix);
+    return prefix_size <= slice.size && memcmp(slice.ptr, prefix, prefix_size) == 0;
+}
+
+esp_err_t hk_slice_to_size(hk_slice_t slice, size_t *value)
+{
+    size_t result = 0;
+
+    if (slice.size == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < slice.size; i++)
+    {
+        char digit = slice.ptr[i];
+        if (digit < '0' || digit > '9' || result > (SIZE_MAX - (digit - '0')) / 10)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        result = result * 10 + (digit - '0');
+    }
+
+    *value = result;
+    return ESP_OK;
+}
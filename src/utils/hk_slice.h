@@ -0,0 +1,117 @@
+/**
+ * @file hk_slice.h
+ *
+ * A view of memory, which does not own the data it points to.
+ *
+ * Slices are passed by value and are only valid as long as the memory they point to. Use them to look at data, which
+ * is owned by an hk_mem, a tlv or a buffer, without copying it.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#include "../include/hk_mem.h"
+
+typedef struct
+{
+    const char *ptr;
+    size_t size;
+} hk_slice_t;
+
+/**
+ * @brief Creates a slice.
+ *
+ * Creates a slice of a buffer.
+ *
+ * @param ptr The buffer.
+ * @param size The size of the buffer.
+ *
+ * @return Returns the slice.
+ */
+hk_slice_t hk_slice_init(const char *ptr, size_t size);
+
+/**
+ * @brief Creates a slice of a memory.
+ *
+ * Creates a slice, which is valid until the memory is changed or freed.
+ *
+ * @param mem The memory.
+ *
+ * @return Returns the slice.
+ */
+hk_slice_t hk_slice_from_mem(const hk_mem *mem);
+
+/**
+ * @brief Creates a slice of a string.
+ *
+ * Creates a slice of a string without its terminator.
+ *
+ * @param string The string.
+ *
+ * @return Returns the slice.
+ */
+hk_slice_t hk_slice_from_str(const char *string);
+
+/**
+ * @brief Returns a part of a slice.
+ *
+ * Returns a part of a slice. The part is cut at the end of the slice.
+ *
+ * @param slice The slice.
+ * @param offset The offset of the part.
+ * @param size The size of the part.
+ *
+ * @return Returns the part.
+ */
+hk_slice_t hk_slice_sub(hk_slice_t slice, size_t offset, size_t size);
+
+/**
+ * @brief Compares two slices.
+ *
+ * Compares the size and the content of two slices.
+ *
+ * @param slice1 The first slice.
+ * @param slice2 The second slice.
+ *
+ * @return Returns true if equal.
+ */
+bool hk_slice_equal(hk_slice_t slice1, hk_slice_t slice2);
+
+/**
+ * @brief Compares a slice with a string.
+ *
+ * Compares a slice with a string, without its terminator.
+ *
+ * @param slice The slice.
+ * @param string The string.
+ *
+ * @return Returns true if equal.
+ */
+bool hk_slice_equal_str(hk_slice_t slice, const char *string);
+
+/**
+ * @brief Checks the prefix of a slice.
+ *
+ * Checks if a slice begins with a string.
+ *
+ * @param slice The slice.
+ * @param prefix The string.
+ *
+ * @return Returns true if the slice begins with the string.
+ */
+bool hk_slice_starts_with(hk_slice_t slice, const char *prefix);
+
+/**
+ * @brief Parses a number.
+ *
+ * Parses the whole slice as a decimal number, without a terminator.
+ *
+ * @param slice The slice.
+ * @param value The number.
+ *
+ * @return Returns ESP_ERR_INVALID_ARG, if the slice is empty, contains other characters than digits or overflows.
+ */
+esp_err_t hk_slice_to_size(hk_slice_t slice, size_t *value);
@@ -1,12 +1,42 @@
 #include "hk_store.h"
 
+#include <string.h>
 #include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 #include "hk_logging.h"
+#include "hk_tasks.h"
 #include "hk_util.h"
 
+typedef enum
+{
+    HK_STORE_ENTRY_U8,
+    HK_STORE_ENTRY_U16,
+    HK_STORE_ENTRY_BLOB,
+    HK_STORE_ENTRY_ERASED
+} hk_store_entry_type_t;
+
+typedef struct
+{
+    bool used;
+    char key[16]; // nvs keys have at most 15 characters
+    hk_store_entry_type_t type;
+    uint16_t number;
+    hk_mem blob;
+    bool written; // set while flushing, if the entry was written and waits for the commit
+} hk_store_entry_t;
+
 nvs_handle hk_store_handle;
 const char *hk_store_name = "hk_store";
+hk_store_entry_t *hk_store_entries = NULL;
+size_t hk_store_entries_size = 0;
+hk_store_entry_t *hk_store_flushing_entries = NULL; // taken out of the list while being written, still read
+size_t hk_store_flushing_entries_size = 0;
+SemaphoreHandle_t hk_store_mutex = NULL;       // guards the lists, never held while writing flash
+SemaphoreHandle_t hk_store_flush_mutex = NULL; // serializes flushes
+TaskHandle_t hk_store_task_handle = NULL;
 
 #define RUN_AND_CHECK_STORE(ret, func, args...)                          \
     ret = func(args);                                                    \
@@ -23,6 +53,281 @@ const char *hk_store_name = "hk_store";
         HK_LOGE("Error executing: %s (%d)", esp_err_to_name(ret), ret); \
     }
 
+static hk_store_entry_t *hk_store_entry_find(hk_store_entry_t *entries, size_t entries_size, const char *key)
+{
+    for (size_t i = 0; i < entries_size; i++)
+    {
+        if (entries[i].used && strcmp(entries[i].key, key) == 0)
+        {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static hk_store_entry_t *hk_store_entry_find_unused()
+{
+    for (size_t i = 0; i < hk_store_entries_size; i++)
+    {
+        if (!hk_store_entries[i].used)
+        {
+            return &hk_store_entries[i];
+        }
+    }
+
+    if (hk_store_entries_size >= HK_STORE_DIRTY_MAX_SIZE)
+    {
+        return NULL;
+    }
+
+    // the list grows instead of writing flash on the path of the caller
+    size_t size = hk_store_entries_size + HK_STORE_DIRTY_SIZE;
+    hk_store_entry_t *entries = (hk_store_entry_t *)realloc(hk_store_entries, size * sizeof(hk_store_entry_t));
+    if (entries == NULL)
+    {
+        return NULL;
+    }
+
+    memset(entries + hk_store_entries_size, 0, HK_STORE_DIRTY_SIZE * sizeof(hk_store_entry_t));
+    hk_store_entries = entries;
+    hk_store_entries_size = size;
+
+    return &hk_store_entries[size - HK_STORE_DIRTY_SIZE];
+}
+
+static esp_err_t hk_store_entry_write(hk_store_entry_t *entry)
+{
+    esp_err_t ret = ESP_OK;
+
+    switch (entry->type)
+    {
+    case HK_STORE_ENTRY_U8:
+        RUN_AND_CHECK_STORE(ret, nvs_set_u8, hk_store_handle, entry->key, (uint8_t)entry->number);
+        break;
+    case HK_STORE_ENTRY_U16:
+        RUN_AND_CHECK_STORE(ret, nvs_set_u16, hk_store_handle, entry->key, entry->number);
+        break;
+    case HK_STORE_ENTRY_BLOB:
+        RUN_AND_CHECK_STORE(ret, nvs_set_blob, hk_store_handle, entry->key, entry->blob.ptr, entry->blob.size);
+        break;
+    case HK_STORE_ENTRY_ERASED:
+        ret = nvs_erase_key(hk_store_handle, entry->key);
+        if (ret == ESP_ERR_NVS_NOT_FOUND)
+        {
+            ret = ESP_OK;
+        }
+        break;
+    }
+
+    return ret;
+}
+
+static void hk_store_entry_clear(hk_store_entry_t *entry)
+{
+    free(entry->blob.ptr);
+    entry->blob.ptr = NULL;
+    entry->blob.size = 0;
+    entry->used = false;
+    entry->written = false;
+}
+
+static esp_err_t hk_store_flush_entries(hk_store_entry_t *entries, size_t entries_size)
+{
+    esp_err_t ret = ESP_OK;
+    bool is_written = false;
+
+    for (size_t i = 0; i < entries_size; i++)
+    {
+        hk_store_entry_t *entry = &entries[i];
+        if (entry->used)
+        {
+            esp_err_t entry_ret = hk_store_entry_write(entry);
+            if (entry_ret != ESP_OK)
+            {
+                // the entry stays dirty, so it is written again with the next flush
+                HK_LOGE("Error writing %s: %s", entry->key, esp_err_to_name(entry_ret));
+                ret = entry_ret;
+            }
+            else
+            {
+                entry->written = true;
+                is_written = true;
+            }
+        }
+    }
+
+    if (is_written)
+    {
+        esp_err_t commit_ret = ESP_OK;
+        RUN_AND_CHECK_STORE(commit_ret, nvs_commit, hk_store_handle);
+
+        // only committed entries are clean, the others are written again with the next flush
+        for (size_t i = 0; i < entries_size; i++)
+        {
+            entries[i].written = entries[i].written && commit_ret == ESP_OK;
+        }
+
+        if (commit_ret != ESP_OK)
+        {
+            ret = commit_ret;
+        }
+    }
+
+    return ret;
+}
+
+static void hk_store_flush_merge(hk_store_entry_t *entries, size_t entries_size)
+{
+    // entries, which could not be written, are dirty again, unless the key got a newer value meanwhile
+    for (size_t i = 0; i < entries_size; i++)
+    {
+        hk_store_entry_t *entry = &entries[i];
+        if (entry->used && !entry->written && hk_store_entry_find(hk_store_entries, hk_store_entries_size, entry->key) == NULL)
+        {
+            hk_store_entry_t *dirty_entry = hk_store_entry_find_unused();
+            if (dirty_entry != NULL)
+            {
+                *dirty_entry = *entry;
+                entry->blob.ptr = NULL;
+                continue;
+            }
+
+            HK_LOGE("Could not keep %s dirty, as the list is full.", entry->key);
+        }
+
+        hk_store_entry_clear(entry);
+    }
+}
+
+static esp_err_t hk_store_entry_set(const char *key, hk_store_entry_type_t type, uint16_t number, hk_mem *blob)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (strlen(key) >= sizeof(hk_store_entries[0].key))
+    {
+        HK_LOGE("Error executing: ESP_ERR_NVS_KEY_TOO_LONG (4361). The maximum allowed key length is 15.");
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    // the value is copied first, so a failed copy does not drop a dirty value of the key
+    hk_mem copy = {0};
+    if (blob != NULL && blob->size > 0)
+    {
+        copy.ptr = (char *)malloc(blob->size);
+        if (copy.ptr == NULL)
+        {
+            HK_LOGE("Could not allocate value of %s.", key);
+            return ESP_ERR_NO_MEM;
+        }
+
+        copy.size = blob->size;
+        memcpy(copy.ptr, blob->ptr, blob->size);
+    }
+
+    xSemaphoreTake(hk_store_mutex, portMAX_DELAY);
+
+    hk_store_entry_t *entry = hk_store_entry_find(hk_store_entries, hk_store_entries_size, key);
+    if (entry == NULL)
+    {
+        entry = hk_store_entry_find_unused();
+    }
+
+    if (entry == NULL && hk_store_entries_size >= HK_STORE_DIRTY_MAX_SIZE)
+    {
+        // the list is bounded, so keys getting dirty faster than they are written are flushed by the caller
+        HK_LOGW("Flushing, as %d keys are dirty.", hk_store_entries_size);
+        xSemaphoreGive(hk_store_mutex);
+        hk_store_flush();
+        xSemaphoreTake(hk_store_mutex, portMAX_DELAY);
+
+        entry = hk_store_entry_find(hk_store_entries, hk_store_entries_size, key);
+        if (entry == NULL)
+        {
+            entry = hk_store_entry_find_unused();
+        }
+    }
+
+    if (entry != NULL)
+    {
+        hk_store_entry_clear(entry);
+        strcpy(entry->key, key);
+        entry->type = type;
+        entry->number = number;
+        entry->blob = copy;
+        entry->used = true;
+    }
+    else
+    {
+        HK_LOGE("Could not allocate dirty entry of %s.", key);
+        free(copy.ptr);
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreGive(hk_store_mutex);
+
+    if (ret == ESP_OK)
+    {
+        xTaskNotifyGive(hk_store_task_handle);
+    }
+
+    return ret;
+}
+
+static bool hk_store_entry_get(const char *key, hk_store_entry_type_t type, uint16_t *number, hk_mem *blob, esp_err_t *ret)
+{
+    bool found = false;
+
+    xSemaphoreTake(hk_store_mutex, portMAX_DELAY);
+
+    // keys, which are being written, are not in flash yet
+    hk_store_entry_t *entry = hk_store_entry_find(hk_store_entries, hk_store_entries_size, key);
+    if (entry == NULL)
+    {
+        entry = hk_store_entry_find(hk_store_flushing_entries, hk_store_flushing_entries_size, key);
+    }
+
+    if (entry != NULL && entry->type == HK_STORE_ENTRY_ERASED)
+    {
+        *ret = ESP_ERR_NOT_FOUND;
+        found = true;
+    }
+    else if (entry != NULL && entry->type == type)
+    {
+        if (blob != NULL)
+        {
+            hk_mem_set_mem(blob, &entry->blob);
+        }
+        else
+        {
+            *number = entry->number;
+        }
+
+        *ret = ESP_OK;
+        found = true;
+    }
+
+    xSemaphoreGive(hk_store_mutex);
+
+    return found;
+}
+
+static void hk_store_task(void *arg)
+{
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // waiting until no more keys get dirty, but not longer than the deadline
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(HK_STORE_FLUSH_DEADLINE_MS);
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HK_STORE_FLUSH_IDLE_MS)) > 0 && xTaskGetTickCount() < deadline)
+        {
+        }
+
+        hk_store_flush();
+    }
+}
+
 // esp_err_t hk_store_bool_get(const char *key, bool *value)
 // {
 //     esp_err_t ret = ESP_OK;
@@ -41,35 +346,48 @@ const char *hk_store_name = "hk_store";
 esp_err_t hk_store_u8_get(const char *key, uint8_t *value)
 {
     esp_err_t ret = ESP_OK;
+    uint16_t number = 0;
+    if (hk_store_entry_get(key, HK_STORE_ENTRY_U8, &number, NULL, &ret))
+    {
+        *value = (uint8_t)number;
+        return ret;
+    }
+
     RUN_AND_CHECK_STORE(ret, nvs_get_u8, hk_store_handle, key, value);
     return ret;
 }
 
 esp_err_t hk_store_u8_set(const char *key, uint8_t value)
 {
-    esp_err_t ret = ESP_OK;
-    RUN_AND_CHECK_STORE(ret, nvs_set_u8, hk_store_handle, key, value);
-    return ret;
+    return hk_store_entry_set(key, HK_STORE_ENTRY_U8, value, NULL);
 }
 
 esp_err_t hk_store_u16_get(const char *key, uint16_t *value)
 {
     esp_err_t ret = ESP_OK;
+    if (hk_store_entry_get(key, HK_STORE_ENTRY_U16, value, NULL, &ret))
+    {
+        return ret;
+    }
+
     RUN_AND_CHECK_STORE(ret, nvs_get_u16, hk_store_handle, key, value);
     return ret;
 }
 
 esp_err_t hk_store_u16_set(const char *key, uint16_t value)
 {
-    esp_err_t ret = ESP_OK;
-    RUN_AND_CHECK_STORE(ret, nvs_set_u16, hk_store_handle, key, value);
-    return ret;
+    return hk_store_entry_set(key, HK_STORE_ENTRY_U16, value, NULL);
 }
 
 esp_err_t hk_store_blob_get(const char *key, hk_mem *value)
 {
     size_t required_size = 0;
     esp_err_t ret = ESP_OK;
+    if (hk_store_entry_get(key, HK_STORE_ENTRY_BLOB, NULL, value, &ret))
+    {
+        return ret;
+    }
+
     RUN_AND_CHECK_STORE(ret, nvs_get_blob, hk_store_handle, key, NULL, &required_size);
     hk_mem_set(value, required_size);
     RUN_AND_CHECK_STORE(ret, nvs_get_blob, hk_store_handle, key, value->ptr, &required_size);
@@ -79,16 +397,36 @@ esp_err_t hk_store_blob_get(const char *key, hk_mem *value)
 
 esp_err_t hk_store_blob_set(const char *key, hk_mem *value)
 {
-    return nvs_set_blob(hk_store_handle, key, value->ptr, value->size);
+    return hk_store_entry_set(key, HK_STORE_ENTRY_BLOB, 0, value);
 }
 
 esp_err_t hk_store_erase(const char *key)
 {
-    esp_err_t ret = nvs_erase_key(hk_store_handle, key);
-    if (ret == ESP_ERR_NVS_NOT_FOUND)
-    {
-        ret = ESP_OK;
-    }
+    return hk_store_entry_set(key, HK_STORE_ENTRY_ERASED, 0, NULL);
+}
+
+esp_err_t hk_store_flush()
+{
+    xSemaphoreTake(hk_store_flush_mutex, portMAX_DELAY);
+
+    // the dirty keys are taken out of the list, so the list is not locked while writing flash
+    xSemaphoreTake(hk_store_mutex, portMAX_DELAY);
+    hk_store_flushing_entries = hk_store_entries;
+    hk_store_flushing_entries_size = hk_store_entries_size;
+    hk_store_entries = NULL;
+    hk_store_entries_size = 0;
+    xSemaphoreGive(hk_store_mutex);
+
+    esp_err_t ret = hk_store_flush_entries(hk_store_flushing_entries, hk_store_flushing_entries_size);
+
+    xSemaphoreTake(hk_store_mutex, portMAX_DELAY);
+    hk_store_flush_merge(hk_store_flushing_entries, hk_store_flushing_entries_size);
+    free(hk_store_flushing_entries);
+    hk_store_flushing_entries = NULL;
+    hk_store_flushing_entries_size = 0;
+    xSemaphoreGive(hk_store_mutex);
+
+    xSemaphoreGive(hk_store_flush_mutex);
 
     return ret;
 }
@@ -96,6 +434,22 @@ esp_err_t hk_store_erase(const char *key)
 esp_err_t hk_store_init()
 {
     HK_LOGD("Initializing key value store.");
+
+    if (hk_store_mutex == NULL)
+    {
+        hk_store_mutex = xSemaphoreCreateMutex();
+        hk_store_flush_mutex = xSemaphoreCreateMutex();
+    }
+
+    if (hk_store_task_handle == NULL &&
+        xTaskCreatePinnedToCore(hk_store_task, "hk_store", HK_STORE_TASK_STACK_SIZE, NULL, HK_STORE_TASK_PRIORITY, &hk_store_task_handle, HK_UTIL_TASK_CORE_ID(HK_STORE_TASK_CORE_ID)) != pdPASS)
+    {
+        HK_LOGE("Could not create store task.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    hk_tasks_register(hk_store_task_handle, "hk_store", HK_STORE_TASK_STACK_SIZE);
+
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
     {
@@ -134,5 +488,6 @@ esp_err_t hk_store_init()
 
 void hk_store_free()
 {
+    hk_store_flush();
     nvs_close(hk_store_handle);
 }
\ No newline at end of file
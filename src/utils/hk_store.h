@@ -2,6 +2,14 @@
  * @file hk_store.h
  *
  * A fascade to easily access the non volantile store of esp32.
+ *
+ * Writes are deferred: the values are kept in a list of dirty keys, which is written to flash by a persistence task
+ * once no key got dirty for HK_STORE_FLUSH_IDLE_MS, or at latest after HK_STORE_FLUSH_DEADLINE_MS. The list grows by
+ * HK_STORE_DIRTY_SIZE entries when it is full, up to HK_STORE_DIRTY_MAX_SIZE entries. Only then the caller flushes
+ * itself. Writing flash stalls both cores, so request paths should not do it. While flushing, the dirty keys are
+ * taken out of the list, so readers and writers are not blocked by the flash. Values, which have to be durable
+ * immediately, are written by calling hk_store_flush. Keys, which could not be written, stay dirty and are written
+ * again with the next flush.
  */
 
 #pragma once
@@ -10,9 +18,18 @@
 #include <stdbool.h>
 #include <esp_err.h>
 #include <nvs_flash.h>
+#include <sdkconfig.h>
 
 #include "hk_mem.h"
 
+#define HK_STORE_DIRTY_SIZE 8
+#define HK_STORE_DIRTY_MAX_SIZE 64
+#define HK_STORE_FLUSH_IDLE_MS 500
+#define HK_STORE_FLUSH_DEADLINE_MS 3000
+#define HK_STORE_TASK_STACK_SIZE 3072
+#define HK_STORE_TASK_PRIORITY CONFIG_ESP32_HAP_STORE_TASK_PRIORITY
+#define HK_STORE_TASK_CORE_ID CONFIG_ESP32_HAP_STORE_TASK_CORE_ID
+
 /**
  * @brief Initalize the store.
  *
@@ -104,9 +121,19 @@ esp_err_t hk_store_blob_set(const char *key, hk_mem *value);
  */
 esp_err_t hk_store_erase(const char *key);
 
+/**
+ * @brief Writes all dirty keys.
+ *
+ * Writes all dirty keys to flash and commits them. Has to be called after writing values, which must
+ * survive a reset, like pairings.
+ * 
+ * @return Returns an esp_err_t result.
+ */
+esp_err_t hk_store_flush();
+
 /**
  * @brief Frees all ressources allocated by the store.
  *
- * Frees all ressources allocated by the store.
+ * Frees all ressources allocated by the store, after writing all dirty keys.
  */
 void hk_store_free();
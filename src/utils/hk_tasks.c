@@ -0,0 +1,120 @@
+#include "hk_tasks.h"
+
+#include <freertos/semphr.h>
+
+#include "hk_logging.h"
+
+typedef struct
+{
+    TaskHandle_t task;
+    const char *name;
+    size_t stack_size;
+} hk_tasks_entry_t;
+
+hk_tasks_entry_t hk_tasks_entries[HK_TASKS_MAX_COUNT] = {0};
+SemaphoreHandle_t hk_tasks_mutex = NULL;
+
+static void hk_tasks_lock()
+{
+    if (hk_tasks_mutex == NULL)
+    {
+        // the first registration happens during initialization, before tasks of the library run
+        hk_tasks_mutex = xSemaphoreCreateMutex();
+    }
+
+    xSemaphoreTake(hk_tasks_mutex, portMAX_DELAY);
+}
+
+esp_err_t hk_tasks_register(TaskHandle_t task, const char *name, size_t stack_size)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    if (task == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hk_tasks_lock();
+
+    // a registered task is updated, so unregistering earlier tasks does not lead to a second entry
+    hk_tasks_entry_t *entry = NULL;
+    for (size_t i = 0; i < HK_TASKS_MAX_COUNT; i++)
+    {
+        if (hk_tasks_entries[i].task == task)
+        {
+            entry = &hk_tasks_entries[i];
+            break;
+        }
+        else if (hk_tasks_entries[i].task == NULL && entry == NULL)
+        {
+            entry = &hk_tasks_entries[i];
+        }
+    }
+
+    if (entry != NULL)
+    {
+        entry->task = task;
+        entry->name = name;
+        entry->stack_size = stack_size;
+        ret = ESP_OK;
+    }
+
+    xSemaphoreGive(hk_tasks_mutex);
+
+    if (ret != ESP_OK)
+    {
+        HK_LOGW("Could not register task %s, as %d tasks are registered.", name, HK_TASKS_MAX_COUNT);
+    }
+
+    return ret;
+}
+
+void hk_tasks_unregister(TaskHandle_t task)
+{
+    hk_tasks_lock();
+
+    for (size_t i = 0; i < HK_TASKS_MAX_COUNT; i++)
+    {
+        if (hk_tasks_entries[i].task == task)
+        {
+            hk_tasks_entries[i].task = NULL;
+        }
+    }
+
+    xSemaphoreGive(hk_tasks_mutex);
+}
+
+size_t hk_tasks_get_stack_usage(hk_tasks_stack_usage_t *usages, size_t count)
+{
+    size_t written = 0;
+
+    hk_tasks_lock();
+
+    for (size_t i = 0; i < HK_TASKS_MAX_COUNT && written < count; i++)
+    {
+        if (hk_tasks_entries[i].task != NULL)
+        {
+            usages[written].name = hk_tasks_entries[i].name;
+            usages[written].stack_size = hk_tasks_entries[i].stack_size;
+            // on the esp32 the high water mark is given in bytes
+            usages[written].stack_high_water_mark = uxTaskGetStackHighWaterMark(hk_tasks_entries[i].task);
+            written++;
+        }
+    }
+
+    xSemaphoreGive(hk_tasks_mutex);
+
+    return written;
+}
+
+void hk_tasks_print_stack_usage()
+{
+    hk_tasks_stack_usage_t usages[HK_TASKS_MAX_COUNT];
+    size_t count = hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        HK_LOGI("Task %s: stack of %d bytes, at most %d bytes used, %d bytes never used.",
+                usages[i].name, usages[i].stack_size, usages[i].stack_size - usages[i].stack_high_water_mark, usages[i].stack_high_water_mark);
+    }
+}
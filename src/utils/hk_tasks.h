@@ -0,0 +1,63 @@
+/**
+ * @file hk_tasks.h
+ *
+ * Keeps track of the tasks of the library, to report how much of their stacks they use.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define HK_TASKS_MAX_COUNT 8
+
+typedef struct
+{
+    const char *name;
+    size_t stack_size;
+    size_t stack_high_water_mark; // the minimum of free stack in bytes since the task was started
+} hk_tasks_stack_usage_t;
+
+/**
+ * @brief Registers a task.
+ *
+ * Registers a task, which was created by the library or by a library it uses.
+ *
+ * @param task The handle of the task.
+ * @param name The name of the task. Has to be valid until the task is unregistered.
+ * @param stack_size The size of the stack of the task in bytes.
+ *
+ * @return Returns ESP_ERR_NO_MEM, if HK_TASKS_MAX_COUNT tasks are registered already.
+ */
+esp_err_t hk_tasks_register(TaskHandle_t task, const char *name, size_t stack_size);
+
+/**
+ * @brief Unregisters a task.
+ *
+ * Unregisters a task. Has to be called before the task is deleted.
+ *
+ * @param task The handle of the task.
+ */
+void hk_tasks_unregister(TaskHandle_t task);
+
+/**
+ * @brief Returns the stack usage of the registered tasks.
+ *
+ * Returns the stack size and the high water mark of every registered task. Use it to size the stacks tightly after
+ * the accessory ran through pairing and normal operation.
+ *
+ * @param usages The output for the stack usages.
+ * @param count The number of usages, which fit into the output.
+ *
+ * @return Returns the number of written usages.
+ */
+size_t hk_tasks_get_stack_usage(hk_tasks_stack_usage_t *usages, size_t count);
+
+/**
+ * @brief Prints the stack usage of the registered tasks.
+ *
+ * Logs the stack size, the high water mark and the peak usage of every registered task.
+ */
+void hk_tasks_print_stack_usage();
@@ -65,6 +65,26 @@ esp_err_t hk_tlv_get_mem_by_type(hk_tlv_t *tlv, char type, hk_mem *result)
     return ret;
 }
 
+esp_err_t hk_tlv_get_slice_by_type(hk_tlv_t *tlv, char type, hk_slice_t *result)
+{
+    hk_tlv_t *found = hk_tlv_get_tlv_by_type(tlv, type);
+
+    if (found == NULL)
+    {
+        HK_LOGE("Error getting tlv for type %d.", type);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (hk_tlv_get_tlv_by_type(hk_ll_next(found), type) != NULL)
+    {
+        HK_LOGE("Value of tlv type %d is split and cannot be viewed as one.", type);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *result = hk_slice_init(found->value, (uint8_t)found->length);
+    return ESP_OK;
+}
+
 hk_tlv_t *hk_tlv_get_tlv_by_type(hk_tlv_t *tlv, char type)
 {
     while (tlv)
@@ -11,6 +11,7 @@
 #include <esp_err.h>
 
 #include "../include/hk_mem.h"
+#include "hk_slice.h"
 
 /**
  * @brief A tlv.
@@ -101,6 +102,20 @@ hk_tlv_t *hk_tlv_add_uint16(hk_tlv_t *tlv_list, char type, uint16_t data);
  */
 esp_err_t hk_tlv_get_mem_by_type(hk_tlv_t *tlv, char type, hk_mem *result);
 
+/**
+ * @brief Returns a view of the value stored for the type.
+ *
+ * Looks in the list for a tlv with the given type and returns a slice of its value, which is valid until the list is
+ * freed. Values longer than 255 bytes are split into several tlvs, use hk_tlv_get_mem_by_type to join them.
+ *
+ * @param tlv_list A pointer to the tlv list.
+ * @param type The type of the tlv.
+ * @param result The slice of the value.
+ *
+ * @return Returns ESP_ERR_INVALID_ARG if the type is missing, ESP_ERR_INVALID_SIZE if the value is split.
+ */
+esp_err_t hk_tlv_get_slice_by_type(hk_tlv_t *tlv, char type, hk_slice_t *result);
+
 /**
  * @brief Returns a tlv of the list with the given type.
  *
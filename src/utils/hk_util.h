@@ -27,4 +27,8 @@ if(!ret) \
 
 #ifndef MIN
    #define MIN(x,y) ((x)<(y)?(x):(y))
-#endif
\ No newline at end of file
+#endif
+/**
+ * @brief Converts a configured core id to the core id of xTaskCreatePinnedToCore. -1 stands for no affinity.
+ */
+#define HK_UTIL_TASK_CORE_ID(core_id) ((core_id) < 0 ? tskNO_AFFINITY : (core_id))
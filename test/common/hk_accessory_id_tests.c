@@ -28,4 +28,31 @@ TEST_CASE("Get accessory id.", "[accessory_id]")
     hk_mem_free(accessory_id_2);
     hk_mem_free(accessory_id_3);
     hk_store_free();
-}
\ No newline at end of file
+}
+
+TEST_CASE("Get serialized accessory id.", "[accessory_id]")
+{
+    //prepare
+    hk_store_init();
+    hk_mem *accessory_id = hk_mem_init();
+    hk_slice_t serialized_1;
+    hk_slice_t serialized_2;
+    char expected[18];
+
+    //test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_reset());
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_get_serialized(&serialized_1));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_get_serialized(&serialized_2));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_get(accessory_id));
+
+    // assert
+    uint8_t *bytes = (uint8_t *)accessory_id->ptr;
+    snprintf(expected, sizeof(expected), "%02X:%02X:%02X:%02X:%02X:%02X", bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+    TEST_ASSERT_EQUAL_INT(17, serialized_1.size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, serialized_1.ptr, 17);
+    TEST_ASSERT_EQUAL_PTR(serialized_1.ptr, serialized_2.ptr);
+
+    //cleanup
+    hk_mem_free(accessory_id);
+    hk_store_free();
+}
@@ -0,0 +1,65 @@
+#include <unity.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "../../src/common/hk_boot.h"
+
+static volatile bool hk_boot_tests_first_started = false;
+static volatile bool hk_boot_tests_second_started = false;
+static volatile bool hk_boot_tests_first_saw_second = false;
+static volatile bool hk_boot_tests_second_saw_first = false;
+
+static bool hk_boot_tests_wait_for(volatile bool *flag)
+{
+    for (size_t i = 0; i < 100 && !*flag; i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    return *flag;
+}
+
+static void hk_boot_tests_first_job()
+{
+    hk_boot_tests_first_started = true;
+    hk_boot_tests_first_saw_second = hk_boot_tests_wait_for(&hk_boot_tests_second_started);
+}
+
+static void hk_boot_tests_second_job()
+{
+    hk_boot_tests_second_started = true;
+    hk_boot_tests_second_saw_first = hk_boot_tests_wait_for(&hk_boot_tests_first_started);
+}
+
+TEST_CASE("Time of a phase is kept from the first mark", "[boot]")
+{
+    // prepare
+    hk_boot_mark(HK_BOOT_PHASE_STORE);
+    int64_t time = hk_boot_get_time(HK_BOOT_PHASE_STORE);
+
+    // test
+    vTaskDelay(pdMS_TO_TICKS(10));
+    hk_boot_mark(HK_BOOT_PHASE_STORE);
+
+    // assert
+    TEST_ASSERT_TRUE(time > 0);
+    TEST_ASSERT_TRUE(time == hk_boot_get_time(HK_BOOT_PHASE_STORE));
+    TEST_ASSERT_TRUE(hk_boot_get_time(HK_BOOT_PHASE_COUNT) == -1);
+}
+
+TEST_CASE("Jobs of the initialization run concurrently", "[boot]")
+{
+    // prepare
+    hk_boot_tests_first_started = false;
+    hk_boot_tests_second_started = false;
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_boot_run(hk_boot_tests_first_job));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_boot_run(hk_boot_tests_second_job));
+    hk_boot_join();
+
+    // assert
+    TEST_ASSERT_TRUE(hk_boot_tests_first_saw_second);
+    TEST_ASSERT_TRUE(hk_boot_tests_second_saw_first);
+}
@@ -0,0 +1,97 @@
+#include "unity.h"
+
+#include <nvs_flash.h>
+
+#include "../../src/utils/hk_store.h"
+#include "../../src/utils/hk_slice.h"
+#include "../../src/common/hk_pairings_store.h"
+#include "../../src/common/hk_configuration.h"
+
+TEST_CASE("Configuration number is kept for same hash", "[configuration]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    uint32_t hash;
+    hk_configuration_hash_init(&hash);
+    hk_configuration_hash_append(&hash, "database", 8);
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(hash));
+    uint16_t number = hk_configuration_get();
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(hash));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(1, number);
+    TEST_ASSERT_EQUAL_INT(number, hk_configuration_get());
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Configuration number is increased for changed hash", "[configuration]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    uint32_t hash;
+    uint32_t changed_hash;
+    hk_configuration_hash_init(&hash);
+    hk_configuration_hash_append(&hash, "database", 8);
+    hk_configuration_hash_init(&changed_hash);
+    hk_configuration_hash_append(&changed_hash, "databasf", 8);
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(hash));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(changed_hash));
+
+    // assert
+    TEST_ASSERT_TRUE(hash != changed_hash);
+    TEST_ASSERT_EQUAL_INT(2, hk_configuration_get());
+    TEST_ASSERT_EQUAL_INT(2, hk_configuration_get_u8());
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Configuration number continues from the ble counter", "[configuration]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u8_set("hk_gap_conf", 7));
+    uint32_t hash;
+    hk_configuration_hash_init(&hash);
+    hk_configuration_hash_append(&hash, "database", 8);
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(hash));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(8, hk_configuration_get());
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Configuration number continues from the fixed ip number when paired", "[configuration]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    char ltpk[32] = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_init("controller", 10), hk_slice_init(ltpk, sizeof(ltpk)), true));
+    uint32_t hash;
+    hk_configuration_hash_init(&hash);
+    hk_configuration_hash_append(&hash, "database", 8);
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_configuration_update(hash));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(3, hk_configuration_get());
+
+    // cleanup
+    hk_pairings_store_remove_all();
+    hk_store_free();
+}
@@ -0,0 +1,72 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "../../src/common/hk_conn_key_store.h"
+
+TEST_CASE("Reset zeroizes the keys and marks them invalid", "[conn_key_store]")
+{
+    // prepare
+    hk_conn_key_store_t *keys = hk_conn_key_store_init();
+    char zeros[HK_CONN_KEY_STORE_KEY_SIZE] = {0};
+    memset(keys->response_key, 0x5a, HK_CONN_KEY_STORE_KEY_SIZE);
+    memset(keys->request_key, 0x5a, HK_CONN_KEY_STORE_KEY_SIZE);
+    memset(keys->accessory_shared_secret, 0x5a, HK_CONN_KEY_STORE_KEY_SIZE);
+    memset(keys->session_key, 0x5a, HK_CONN_KEY_STORE_KEY_SIZE);
+    keys->has_control_keys = true;
+    keys->has_shared_secret = true;
+    keys->has_session_keys = true;
+
+    // test
+    hk_conn_key_store_reset(keys);
+
+    // assert
+    TEST_ASSERT_EQUAL_MEMORY(zeros, keys->response_key, HK_CONN_KEY_STORE_KEY_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(zeros, keys->request_key, HK_CONN_KEY_STORE_KEY_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(zeros, keys->accessory_shared_secret, HK_CONN_KEY_STORE_KEY_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(zeros, keys->session_key, HK_CONN_KEY_STORE_KEY_SIZE);
+    TEST_ASSERT_FALSE(keys->has_control_keys);
+    TEST_ASSERT_FALSE(keys->has_shared_secret);
+    TEST_ASSERT_FALSE(keys->has_session_keys);
+
+    // cleanup
+    hk_conn_key_store_free(keys);
+}
+
+TEST_CASE("Keys are usable as hk_mem without allocation", "[conn_key_store]")
+{
+    // prepare
+    hk_conn_key_store_t *keys = hk_conn_key_store_init();
+
+    // test
+    hk_mem *key = HK_CONN_KEY_STORE_MEM(keys->request_key);
+    hk_mem_set(key, HK_CONN_KEY_STORE_KEY_SIZE);
+    key->ptr[0] = 0x42;
+
+    // assert
+    TEST_ASSERT_EQUAL_PTR(keys->request_key, key->ptr);
+    TEST_ASSERT_EQUAL_INT(0x42, keys->request_key[0]);
+
+    // cleanup
+    hk_conn_key_store_free(keys);
+}
+
+TEST_CASE("State of pair setup is only allocated while pair setup runs", "[conn_key_store]")
+{
+    // prepare
+    hk_conn_key_store_t *keys = hk_conn_key_store_init();
+    TEST_ASSERT_NULL(keys->pair_setup_public_key);
+    TEST_ASSERT_NULL(keys->pair_setup_srp_key);
+    keys->pair_setup_public_key = hk_mem_init();
+    hk_mem_append_string(keys->pair_setup_public_key, "public key");
+
+    // test
+    hk_conn_key_store_pair_setup_free(keys);
+
+    // assert
+    TEST_ASSERT_NULL(keys->pair_setup_public_key);
+    TEST_ASSERT_NULL(keys->pair_setup_srp_key);
+
+    // cleanup
+    hk_conn_key_store_free(keys);
+}
@@ -0,0 +1,164 @@
+#include <unity.h>
+#include <stdio.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "../../src/common/hk_core.h"
+#include "../../src/crypto/hk_curve25519.h"
+
+#define HK_CORE_TESTS_EVENTS 200
+#define HK_CORE_TESTS_EVENT_INTERVAL_US 5000
+
+static volatile int64_t hk_core_tests_posted_at = 0;
+static volatile size_t hk_core_tests_received = 0;
+static int64_t hk_core_tests_latency_sum = 0;
+static int64_t hk_core_tests_latency_max = 0;
+static volatile bool hk_core_tests_load_running = false;
+static volatile bool hk_core_tests_load_stopped = false;
+
+static void hk_core_tests_handler(hk_core_event_t *event)
+{
+    int64_t latency = esp_timer_get_time() - hk_core_tests_posted_at;
+
+    hk_core_tests_latency_sum += latency;
+    hk_core_tests_latency_max = latency > hk_core_tests_latency_max ? latency : hk_core_tests_latency_max;
+    hk_core_tests_received++;
+}
+
+static void hk_core_tests_post(void *arg)
+{
+    hk_core_tests_posted_at = esp_timer_get_time();
+    hk_core_post(HK_CORE_EVENT_NOTIFY, NULL, -1);
+}
+
+static void hk_core_tests_load(void *arg)
+{
+    // the same work as a pair verify does, over and over again
+    hk_curve25519_key_t *key1 = hk_curve25519_init();
+    hk_curve25519_key_t *key2 = hk_curve25519_init();
+    hk_mem *shared_secret = hk_mem_init();
+    hk_curve25519_update_from_random(key1);
+    hk_curve25519_update_from_random(key2);
+
+    while (hk_core_tests_load_running)
+    {
+        hk_curve25519_calculate_shared_secret(key1, key2, shared_secret);
+    }
+
+    hk_mem_free(shared_secret);
+    hk_curve25519_free(key1);
+    hk_curve25519_free(key2);
+    hk_core_tests_load_stopped = true;
+    vTaskDelete(NULL);
+}
+
+static void hk_core_tests_measure(BaseType_t load_core_id)
+{
+    esp_timer_handle_t timer;
+    esp_timer_create_args_t timer_args = {.callback = hk_core_tests_post, .name = "hk_core_tests"};
+
+    hk_core_tests_received = 0;
+    hk_core_tests_latency_sum = 0;
+    hk_core_tests_latency_max = 0;
+    hk_core_tests_load_running = load_core_id >= 0;
+    hk_core_tests_load_stopped = false;
+
+    if (hk_core_tests_load_running)
+    {
+        // the load competes with the core task on the same priority
+        xTaskCreatePinnedToCore(hk_core_tests_load, "hk_core_load", 8192, NULL, HK_CORE_TASK_PRIORITY, NULL, load_core_id);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_timer_create(&timer_args, &timer));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_timer_start_periodic(timer, HK_CORE_TESTS_EVENT_INTERVAL_US));
+
+    while (hk_core_tests_received < HK_CORE_TESTS_EVENTS)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+
+    if (hk_core_tests_load_running)
+    {
+        hk_core_tests_load_running = false;
+        while (!hk_core_tests_load_stopped)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    printf("Core task on core %d, crypto load on core %d: average latency %lld us, maximum latency %lld us\n",
+           HK_CORE_TASK_CORE_ID, load_core_id, hk_core_tests_latency_sum / hk_core_tests_received, hk_core_tests_latency_max);
+}
+
+// Pin the core task with ESP32_HAP_CORE_TASK_CORE_ID, to compare crypto load on the same and on the other core.
+TEST_CASE("latency of events with crypto load on each core", "[core][benchmark]")
+{
+    // prepare
+    TEST_ASSERT_EQUAL(ESP_OK, hk_core_init(hk_core_tests_handler));
+
+    // test
+    hk_core_tests_measure(-1);
+    for (BaseType_t core_id = 0; core_id < portNUM_PROCESSORS; core_id++)
+    {
+        hk_core_tests_measure(core_id);
+
+        // assert
+        TEST_ASSERT_TRUE(hk_core_tests_received >= HK_CORE_TESTS_EVENTS);
+    }
+}
+
+static volatile bool hk_core_tests_paused = false;
+static volatile bool hk_core_tests_posted = false;
+static volatile size_t hk_core_tests_unsubscribed = 0;
+
+static void hk_core_tests_pausing_handler(hk_core_event_t *event)
+{
+    while (hk_core_tests_paused)
+    {
+        vTaskDelay(1);
+    }
+
+    if (event->type == HK_CORE_EVENT_UNSUBSCRIBE_ALL)
+    {
+        hk_core_tests_unsubscribed++;
+    }
+}
+
+static void hk_core_tests_post_blocking(void *arg)
+{
+    hk_core_post_blocking(HK_CORE_EVENT_UNSUBSCRIBE_ALL, NULL, 1);
+    hk_core_tests_posted = true;
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("blocking post waits for space in the queue", "[core]")
+{
+    // prepare
+    hk_core_tests_paused = true;
+    hk_core_tests_posted = false;
+    hk_core_tests_unsubscribed = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_core_init(hk_core_tests_pausing_handler));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_core_post(HK_CORE_EVENT_NOTIFY, NULL, -1));
+    vTaskDelay(pdMS_TO_TICKS(10));
+    while (hk_core_post(HK_CORE_EVENT_NOTIFY, NULL, -1) == ESP_OK)
+    {
+    }
+
+    // test
+    xTaskCreate(hk_core_tests_post_blocking, "hk_core_post", 2048, NULL, HK_CORE_TASK_PRIORITY, NULL);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    bool posted_while_full = hk_core_tests_posted;
+    hk_core_tests_paused = false;
+    while (!hk_core_tests_posted || hk_core_tests_unsubscribed == 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    // assert
+    TEST_ASSERT_FALSE(posted_while_full);
+    TEST_ASSERT_EQUAL_INT(1, hk_core_tests_unsubscribed);
+}
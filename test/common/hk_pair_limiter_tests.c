@@ -0,0 +1,168 @@
+#include "unity.h"
+
+#include <nvs_flash.h>
+
+#include "../../src/utils/hk_store.h"
+#include "../../src/common/hk_pair_limiter.h"
+#include "../../src/common/hk_pair_tlvs.h"
+
+static void hk_pair_limiter_tests_prepare()
+{
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    TEST_ASSERT_FALSE(hk_pair_limiter_reset());
+}
+
+TEST_CASE("Pair setup of second connection is refused while first is running", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    int connection1, connection2;
+    uint8_t error = 0;
+    uint16_t retry_delay = 0;
+
+    // test
+    esp_err_t ret1 = hk_pair_limiter_setup_begin(&connection1, &error, &retry_delay);
+    esp_err_t ret2 = hk_pair_limiter_setup_begin(&connection2, &error, &retry_delay);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, ret1);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, ret2);
+    TEST_ASSERT_EQUAL_INT(HK_PAIR_TLV_ERROR_BUSY, error);
+    TEST_ASSERT_TRUE(hk_pair_limiter_setup_owns(&connection1));
+    TEST_ASSERT_FALSE(hk_pair_limiter_setup_owns(&connection2));
+
+    // cleanup
+    hk_pair_limiter_setup_release(&connection1);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pair_limiter_setup_begin(&connection2, &error, &retry_delay));
+    hk_pair_limiter_setup_release(&connection2);
+    hk_store_free();
+}
+
+TEST_CASE("Pair setup backs off after unsuccessful attempt", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    int connection;
+    uint8_t error = 0;
+    uint16_t retry_delay = 0;
+    uint8_t attempts = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pair_limiter_setup_begin(&connection, &error, &retry_delay));
+
+    // test
+    hk_pair_limiter_setup_end(&connection, false);
+    esp_err_t ret = hk_pair_limiter_setup_begin(&connection, &error, &retry_delay);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, ret);
+    TEST_ASSERT_EQUAL_INT(HK_PAIR_TLV_ERROR_BACKOFF, error);
+    TEST_ASSERT_EQUAL_INT(1, retry_delay);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u8_get("hk_setup_fails", &attempts));
+    TEST_ASSERT_EQUAL_INT(1, attempts);
+
+    // cleanup
+    TEST_ASSERT_FALSE(hk_pair_limiter_reset());
+    hk_store_free();
+}
+
+TEST_CASE("Pair setup is refused after maximum of unsuccessful attempts", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    int connection;
+    uint8_t error = 0;
+    uint16_t retry_delay = 0;
+    TEST_ASSERT_FALSE(hk_store_u8_set("hk_setup_fails", HK_PAIR_LIMITER_MAX_SETUP_ATTEMPTS));
+
+    // test
+    esp_err_t ret = hk_pair_limiter_setup_begin(&connection, &error, &retry_delay);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, ret);
+    TEST_ASSERT_EQUAL_INT(HK_PAIR_TLV_ERROR_MAXTRIES, error);
+
+    // cleanup
+    TEST_ASSERT_FALSE(hk_pair_limiter_reset());
+    hk_store_free();
+}
+
+TEST_CASE("Pair verify is refused if tokens are used up", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    while (hk_pair_limiter_verify_take(1))
+    {
+    }
+
+    // test
+    bool taken = hk_pair_limiter_verify_take(1);
+
+    // assert
+    TEST_ASSERT_FALSE(taken);
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Pair verify of other sources is not refused if one source used up its tokens", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    while (hk_pair_limiter_verify_take(1))
+    {
+    }
+
+    // test
+    bool taken_by_other = hk_pair_limiter_verify_take(2);
+    bool taken_again = hk_pair_limiter_verify_take(1);
+
+    // assert
+    TEST_ASSERT_TRUE(taken_by_other);
+    TEST_ASSERT_FALSE(taken_again);
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Pair verify is refused if many sources used up the global tokens", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    size_t taken_count = 0;
+
+    // test
+    for (uint32_t source = 1; source <= 4 * HK_PAIR_LIMITER_VERIFY_SOURCES; source++)
+    {
+        taken_count += hk_pair_limiter_verify_take(source) ? 1 : 0;
+    }
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(HK_PAIR_LIMITER_VERIFY_GLOBAL_TOKENS, taken_count);
+
+    // cleanup
+    hk_store_free();
+}
+
+TEST_CASE("Pair setup is only released by its owner", "[pair_limiter]")
+{
+    // prepare
+    hk_pair_limiter_tests_prepare();
+    int connection1, connection2;
+    uint8_t error = 0;
+    uint16_t retry_delay = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pair_limiter_setup_begin(&connection1, &error, &retry_delay));
+
+    // test
+    hk_pair_limiter_setup_release(&connection2);
+    bool owned_after_foreign_release = hk_pair_limiter_setup_owns(&connection1);
+    hk_pair_limiter_setup_release(&connection1);
+
+    // assert
+    TEST_ASSERT_TRUE(owned_after_foreign_release);
+    TEST_ASSERT_FALSE(hk_pair_limiter_setup_owns(&connection1));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pair_limiter_setup_begin(&connection2, &error, &retry_delay));
+
+    // cleanup
+    hk_pair_limiter_setup_release(&connection2);
+    hk_store_free();
+}
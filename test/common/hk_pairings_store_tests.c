@@ -19,8 +19,8 @@ TEST_CASE("Add first", "[pair] [store]")
     bool device_exists = false;
 
     // test
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id, device_ltpk, true));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(device_id, &device_exists));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id), hk_slice_from_mem(device_ltpk), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(hk_slice_from_mem(device_id), &device_exists));
     TEST_ASSERT_TRUE(device_exists);
 
     // cleanup
@@ -41,8 +41,8 @@ TEST_CASE("Get ltpk", "[pair] [store]")
     hk_mem *device_ltpk_result = hk_mem_init();
 
     // test
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id, device_ltpk, true));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_ltpk_get(device_id, device_ltpk_result));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id), hk_slice_from_mem(device_ltpk), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_ltpk_get(hk_slice_from_mem(device_id), device_ltpk_result));
     TEST_ASSERT_TRUE(hk_mem_equal(device_ltpk, device_ltpk_result));
 
     // cleanup
@@ -65,9 +65,9 @@ TEST_CASE("Remove pairing", "[pair] [store]")
     bool device_exists = false;
 
     // test
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id, device_ltpk, true));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_remove(device_id));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(device_id, &device_exists));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id), hk_slice_from_mem(device_ltpk), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_remove(hk_slice_from_mem(device_id)));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(hk_slice_from_mem(device_id), &device_exists));
     TEST_ASSERT_FALSE(device_exists);
 
     // cleanup
@@ -77,6 +77,28 @@ TEST_CASE("Remove pairing", "[pair] [store]")
     hk_store_free();
 }
 
+TEST_CASE("Remove pairing keeps other pairings", "[pair] [store]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(hk_store_init());
+    hk_pairings_store_remove_all();
+    bool device_exists = false;
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_str("my_device_id1"), hk_slice_from_str("my_device_ltpk1"), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_str("my_device_id"), hk_slice_from_str("my_device_ltpk"), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_remove(hk_slice_from_str("my_device_id")));
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(hk_slice_from_str("my_device_id"), &device_exists));
+    TEST_ASSERT_FALSE(device_exists);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_device_exists(hk_slice_from_str("my_device_id1"), &device_exists));
+    TEST_ASSERT_TRUE(device_exists);
+
+    // cleanup
+    hk_store_free();
+}
+
 TEST_CASE("hk_pairings_store_has_admin_pairing", "[pair] [store]")
 {
     // prepare
@@ -93,10 +115,10 @@ TEST_CASE("hk_pairings_store_has_admin_pairing", "[pair] [store]")
     bool has_admin = true;
 
     // test
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id1, device_ltpk1, false));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id1), hk_slice_from_mem(device_ltpk1), false));
     TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_has_admin_pairing(&has_admin));
     TEST_ASSERT_FALSE(has_admin);
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id2, device_ltpk2, true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id2), hk_slice_from_mem(device_ltpk2), true));
     TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_has_admin_pairing(&has_admin));
     TEST_ASSERT_TRUE(has_admin);
 
@@ -124,11 +146,11 @@ TEST_CASE("hk_pairings_store_is_admin", "[pair] [store]")
     bool is_admin = true;
 
     // test
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id1, device_ltpk1, false));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_is_admin(device_id1, &is_admin));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id1), hk_slice_from_mem(device_ltpk1), false));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_is_admin(hk_slice_from_mem(device_id1), &is_admin));
     TEST_ASSERT_FALSE(is_admin);
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(device_id2, device_ltpk2, true));
-    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_is_admin(device_id2, &is_admin));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_add(hk_slice_from_mem(device_id2), hk_slice_from_mem(device_ltpk2), true));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairings_store_is_admin(hk_slice_from_mem(device_id2), &is_admin));
     TEST_ASSERT_TRUE(is_admin);
 
     // cleanup
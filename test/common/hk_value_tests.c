@@ -0,0 +1,81 @@
+#include <string.h>
+#include <unity.h>
+
+#include "../../src/common/hk_value.h"
+#include "../../src/include/hk_mem.h"
+
+TEST_CASE("parse->format uint64", "[value]")
+{
+    hk_value_t value;
+    char formatted[HK_VALUE_MAX_FORMATTED_SIZE];
+    const char *literal = "18446744073709551615";
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_value_parse(HK_FORMAT_UINT64, literal, strlen(literal), &value));
+    TEST_ASSERT_EQUAL_INT(strlen(literal), hk_value_format(&value, formatted));
+    TEST_ASSERT_EQUAL_STRING(literal, formatted);
+}
+
+TEST_CASE("parse checks range", "[value]")
+{
+    hk_value_t value;
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_value_parse(HK_FORMAT_UINT8, "255", 3, &value));
+    TEST_ASSERT_EQUAL_UINT8(255, value.u8);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_value_parse(HK_FORMAT_UINT8, "256", 3, &value));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_value_parse(HK_FORMAT_UINT16, "-1", 2, &value));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_value_parse(HK_FORMAT_INT, "2147483648", 10, &value));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_value_parse(HK_FORMAT_INT, "-2147483648", 11, &value));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_value_parse(HK_FORMAT_UINT8, "true", 4, &value));
+    TEST_ASSERT_EQUAL_UINT8(1, value.u8);
+}
+
+TEST_CASE("format shortest float", "[value]")
+{
+    hk_value_t value = {.format = HK_FORMAT_FLOAT};
+    char formatted[HK_VALUE_MAX_FORMATTED_SIZE];
+
+    value.f = 21.5f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("21.5", formatted);
+
+    value.f = 0.1f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("0.1", formatted);
+
+    value.f = 100;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("100", formatted);
+
+    value.f = -0.0f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("-0", formatted);
+
+    value.f = -0.3f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("-0.3", formatted);
+
+    value.f = 16777215.5f; // rounds up to a whole number
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("16777216", formatted);
+
+    value.f = 1e-7f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("1e-7", formatted);
+
+    value.f = 3.4028235e38f;
+    hk_value_format(&value, formatted);
+    TEST_ASSERT_EQUAL_STRING("3.4028235e+38", formatted);
+}
+
+TEST_CASE("normalize to exact width", "[value]")
+{
+    hk_mem *mem = hk_mem_init();
+    int number = 42;
+    hk_mem_append_buffer(mem, (char *)&number, sizeof(int));
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_value_normalize(HK_FORMAT_UINT8, mem));
+    TEST_ASSERT_EQUAL_INT(1, mem->size);
+    TEST_ASSERT_EQUAL_UINT8(42, (uint8_t)mem->ptr[0]);
+
+    hk_mem_free(mem);
+}
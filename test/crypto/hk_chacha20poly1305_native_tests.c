@@ -0,0 +1,186 @@
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "../../src/crypto/hk_chacha20poly1305.h"
+#include "../../src/crypto/hk_chacha20poly1305_native.h"
+#include "../../src/include/hk_mem.h"
+
+#define HK_CHACHA20POLY1305_NATIVE_TESTS_FRAMES 1000
+#define HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE 1024
+
+// RFC 8439, 2.8.2
+static const uint8_t hk_chacha20poly1305_native_tests_nonce[] = {
+    0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+
+static const uint8_t hk_chacha20poly1305_native_tests_aad[] = {
+    0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+
+static const char hk_chacha20poly1305_native_tests_plain[] =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+static const uint8_t hk_chacha20poly1305_native_tests_encrypted[] = {
+    0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+    0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe, 0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+    0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+    0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+    0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c, 0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+    0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+    0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+    0x61, 0x16};
+
+static const uint8_t hk_chacha20poly1305_native_tests_auth_tag[] = {
+    0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91};
+
+static void hk_chacha20poly1305_native_tests_key(uint8_t *key)
+{
+    for (size_t i = 0; i < HK_CHACHA20POLY1305_NATIVE_KEY_SIZE; i++)
+    {
+        key[i] = 0x80 + i;
+    }
+}
+
+TEST_CASE("native encrypts the vector of rfc 8439", "[crypto] [chacha]")
+{
+    // prepare
+    uint8_t key[HK_CHACHA20POLY1305_NATIVE_KEY_SIZE];
+    hk_chacha20poly1305_native_tests_key(key);
+    size_t size = strlen(hk_chacha20poly1305_native_tests_plain);
+    uint8_t encrypted[sizeof(hk_chacha20poly1305_native_tests_encrypted)];
+    uint8_t auth_tag[HK_CHACHA20POLY1305_NATIVE_TAG_SIZE];
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_native_encrypt(
+                                  key, hk_chacha20poly1305_native_tests_nonce,
+                                  hk_chacha20poly1305_native_tests_aad, sizeof(hk_chacha20poly1305_native_tests_aad),
+                                  (const uint8_t *)hk_chacha20poly1305_native_tests_plain, encrypted, size, auth_tag));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(sizeof(hk_chacha20poly1305_native_tests_encrypted), size);
+    TEST_ASSERT_EQUAL_MEMORY(hk_chacha20poly1305_native_tests_encrypted, encrypted, size);
+    TEST_ASSERT_EQUAL_MEMORY(hk_chacha20poly1305_native_tests_auth_tag, auth_tag, sizeof(auth_tag));
+}
+
+TEST_CASE("native decrypts in place and rejects a changed auth tag", "[crypto] [chacha]")
+{
+    // prepare
+    uint8_t key[HK_CHACHA20POLY1305_NATIVE_KEY_SIZE];
+    hk_chacha20poly1305_native_tests_key(key);
+    size_t size = sizeof(hk_chacha20poly1305_native_tests_encrypted);
+    uint8_t buffer[sizeof(hk_chacha20poly1305_native_tests_encrypted)];
+    uint8_t auth_tag[HK_CHACHA20POLY1305_NATIVE_TAG_SIZE];
+    memcpy(buffer, hk_chacha20poly1305_native_tests_encrypted, size);
+    memcpy(auth_tag, hk_chacha20poly1305_native_tests_auth_tag, sizeof(auth_tag));
+
+    // run
+    esp_err_t ret = hk_chacha20poly1305_native_decrypt(
+        key, hk_chacha20poly1305_native_tests_nonce,
+        hk_chacha20poly1305_native_tests_aad, sizeof(hk_chacha20poly1305_native_tests_aad),
+        buffer, buffer, size, auth_tag);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, ret);
+    TEST_ASSERT_EQUAL_MEMORY(hk_chacha20poly1305_native_tests_plain, buffer, size);
+
+    // run
+    memcpy(buffer, hk_chacha20poly1305_native_tests_encrypted, size);
+    auth_tag[0] ^= 1;
+    ret = hk_chacha20poly1305_native_decrypt(
+        key, hk_chacha20poly1305_native_tests_nonce,
+        hk_chacha20poly1305_native_tests_aad, sizeof(hk_chacha20poly1305_native_tests_aad),
+        buffer, buffer, size, auth_tag);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_MAC, ret);
+    TEST_ASSERT_EQUAL_MEMORY(hk_chacha20poly1305_native_tests_encrypted, buffer, size);
+}
+
+TEST_CASE("native and configured implementation agree on frames of all sizes", "[crypto] [chacha]")
+{
+    // prepare
+    hk_mem *key = hk_mem_init();
+    hk_mem_set(key, HK_CHACHA20POLY1305_NATIVE_KEY_SIZE);
+    esp_fill_random(key->ptr, key->size);
+    char aad[2] = {0x00, 0x04}; // the length of a frame of the ip transport
+    char message[HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE + 1];
+    char unaligned[sizeof(message) + 1];
+    char expected[sizeof(message) + HK_CHACHA20POLY1305_NATIVE_TAG_SIZE];
+    char encrypted[sizeof(message) + 1];
+    uint8_t auth_tag[HK_CHACHA20POLY1305_NATIVE_TAG_SIZE];
+    esp_fill_random(message, sizeof(message));
+
+    for (size_t size = 0; size <= sizeof(message); size += size < 130 ? 1 : 61)
+    {
+        // odd sizes run on odd addresses, to cover unaligned buffers
+        size_t offset = size % 2;
+        memcpy(unaligned + offset, message, size);
+
+        // run
+        TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_encrypt_buffer(key, HK_CHACHA_VERIFY_MSG2, aad, sizeof(aad),
+                                                                     message, expected, size));
+        TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_native_encrypt(
+                                      (uint8_t *)key->ptr, (uint8_t *)HK_CHACHA_VERIFY_MSG2, (uint8_t *)aad, sizeof(aad),
+                                      (uint8_t *)unaligned + offset, (uint8_t *)encrypted + offset, size, auth_tag));
+
+        // assert
+        TEST_ASSERT_EQUAL_MEMORY(expected, encrypted + offset, size);
+        TEST_ASSERT_EQUAL_MEMORY(expected + size, auth_tag, sizeof(auth_tag));
+        TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_native_decrypt(
+                                      (uint8_t *)key->ptr, (uint8_t *)HK_CHACHA_VERIFY_MSG2, (uint8_t *)aad, sizeof(aad),
+                                      (uint8_t *)encrypted + offset, (uint8_t *)encrypted + offset, size, auth_tag));
+        TEST_ASSERT_EQUAL_MEMORY(message, encrypted + offset, size);
+    }
+
+    // clean
+    hk_mem_free(key);
+}
+
+static int64_t hk_chacha20poly1305_native_tests_measure(bool is_native, hk_mem *key, char *frame, char *encrypted)
+{
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < HK_CHACHA20POLY1305_NATIVE_TESTS_FRAMES; i++)
+    {
+        if (is_native)
+        {
+            hk_chacha20poly1305_native_encrypt((uint8_t *)key->ptr, (uint8_t *)HK_CHACHA_VERIFY_MSG2, NULL, 0,
+                                               (uint8_t *)frame, (uint8_t *)encrypted, HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE,
+                                               (uint8_t *)encrypted + HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE);
+        }
+        else
+        {
+            hk_chacha20poly1305_encrypt_buffer(key, HK_CHACHA_VERIFY_MSG2, NULL, 0, frame, encrypted, HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE);
+        }
+    }
+
+    return esp_timer_get_time() - start;
+}
+
+// Without ESP32_HAP_CHACHA20POLY1305_NATIVE the configured implementation is wolfSSL.
+TEST_CASE("throughput of native and configured implementation", "[crypto] [chacha] [benchmark]")
+{
+    // prepare
+    hk_mem *key = hk_mem_init();
+    hk_mem_set(key, HK_CHACHA20POLY1305_NATIVE_KEY_SIZE);
+    esp_fill_random(key->ptr, key->size);
+    hk_mem *frame = hk_mem_init();
+    hk_mem_set(frame, HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE);
+    hk_mem *encrypted = hk_mem_init();
+    hk_mem_set(encrypted, HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE + HK_CHACHA20POLY1305_NATIVE_TAG_SIZE);
+
+    // test
+    int64_t configured = hk_chacha20poly1305_native_tests_measure(false, key, frame->ptr, encrypted->ptr);
+    int64_t native = hk_chacha20poly1305_native_tests_measure(true, key, frame->ptr, encrypted->ptr);
+
+    // assert
+    size_t bytes = HK_CHACHA20POLY1305_NATIVE_TESTS_FRAMES * HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE;
+    printf("Frames of %d bytes: configured %lld kB/s, native %lld kB/s\n", HK_CHACHA20POLY1305_NATIVE_TESTS_FRAME_SIZE,
+           bytes * 1000LL / configured, bytes * 1000LL / native);
+    TEST_ASSERT_TRUE(native > 0 && configured > 0);
+
+    // clean
+    hk_mem_free(key);
+    hk_mem_free(frame);
+    hk_mem_free(encrypted);
+}
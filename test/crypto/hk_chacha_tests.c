@@ -1,8 +1,22 @@
 #include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <nvs_flash.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include "../../src/crypto/hk_chacha20poly1305.h"
 #include "../../src/include/hk_mem.h"
 #include "../../src/utils/hk_logging.h"
+#include "../../src/utils/hk_store.h"
+
+#define HK_CHACHA_TESTS_FRAMES 500
+#define HK_CHACHA_TESTS_FRAME_SIZE 1024 // the maximum frame of the ip transport
+
+static volatile bool hk_chacha_tests_writes_running = false;
+static volatile bool hk_chacha_tests_writes_stopped = false;
 
 const char key_bytes[] = {
     0xf7, 0x7f, 0xf3, 0xd0, 0x2a, 0x58, 0x9a, 0x27,
@@ -72,4 +86,93 @@ TEST_CASE("calculate auth tag", "[crypto] [chacha]")
     // clean
     hk_mem_free(key);
     hk_mem_free(auth_tag);
-}
\ No newline at end of file
+}
+
+static void hk_chacha_tests_writes(void *arg)
+{
+    // the same writes as storing pairings and configuration numbers does, over and over again
+    hk_mem *value = hk_mem_init();
+    hk_mem_set(value, 512);
+    memset(value->ptr, 0xa5, value->size);
+
+    for (uint8_t i = 0; hk_chacha_tests_writes_running; i++)
+    {
+        value->ptr[0] = i;
+        hk_store_blob_set("chacha_bench", value);
+        hk_store_flush();
+    }
+
+    hk_mem_free(value);
+    hk_chacha_tests_writes_stopped = true;
+    vTaskDelete(NULL);
+}
+
+static void hk_chacha_tests_measure(bool with_writes)
+{
+    hk_mem *key = hk_mem_init();
+    hk_mem_append_buffer(key, (void *)key_bytes, 32);
+    hk_mem *frame = hk_mem_init();
+    hk_mem_set(frame, HK_CHACHA_TESTS_FRAME_SIZE);
+    memset(frame->ptr, 0x5a, frame->size);
+    hk_mem *encrypted = hk_mem_init();
+    hk_mem *decrypted = hk_mem_init();
+    int64_t sum = 0;
+    int64_t min = INT64_MAX;
+    int64_t max = 0;
+
+    hk_chacha_tests_writes_running = with_writes;
+    hk_chacha_tests_writes_stopped = false;
+    if (with_writes)
+    {
+        xTaskCreate(hk_chacha_tests_writes, "hk_chacha_writes", 4096, NULL, uxTaskPriorityGet(NULL), NULL);
+    }
+
+    for (size_t i = 0; i < HK_CHACHA_TESTS_FRAMES; i++)
+    {
+        int64_t start = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_encrypt(key, HK_CHACHA_VERIFY_MSG2, frame, encrypted));
+        TEST_ASSERT_EQUAL(ESP_OK, hk_chacha20poly1305_decrypt(key, HK_CHACHA_VERIFY_MSG2, encrypted, decrypted));
+        int64_t duration = esp_timer_get_time() - start;
+
+        sum += duration;
+        min = duration < min ? duration : min;
+        max = duration > max ? duration : max;
+
+        // lets the writes run between the frames, like the gaps between requests do
+        vTaskDelay(1);
+    }
+
+    if (with_writes)
+    {
+        hk_chacha_tests_writes_running = false;
+        while (!hk_chacha_tests_writes_stopped)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    printf("Frames of %d bytes %s flash writes: average %lld us, minimum %lld us, maximum %lld us, jitter %lld us\n",
+           HK_CHACHA_TESTS_FRAME_SIZE, with_writes ? "with" : "without", sum / HK_CHACHA_TESTS_FRAMES, min, max, max - min);
+
+    hk_mem_free(key);
+    hk_mem_free(frame);
+    hk_mem_free(encrypted);
+    hk_mem_free(decrypted);
+}
+
+// Run with and without ESP32_HAP_IRAM_HOT_PATHS, to compare the jitter and the free IRAM.
+TEST_CASE("jitter of frames with concurrent flash writes", "[crypto] [chacha] [benchmark]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    printf("Free IRAM: %d bytes\n", heap_caps_get_free_size(MALLOC_CAP_EXEC | MALLOC_CAP_32BIT));
+
+    // test
+    hk_chacha_tests_measure(false);
+    hk_chacha_tests_measure(true);
+
+    // clean
+    hk_store_erase("chacha_bench");
+    hk_store_free();
+}
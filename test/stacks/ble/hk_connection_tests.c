@@ -0,0 +1,30 @@
+#include "unity.h"
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/utils/hk_ll.h"
+#include "../../../src/stacks/ble/hk_connection.h"
+
+TEST_CASE("Subscriptions of a connection are set and removed", "[ble] [connection]")
+{
+    // prepare
+    hk_mem *address = hk_mem_init();
+    hk_mem_append_string(address, "00:11:22:33:44:55");
+    hk_mem_append_string_terminator(address);
+    hk_connection_t *connection = hk_connection_init(7, address);
+
+    // test
+    hk_connection_subscription_set(7, 20, true);
+    hk_connection_subscription_set(7, 20, true);
+    hk_connection_subscription_set(7, 30, true);
+    hk_connection_subscription_set(7, 20, false);
+    hk_connection_subscription_set(8, 30, false);
+
+    // assert
+    TEST_ASSERT_FALSE(hk_connection_is_subscribed(connection, 20));
+    TEST_ASSERT_TRUE(hk_connection_is_subscribed(connection, 30));
+    TEST_ASSERT_EQUAL_INT(1, hk_ll_count(connection->subscriptions));
+
+    // clean
+    hk_connection_free(7);
+    hk_mem_free(address);
+}
@@ -0,0 +1,93 @@
+#include "unity.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <nimble/nimble_port.h>
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/include/hk_chrs.h"
+#include "../../../src/utils/hk_store.h"
+#include "../../../src/stacks/ble/hk_connection.h"
+#include "../../../src/stacks/ble/hk_pairing_ble.h"
+#include "../../../src/stacks/ble/hk_uuids.h"
+
+#define HK_PAIRING_BLE_TESTS_HANDLE 9
+
+static bool hk_pairing_ble_tests_nimble_initialized = false;
+
+static hk_connection_t *hk_pairing_ble_tests_prepare(hk_mem *address)
+{
+    // the host task is not started, so the tests run the completions of the default event queue themselves
+    if (!hk_pairing_ble_tests_nimble_initialized)
+    {
+        nimble_port_init();
+        hk_pairing_ble_tests_nimble_initialized = true;
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_init());
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pairing_ble_init());
+
+    hk_mem_append_string(address, "00:11:22:33:44:55");
+    hk_mem_append_string_terminator(address);
+    hk_connection_t *connection = hk_connection_init(HK_PAIRING_BLE_TESTS_HANDLE, address);
+    hk_connection_transaction_init(connection, 1, 2, hk_uuids_get(HK_CHR_PAIR_VERIFY));
+
+    return connection;
+}
+
+static void hk_pairing_ble_tests_run_completion()
+{
+    struct ble_npl_event *event = ble_npl_eventq_get(nimble_port_get_dflt_eventq(), pdMS_TO_TICKS(5000));
+    TEST_ASSERT_NOT_NULL(event);
+    ble_npl_event_run(event);
+}
+
+TEST_CASE("Pairing step runs on the worker and completes on the host task", "[ble] [pairing]")
+{
+    // prepare
+    hk_mem *address = hk_mem_init();
+    hk_mem *request = hk_mem_init();
+    hk_connection_t *connection = hk_pairing_ble_tests_prepare(address);
+    hk_transaction_t *transaction = connection->transactions;
+
+    // test
+    esp_err_t ret = hk_pairing_ble_write_pair_verify(connection, request, NULL);
+    bool pending_while_running = connection->pairing_pending && transaction->response_pending;
+    hk_pairing_ble_tests_run_completion();
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, ret);
+    TEST_ASSERT_TRUE(pending_while_running);
+    TEST_ASSERT_FALSE(connection->pairing_pending);
+    TEST_ASSERT_FALSE(transaction->response_pending);
+    TEST_ASSERT_FALSE(connection->is_secure);
+
+    // clean
+    hk_connection_free(HK_PAIRING_BLE_TESTS_HANDLE);
+    hk_mem_free(request);
+    hk_mem_free(address);
+    hk_store_free();
+}
+
+TEST_CASE("Pairing step of a closed connection is discarded", "[ble] [pairing]")
+{
+    // prepare
+    hk_mem *address = hk_mem_init();
+    hk_mem *request = hk_mem_init();
+    hk_connection_t *connection = hk_pairing_ble_tests_prepare(address);
+
+    // test
+    esp_err_t ret = hk_pairing_ble_write_pair_verify(connection, request, NULL);
+    hk_connection_free(HK_PAIRING_BLE_TESTS_HANDLE);
+    hk_pairing_ble_tests_run_completion();
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, ret);
+    TEST_ASSERT_NULL(hk_connection_get_by_handle(HK_PAIRING_BLE_TESTS_HANDLE));
+    TEST_ASSERT_FALSE(hk_pairing_ble_orphan(HK_PAIRING_BLE_TESTS_HANDLE));
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(address);
+    hk_store_free();
+}
@@ -1,3 +1,29 @@
+#include "unity.h"
+
+#include <cJSON.h>
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/stacks/ip/hk_accessories_serializer.h"
+
+TEST_CASE("Format data values as base64 strings", "[accessories]")
+{
+    // prepare
+    hk_mem *value = hk_mem_init();
+    hk_mem_append_buffer(value, "\x01\x03" "abc", 5);
+
+    // run
+    cJSON *j_value = hk_accessories_serializer_format_mem(HK_FORMAT_DATA, value);
+
+    // assert
+    TEST_ASSERT_TRUE(cJSON_IsString(j_value));
+    TEST_ASSERT_FALSE(j_value->type & cJSON_IsReference);
+    TEST_ASSERT_EQUAL_STRING("AQNhYmM=", j_value->valuestring);
+
+    // clean
+    cJSON_Delete(j_value);
+    hk_mem_free(value);
+}
+
 // #include "unity.h"
 
 // #include "../../utils/hk_logging.h"
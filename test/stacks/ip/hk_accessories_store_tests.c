@@ -35,3 +35,48 @@
     
 //     hk_accessories_free();
 // }
+
+#include "unity.h"
+
+#include "../../../src/stacks/ip/hk_accessories_store.h"
+
+static esp_err_t hk_accessories_store_tests_read(hk_mem *response)
+{
+    return ESP_OK;
+}
+
+TEST_CASE("Reconfigure numbers characteristics added to an existing service", "[accessories]")
+{
+    // prepare
+    void *chr1, *chr2, *chr3, *chr4, *chr5;
+    uint8_t reader;
+    hk_accessories_free();
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_LIGHTBULB, true, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, hk_accessories_store_tests_read, NULL, true, &chr1);
+    hk_accessories_store_add_chr(HK_CHR_BRIGHTNESS, hk_accessories_store_tests_read, NULL, true, &chr2);
+    hk_accessories_store_end_config();
+
+    // test
+    hk_accessories_store_begin_config();
+    hk_accessories_store_add_chr(HK_CHR_HUE, hk_accessories_store_tests_read, NULL, true, &chr3);
+    hk_accessories_store_add_chr(HK_CHR_SATURATION, hk_accessories_store_tests_read, NULL, true, &chr4);
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, false, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, hk_accessories_store_tests_read, NULL, true, &chr5);
+    hk_accessories_store_end_config();
+
+    // assert
+    hk_accessory_t *accessories = hk_accessories_store_read_lock(&reader);
+    TEST_ASSERT_EQUAL_PTR(chr1, hk_accessories_store_get_chr(accessories, 1, 2));
+    TEST_ASSERT_EQUAL_PTR(chr2, hk_accessories_store_get_chr(accessories, 1, 3));
+    TEST_ASSERT_EQUAL_PTR(chr3, hk_accessories_store_get_chr(accessories, 1, 4));
+    TEST_ASSERT_EQUAL_PTR(chr4, hk_accessories_store_get_chr(accessories, 1, 5));
+    TEST_ASSERT_EQUAL_PTR(chr5, hk_accessories_store_get_chr(accessories, 1, 7));
+    TEST_ASSERT_EQUAL_INT(1, ((hk_chr_t *)chr3)->aid);
+    TEST_ASSERT_EQUAL_INT(1, ((hk_chr_t *)chr4)->aid);
+    TEST_ASSERT_EQUAL_INT(1, ((hk_chr_t *)chr5)->aid);
+    hk_accessories_store_read_unlock(reader);
+
+    // clean
+    hk_accessories_free();
+}
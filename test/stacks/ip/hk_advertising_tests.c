@@ -0,0 +1,55 @@
+#include "unity.h"
+
+#include <esp_event.h>
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/utils/hk_store.h"
+#include "../../../src/utils/hk_slice.h"
+#include "../../../src/common/hk_accessory_id.h"
+#include "../../../src/stacks/ip/hk_advertising.h"
+
+static void hk_advertising_tests_assert_id(hk_mem *id)
+{
+    hk_slice_t accessory_id = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, hk_advertising_get_txt("id", id));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_get_serialized(&accessory_id));
+    TEST_ASSERT_EQUAL_INT(accessory_id.size, id->size);
+    TEST_ASSERT_EQUAL_MEMORY(accessory_id.ptr, id->ptr, id->size);
+}
+
+TEST_CASE("Advertising refreshes the id on reset and on reconnect", "[advertising]")
+{
+    // prepare
+    esp_err_t ret = esp_event_loop_create_default(); // mdns registers for the wifi events
+    TEST_ASSERT_TRUE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_init());
+    hk_mem *id_started = hk_mem_init();
+    hk_mem *id_reset = hk_mem_init();
+    hk_mem *id_reconnected = hk_mem_init();
+    hk_mem *configuration = hk_mem_init();
+
+    // test
+    hk_advertising_init("Test", 5, 1);
+    hk_advertising_tests_assert_id(id_started);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_reset());
+    TEST_ASSERT_EQUAL(ESP_OK, hk_advertising_reset());
+    hk_advertising_tests_assert_id(id_reset);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_accessory_id_reset());
+    hk_advertising_init("Test", 5, 2);
+    hk_advertising_tests_assert_id(id_reconnected);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_advertising_get_txt("c#", configuration));
+
+    // assert
+    TEST_ASSERT_FALSE(hk_mem_equal(id_started, id_reset));
+    TEST_ASSERT_FALSE(hk_mem_equal(id_reset, id_reconnected));
+    TEST_ASSERT_TRUE(hk_mem_equal_str(configuration, "2"));
+
+    // clean
+    hk_mem_free(id_started);
+    hk_mem_free(id_reset);
+    hk_mem_free(id_reconnected);
+    hk_mem_free(configuration);
+    hk_store_free();
+}
@@ -39,3 +39,207 @@
 //     TEST_ASSERT_EQUAL_INT(3, results[1]);
 //     TEST_ASSERT_NULL(ids); 
 // }
+
+#include "unity.h"
+
+#include <string.h>
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/stacks/ip/hk_accessories_store.h"
+#include "../../../src/stacks/ip/hk_chrs.h"
+
+static esp_err_t hk_chrs_tests_write_with_response(hk_mem *request, hk_mem *response)
+{
+    bool value = !*(bool *)request->ptr;
+    hk_mem_append_buffer(response, (char *)&value, sizeof(bool));
+    return ESP_OK;
+}
+
+static size_t hk_chrs_tests_write_count = 0;
+
+static esp_err_t hk_chrs_tests_write(hk_mem *request)
+{
+    hk_chrs_tests_write_count++;
+    return ESP_OK;
+}
+
+static esp_err_t hk_chrs_tests_write_reconfiguring(hk_mem *request)
+{
+    // publishing waits for all readers of the accessories, so it deadlocks if the put still reads them
+    hk_accessories_store_begin_config();
+    hk_accessories_store_end_config();
+    hk_chrs_tests_write_count++;
+    return ESP_OK;
+}
+
+TEST_CASE("put with write response", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr_with_response(HK_CHR_ON, NULL, hk_chrs_tests_write_with_response, false, &chr_ptr);
+    hk_accessories_store_end_config();
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true,\"r\":true}]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chrs_put(request, NULL, 123, response));
+
+    // assert
+    TEST_ASSERT_TRUE(hk_mem_equal_str(response, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"status\":0,\"value\":false}]}"));
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
+
+TEST_CASE("put without write response", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr_with_response(HK_CHR_ON, NULL, hk_chrs_tests_write_with_response, false, &chr_ptr);
+    hk_accessories_store_end_config();
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true}]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chrs_put(request, NULL, 123, response));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(0, response->size);
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
+
+TEST_CASE("put with write response lists plain writes", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr_with_response(HK_CHR_ON, NULL, hk_chrs_tests_write_with_response, false, &chr_ptr);
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, false, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, NULL, hk_chrs_tests_write, false, &chr_ptr);
+    hk_accessories_store_end_config();
+    hk_chrs_tests_write_count = 0;
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true,\"r\":true},{\"aid\":1,\"iid\":4,\"value\":true}]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chrs_put(request, NULL, 123, response));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(1, hk_chrs_tests_write_count);
+    TEST_ASSERT_TRUE(hk_mem_equal_str(response, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"status\":0,\"value\":false},{\"aid\":1,\"iid\":4,\"status\":0}]}"));
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
+
+TEST_CASE("put writes nothing if an element is invalid", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, NULL, hk_chrs_tests_write, false, &chr_ptr);
+    hk_accessories_store_end_config();
+    hk_chrs_tests_write_count = 0;
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true},{\"aid\":1,\"value\":true}]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    esp_err_t ret = hk_chrs_put(request, NULL, 123, response);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ret);
+    TEST_ASSERT_EQUAL_INT(0, hk_chrs_tests_write_count);
+    TEST_ASSERT_EQUAL_INT(0, response->size);
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
+
+TEST_CASE("put of more chrs than supported writes nothing", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, NULL, hk_chrs_tests_write, false, &chr_ptr);
+    hk_accessories_store_end_config();
+    hk_chrs_tests_write_count = 0;
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[");
+    for (size_t i = 0; i < 17; i++)
+    {
+        hk_mem_append_string(request, i == 0 ? "{\"aid\":1,\"iid\":2,\"value\":true}" : ",{\"aid\":1,\"iid\":2,\"value\":true}");
+    }
+    hk_mem_append_string(request, "]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chrs_put(request, NULL, 123, response));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(0, hk_chrs_tests_write_count);
+    hk_mem_append_string_terminator(response);
+    size_t rejected_count = 0;
+    for (char *result = strstr(response->ptr, "-70407"); result != NULL; result = strstr(result + 1, "-70407"))
+    {
+        rejected_count++;
+    }
+    TEST_ASSERT_EQUAL_INT(17, rejected_count);
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
+
+TEST_CASE("put calls write callbacks after unlocking the accessories", "[chrs]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, NULL, hk_chrs_tests_write_reconfiguring, false, &chr_ptr);
+    hk_accessories_store_end_config();
+    hk_chrs_tests_write_count = 0;
+
+    hk_mem *request = hk_mem_init();
+    hk_mem_append_string(request, "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true},{\"aid\":1,\"iid\":2,\"value\":false}]}");
+    hk_mem *response = hk_mem_init();
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_chrs_put(request, NULL, 123, response));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(2, hk_chrs_tests_write_count);
+    TEST_ASSERT_EQUAL_INT(0, response->size);
+
+    // clean
+    hk_mem_free(request);
+    hk_mem_free(response);
+    hk_accessories_free();
+}
@@ -0,0 +1,146 @@
+#include "unity.h"
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/stacks/ip/hk_hap_request.h"
+
+#define HK_HAP_REQUEST_TESTS_PUT "PUT /characteristics HTTP/1.1\r\nHost: test\r\nContent-Length: 10\r\n\r\n"
+
+TEST_CASE("Parse request split across reads", "[hap_request]")
+{
+    // prepare
+    hk_mem *received = hk_mem_init();
+    hk_hap_request_t request;
+    hk_mem_append_string(received, "PUT /characteristics HTTP/1.1\r\nContent-");
+
+    // run
+    esp_err_t ret1 = hk_hap_request_parse(received, &request);
+    size_t size1 = request.size;
+    hk_mem_append_string(received, "Length: 8\r\n\r\n{\"a");
+    esp_err_t ret2 = hk_hap_request_parse(received, &request);
+    size_t size2 = request.size;
+    hk_mem_append_string(received, "\":12}");
+    esp_err_t ret3 = hk_hap_request_parse(received, &request);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, ret1);
+    TEST_ASSERT_EQUAL_INT(0, size1);
+    TEST_ASSERT_EQUAL(ESP_OK, ret2);
+    TEST_ASSERT_EQUAL_INT(0, size2);
+    TEST_ASSERT_EQUAL(ESP_OK, ret3);
+    TEST_ASSERT_EQUAL_INT(received->size, request.size);
+    TEST_ASSERT_EQUAL_STRING("PUT", request.method);
+    TEST_ASSERT_EQUAL_STRING("/characteristics", request.uri);
+    TEST_ASSERT_EQUAL_INT(8, request.content.size);
+    TEST_ASSERT_EQUAL_MEMORY("{\"a\":12}", request.content.ptr, 8);
+
+    // clean
+    hk_mem_free(received);
+}
+
+TEST_CASE("Parse pipelined requests", "[hap_request]")
+{
+    // prepare
+    hk_mem *received = hk_mem_init();
+    hk_hap_request_t request;
+    hk_mem_append_string(received, HK_HAP_REQUEST_TESTS_PUT "0123456789");
+    hk_mem_append_string(received, "GET /accessories HTTP/1.1\r\n\r\n");
+    hk_mem_append_string(received, "POST /pair-verify HTTP/1.1\r\nContent-Length: 5\r\n\r\nab");
+
+    // run and assert
+    TEST_ASSERT_EQUAL(ESP_OK, hk_hap_request_parse(received, &request));
+    TEST_ASSERT_EQUAL_STRING("PUT", request.method);
+    TEST_ASSERT_EQUAL_MEMORY("0123456789", request.content.ptr, 10);
+    hk_hap_request_consume(received, &request);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_hap_request_parse(received, &request));
+    TEST_ASSERT_EQUAL_STRING("GET", request.method);
+    TEST_ASSERT_EQUAL_STRING("/accessories", request.uri);
+    TEST_ASSERT_EQUAL_INT(0, request.content.size);
+    hk_hap_request_consume(received, &request);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_hap_request_parse(received, &request));
+    TEST_ASSERT_EQUAL_INT(0, request.size);
+    TEST_ASSERT_TRUE(received->size > 0);
+
+    // clean
+    hk_mem_free(received);
+}
+
+TEST_CASE("Reject oversized content length", "[hap_request]")
+{
+    const char *requests[] = {
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 4294967295\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 18446744073709551615\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 8192\r\n\r\n",
+    };
+
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++)
+    {
+        // prepare
+        hk_mem *received = hk_mem_init();
+        hk_hap_request_t request;
+        hk_mem_append_string(received, requests[i]);
+
+        // run
+        esp_err_t ret = hk_hap_request_parse(received, &request);
+
+        // assert
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ret);
+        TEST_ASSERT_EQUAL_INT(0, request.size);
+
+        // clean
+        hk_mem_free(received);
+    }
+}
+
+TEST_CASE("Reject malformed content length", "[hap_request]")
+{
+    const char *requests[] = {
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 12a\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length:\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 1 2\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n",
+        "POST /pair-setup HTTP/1.1\r\nContent-Length: 2\r\ncontent-length: 3\r\n\r\nabc",
+        "POST /pair-setup\r\n\r\n",
+    };
+
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++)
+    {
+        // prepare
+        hk_mem *received = hk_mem_init();
+        hk_hap_request_t request;
+        hk_mem_append_string(received, requests[i]);
+
+        // run
+        esp_err_t ret = hk_hap_request_parse(received, &request);
+
+        // assert
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ret);
+        TEST_ASSERT_EQUAL_INT(0, request.size);
+
+        // clean
+        hk_mem_free(received);
+    }
+}
+
+TEST_CASE("Reject headers without end", "[hap_request]")
+{
+    // prepare
+    hk_mem *received = hk_mem_init();
+    hk_hap_request_t request;
+    hk_mem_append_string(received, "GET /accessories HTTP/1.1\r\n");
+    while (received->size <= HK_HAP_REQUEST_MAX_SIZE)
+    {
+        hk_mem_append_string(received, "X-Filler: 0123456789\r\n");
+    }
+
+    // run
+    esp_err_t ret = hk_hap_request_parse(received, &request);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ret);
+
+    // clean
+    hk_mem_free(received);
+}
@@ -0,0 +1,96 @@
+#include "unity.h"
+
+#include <string.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <lwip/sockets.h>
+
+#include "../../../src/include/hk_mem.h"
+#include "../../../src/utils/hk_store.h"
+#include "../../../src/stacks/ip/hk_accessories_store.h"
+#include "../../../src/stacks/ip/hk_server.h"
+#include "../../../src/stacks/ip/hk_server_transport.h"
+
+#define HK_SERVER_TESTS_PUT_CONTENT "{\"characteristics\":[{\"aid\":1,\"iid\":2,\"value\":true}]}"
+
+static bool hk_server_tests_started = false;
+static volatile bool hk_server_tests_written = false;
+
+static esp_err_t hk_server_tests_write(hk_mem *request)
+{
+    // called by the server task, so the test asserts it afterwards
+    hk_server_tests_written = true;
+    return ESP_OK;
+}
+
+static void hk_server_tests_start()
+{
+    // the server cannot be stopped, so it is started once for all tests
+    if (!hk_server_tests_started)
+    {
+        esp_err_t ret = esp_event_loop_create_default();
+        TEST_ASSERT_TRUE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE);
+        TEST_ASSERT_EQUAL(ESP_OK, esp_netif_init());
+        TEST_ASSERT_EQUAL(ESP_OK, hk_server_start());
+        hk_server_tests_started = true;
+    }
+}
+
+static int hk_server_tests_connect()
+{
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(5556),
+        .sin_addr.s_addr = inet_addr("127.0.0.1")};
+    struct timeval timeout = {.tv_sec = 5};
+
+    int client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    TEST_ASSERT_TRUE(client >= 0);
+    TEST_ASSERT_EQUAL(0, setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    TEST_ASSERT_EQUAL(0, connect(client, (struct sockaddr *)&address, sizeof(address)));
+
+    return client;
+}
+
+TEST_CASE("Write of an unverified session is rejected with 470", "[server]")
+{
+    // prepare
+    void *chr_ptr = NULL;
+    char response[256] = {0};
+    char request[256];
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_init());
+    hk_accessories_store_add_accessory();
+    hk_accessories_store_add_srv(HK_SRV_SWITCH, true, false);
+    hk_accessories_store_add_chr(HK_CHR_ON, NULL, hk_server_tests_write, false, &chr_ptr);
+    hk_accessories_store_end_config();
+    hk_server_tests_start();
+    size_t rejected_count = hk_server_transport_get_rejected_count();
+    hk_server_tests_written = false;
+    int client = hk_server_tests_connect();
+    int request_size = snprintf(request, sizeof(request),
+                                "PUT /characteristics HTTP/1.1\r\nContent-Type: application/hap+json\r\nContent-Length: %d\r\n\r\n%s",
+                                strlen(HK_SERVER_TESTS_PUT_CONTENT), HK_SERVER_TESTS_PUT_CONTENT);
+
+    // run
+    TEST_ASSERT_EQUAL(request_size, send(client, request, request_size, 0));
+    // the status line and the content may arrive in separate segments
+    int response_size = 0;
+    int received = 0;
+    while (strstr(response, "}") == NULL &&
+           (received = recv(client, response + response_size, sizeof(response) - 1 - response_size, 0)) > 0)
+    {
+        response_size += received;
+    }
+
+    // assert
+    TEST_ASSERT_TRUE(response_size > 0);
+    TEST_ASSERT_EQUAL_MEMORY("HTTP/1.1 470", response, strlen("HTTP/1.1 470"));
+    TEST_ASSERT_NOT_NULL(strstr(response, "{\"status\":-70401}"));
+    TEST_ASSERT_EQUAL_INT(rejected_count + 1, hk_server_transport_get_rejected_count());
+    TEST_ASSERT_FALSE(hk_server_tests_written);
+
+    // clean
+    close(client);
+    hk_accessories_free();
+    hk_store_free();
+}
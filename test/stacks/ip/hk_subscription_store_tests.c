@@ -178,6 +178,39 @@ TEST_CASE("remove subscription where list does not exist.", "[subscriptions]")
     free(chr3);
 }
 
+TEST_CASE("remove all subscriptions of a characteristic.", "[subscriptions]")
+{
+    // setup
+    hk_chr_t *chr1 = malloc(sizeof(hk_chr_t));
+    hk_chr_t *chr2 = malloc(sizeof(hk_chr_t));
+    esp_err_t ret = ESP_OK;
+    RUN_AND_CHECK(ret, hk_subscription_store_add, chr1, 124);
+    RUN_AND_CHECK(ret, hk_subscription_store_add, chr1, 125);
+    RUN_AND_CHECK(ret, hk_subscription_store_add, chr2, 124);
+
+    // execute
+    ret = hk_subscription_store_remove_chr(chr1);
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(ESP_OK, ret);
+    int *sockets = NULL;
+    size_t number_of_sockets = -1;
+    ret = hk_subscription_store_get(chr1, &sockets, &number_of_sockets);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, ret);
+    TEST_ASSERT_EQUAL_INT(0, number_of_sockets);
+    ret = hk_subscription_store_get(chr2, &sockets, &number_of_sockets);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, ret);
+    TEST_ASSERT_EQUAL_INT(1, number_of_sockets);
+    TEST_ASSERT_EQUAL_INT(124, sockets[0]);
+    ret = hk_subscription_store_remove_chr(chr1);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, ret);
+
+    // clean up
+    hk_subscription_store_free();
+    free(chr1);
+    free(chr2);
+}
+
 TEST_CASE("remove subscription where socket is not in list.", "[subscriptions]")
 {
     // setup
@@ -0,0 +1,54 @@
+#include <unity.h>
+#include <string.h>
+
+#include "../../src/utils/hk_alloc.h"
+
+static size_t hk_alloc_tests_used(hk_alloc_subsystem_t subsystem)
+{
+    hk_alloc_usage_t usage = hk_alloc_get_usage(subsystem);
+    return usage.internal + usage.spiram;
+}
+
+TEST_CASE("usage is counted per subsystem", "[alloc]")
+{
+    // prepare
+    size_t pairing_used = hk_alloc_tests_used(HK_ALLOC_PAIRING);
+    size_t ble_used = hk_alloc_tests_used(HK_ALLOC_BLE);
+
+    // run
+    char *buffer = (char *)hk_alloc_malloc(HK_ALLOC_PAIRING, 1024);
+
+    // assert
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL_INT(pairing_used + 1024, hk_alloc_tests_used(HK_ALLOC_PAIRING));
+    TEST_ASSERT_EQUAL_INT(ble_used, hk_alloc_tests_used(HK_ALLOC_BLE));
+
+    // run
+    hk_alloc_free(HK_ALLOC_PAIRING, buffer);
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(pairing_used, hk_alloc_tests_used(HK_ALLOC_PAIRING));
+}
+
+TEST_CASE("reallocation keeps content and usage", "[alloc]")
+{
+    // prepare
+    size_t used = hk_alloc_tests_used(HK_ALLOC_PAIRING);
+    char *buffer = (char *)hk_alloc_malloc(HK_ALLOC_PAIRING, 16);
+    memcpy(buffer, "0123456789abcdef", 16);
+
+    // run
+    buffer = (char *)hk_alloc_realloc(HK_ALLOC_PAIRING, buffer, 4096);
+
+    // assert
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL_MEMORY("0123456789abcdef", buffer, 16);
+    TEST_ASSERT_EQUAL_INT(used + 4096, hk_alloc_tests_used(HK_ALLOC_PAIRING));
+
+    // run
+    buffer = (char *)hk_alloc_realloc(HK_ALLOC_PAIRING, buffer, 0);
+
+    // assert
+    TEST_ASSERT_NULL(buffer);
+    TEST_ASSERT_EQUAL_INT(used, hk_alloc_tests_used(HK_ALLOC_PAIRING));
+}
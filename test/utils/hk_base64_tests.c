@@ -0,0 +1,47 @@
+#include <string.h>
+#include <unity.h>
+
+#include "../../src/utils/hk_base64.h"
+#include "../../src/include/hk_mem.h"
+
+TEST_CASE("encode with padding", "[base64]")
+{
+    char out[9];
+
+    TEST_ASSERT_EQUAL_INT(4, hk_base64_encode("a", 1, out));
+    TEST_ASSERT_EQUAL_STRING("YQ==", out);
+    TEST_ASSERT_EQUAL_INT(4, hk_base64_encode("ab", 2, out));
+    TEST_ASSERT_EQUAL_STRING("YWI=", out);
+    TEST_ASSERT_EQUAL_INT(4, hk_base64_encode("abc", 3, out));
+    TEST_ASSERT_EQUAL_STRING("YWJj", out);
+    TEST_ASSERT_EQUAL_INT(8, hk_base64_encoded_size(4));
+}
+
+TEST_CASE("encode->decode", "[base64]")
+{
+    // prepare
+    const char tlv[] = {0x01, 0x03, 0x61, 0x62, 0x63, 0x00, 0xff, 0x02};
+    char encoded[13];
+    hk_mem *decoded = hk_mem_init();
+
+    // run
+    size_t encoded_size = hk_base64_encode(tlv, sizeof(tlv), encoded);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_base64_decode(encoded, encoded_size, decoded));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(sizeof(tlv), decoded->size);
+    TEST_ASSERT_EQUAL_MEMORY(tlv, decoded->ptr, sizeof(tlv));
+
+    // clean
+    hk_mem_free(decoded);
+}
+
+TEST_CASE("decode invalid", "[base64]")
+{
+    hk_mem *decoded = hk_mem_init();
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_base64_decode("YQ=a", 4, decoded));
+    TEST_ASSERT_EQUAL_INT(0, decoded->size);
+
+    hk_mem_free(decoded);
+}
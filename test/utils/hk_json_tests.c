@@ -0,0 +1,85 @@
+#include <string.h>
+#include <unity.h>
+
+#include "../../src/utils/hk_json.h"
+
+TEST_CASE("read characteristics", "[json]")
+{
+    // prepare
+    const char *json = "{\"characteristics\":[{\"aid\":1,\"iid\":10,\"value\":-1.5e2,\"r\":true}]}";
+    const hk_json_token_type_t expected[] = {
+        HK_JSON_OBJECT_START, HK_JSON_KEY, HK_JSON_ARRAY_START, HK_JSON_OBJECT_START,
+        HK_JSON_KEY, HK_JSON_NUMBER, HK_JSON_KEY, HK_JSON_NUMBER, HK_JSON_KEY, HK_JSON_NUMBER,
+        HK_JSON_KEY, HK_JSON_TRUE, HK_JSON_OBJECT_END, HK_JSON_ARRAY_END, HK_JSON_OBJECT_END, HK_JSON_END};
+    hk_json_reader_t reader;
+    hk_json_token_t tokens[sizeof(expected) / sizeof(expected[0])];
+
+    // run
+    hk_json_reader_init(&reader, json, strlen(json));
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_next(&reader, &tokens[i]));
+    }
+
+    // assert
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(expected[i], tokens[i].type);
+    }
+
+    TEST_ASSERT_TRUE(hk_json_token_equal_str(&tokens[1], "characteristics"));
+    TEST_ASSERT_TRUE(hk_json_token_equal_str(&tokens[9], "-1.5e2"));
+}
+
+TEST_CASE("skip nested value", "[json]")
+{
+    // prepare
+    const char *json = "{\"a\":{\"b\":[1,{\"c\":null}]},\"d\":false}";
+    hk_json_reader_t reader;
+    hk_json_token_t token;
+
+    // run
+    hk_json_reader_init(&reader, json, strlen(json));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_next(&reader, &token));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_next(&reader, &token));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_next(&reader, &token));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_skip(&reader, &token));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_reader_next(&reader, &token));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(HK_JSON_KEY, token.type);
+    TEST_ASSERT_TRUE(hk_json_token_equal_str(&token, "d"));
+}
+
+TEST_CASE("unescape in place", "[json]")
+{
+    // prepare
+    char string[] = "a\\\"b\\/c\\u00e4\\ud83d\\ude00";
+    size_t length = 0;
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_json_unescape(string, strlen(string), &length));
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(11, length);
+    TEST_ASSERT_EQUAL_MEMORY("a\"b/c\xc3\xa4\xf0\x9f\x98\x80", string, length);
+}
+
+TEST_CASE("read invalid json", "[json]")
+{
+    const char *invalid[] = {"{\"a\":}", "{\"a\" 1}", "[1,]", "{\"a\":tru}", "\"abc", "{} {}", "[01]"};
+    hk_json_reader_t reader;
+    hk_json_token_t token;
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        esp_err_t ret = ESP_OK;
+        hk_json_reader_init(&reader, invalid[i], strlen(invalid[i]));
+        do
+        {
+            ret = hk_json_reader_next(&reader, &token);
+        } while (ret == ESP_OK && token.type != HK_JSON_END);
+
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ret);
+    }
+}
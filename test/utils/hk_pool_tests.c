@@ -0,0 +1,53 @@
+#include <unity.h>
+
+#include "../../src/utils/hk_pool.h"
+
+TEST_CASE("given buffer is reused", "[pool]")
+{
+    // prepare
+    hk_pool_t pool;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pool_init(&pool, HK_ALLOC_DEFAULT, 64, 2));
+
+    // run
+    char *block1 = hk_pool_take(&pool);
+    hk_pool_give(&pool, block1);
+    char *block2 = hk_pool_take(&pool);
+
+    // assert
+    TEST_ASSERT_NOT_NULL(block1);
+    TEST_ASSERT_EQUAL_PTR(block1, block2);
+    TEST_ASSERT_EQUAL_INT(1, hk_pool_get_taken_count(&pool));
+
+    // clean
+    hk_pool_give(&pool, block2);
+    hk_pool_free(&pool);
+}
+
+TEST_CASE("buffers beyond capacity are freed", "[pool]")
+{
+    // prepare
+    hk_pool_t pool;
+    char *blocks[3];
+    TEST_ASSERT_EQUAL(ESP_OK, hk_pool_init(&pool, HK_ALLOC_DEFAULT, 64, 1));
+
+    // run
+    for (int i = 0; i < 3; i++)
+    {
+        blocks[i] = hk_pool_take(&pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+
+    TEST_ASSERT_EQUAL_INT(3, hk_pool_get_taken_count(&pool));
+
+    for (int i = 0; i < 3; i++)
+    {
+        hk_pool_give(&pool, blocks[i]);
+    }
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(0, hk_pool_get_taken_count(&pool));
+    TEST_ASSERT_EQUAL_INT(1, pool.count);
+
+    // clean
+    hk_pool_free(&pool);
+}
@@ -0,0 +1,56 @@
+#include <unity.h>
+
+#include "../../src/utils/hk_queue.h"
+
+TEST_CASE("push and pop in order", "[queue]")
+{
+    // prepare
+    hk_queue_t queue;
+    int item = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_queue_init(&queue, sizeof(int), 4));
+
+    // run
+    for (int i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(hk_queue_push(&queue, &i));
+        TEST_ASSERT_TRUE(hk_queue_pop(&queue, &item));
+
+        // assert
+        TEST_ASSERT_EQUAL_INT(i, item);
+    }
+
+    TEST_ASSERT_FALSE(hk_queue_pop(&queue, &item));
+
+    // clean
+    hk_queue_free(&queue);
+}
+
+TEST_CASE("push to full queue", "[queue]")
+{
+    // prepare
+    hk_queue_t queue;
+    int item = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, hk_queue_init(&queue, sizeof(int), 2));
+
+    // run
+    for (int i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_TRUE(hk_queue_push(&queue, &i));
+    }
+
+    // assert
+    TEST_ASSERT_FALSE(hk_queue_push(&queue, &item));
+    TEST_ASSERT_TRUE(hk_queue_pop(&queue, &item));
+    TEST_ASSERT_EQUAL_INT(0, item);
+    TEST_ASSERT_TRUE(hk_queue_push(&queue, &item));
+
+    // clean
+    hk_queue_free(&queue);
+}
+
+TEST_CASE("init with invalid capacity", "[queue]")
+{
+    hk_queue_t queue;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_queue_init(&queue, sizeof(int), 3));
+}
@@ -0,0 +1,46 @@
+#include <unity.h>
+
+#include "../../src/utils/hk_rcu.h"
+
+TEST_CASE("read published version", "[rcu]")
+{
+    // prepare
+    hk_rcu_t rcu;
+    int first = 1;
+    int second = 2;
+    uint8_t reader = 0;
+    hk_rcu_init(&rcu, &first);
+
+    // run
+    int *version = (int *)hk_rcu_read_lock(&rcu, &reader);
+    TEST_ASSERT_EQUAL_INT(1, *version);
+    hk_rcu_read_unlock(&rcu, reader);
+    int *old_version = (int *)hk_rcu_publish(&rcu, &second);
+    version = (int *)hk_rcu_read_lock(&rcu, &reader);
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(2, *version);
+    TEST_ASSERT_EQUAL_INT(1, *old_version);
+
+    // clean
+    hk_rcu_read_unlock(&rcu, reader);
+}
+
+TEST_CASE("publish while reading other version", "[rcu]")
+{
+    // prepare
+    hk_rcu_t rcu;
+    int versions[3] = {1, 2, 3};
+    uint8_t reader = 0;
+    hk_rcu_init(&rcu, &versions[0]);
+    hk_rcu_publish(&rcu, &versions[1]);
+
+    // run
+    int *version = (int *)hk_rcu_read_lock(&rcu, &reader);
+    hk_rcu_read_unlock(&rcu, reader);
+    int *old_version = (int *)hk_rcu_publish(&rcu, &versions[2]);
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(2, *version);
+    TEST_ASSERT_EQUAL_INT(2, *old_version);
+}
@@ -0,0 +1,115 @@
+#include <unity.h>
+#include <string.h>
+
+#include "../../src/utils/hk_recorder.h"
+
+static hk_recorder_header_t *hk_recorder_tests_get(hk_mem *trace, size_t index)
+{
+    size_t position = 0;
+    for (size_t i = 0; i < index; i++)
+    {
+        position += sizeof(hk_recorder_header_t) + ((hk_recorder_header_t *)(trace->ptr + position))->length;
+    }
+
+    return (hk_recorder_header_t *)(trace->ptr + position);
+}
+
+TEST_CASE("records in order", "[recorder]")
+{
+    // prepare
+    hk_mem *trace = hk_mem_init();
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_init(1024));
+
+    // test
+    hk_recorder_record(HK_RECORDER_IP_REQUEST, 54, "GET /accessories", 16);
+    hk_recorder_record(HK_RECORDER_IP_RESPONSE, 54, "HTTP/1.1 200 OK", 15);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_export(trace));
+
+    // assert
+    TEST_ASSERT_EQUAL(2 * sizeof(hk_recorder_header_t) + 16 + 15, trace->size);
+    hk_recorder_header_t *request = hk_recorder_tests_get(trace, 0);
+    TEST_ASSERT_EQUAL(HK_RECORDER_IP_REQUEST, request->kind);
+    TEST_ASSERT_EQUAL(54, request->connection);
+    TEST_ASSERT_EQUAL(16, request->length);
+    TEST_ASSERT_EQUAL_MEMORY("GET /accessories", (char *)request + sizeof(hk_recorder_header_t), 16);
+    hk_recorder_header_t *response = hk_recorder_tests_get(trace, 1);
+    TEST_ASSERT_EQUAL(HK_RECORDER_IP_RESPONSE, response->kind);
+    TEST_ASSERT_TRUE(response->time >= request->time);
+    TEST_ASSERT_EQUAL_MEMORY("HTTP/1.1 200 OK", (char *)response + sizeof(hk_recorder_header_t), 15);
+
+    // cleanup
+    hk_mem_free(trace);
+    hk_recorder_free();
+}
+
+TEST_CASE("drops oldest records if full", "[recorder]")
+{
+    // prepare
+    char data[20];
+    hk_mem *trace = hk_mem_init();
+    size_t record_size = sizeof(hk_recorder_header_t) + sizeof(data);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_init(record_size * 3 + 5));
+
+    // test
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        memset(data, i, sizeof(data));
+        hk_recorder_record(HK_RECORDER_BLE_REQUEST, 1, data, sizeof(data));
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_export(trace));
+
+    // assert
+    TEST_ASSERT_EQUAL(7, hk_recorder_get_dropped_count());
+    TEST_ASSERT_EQUAL(record_size * 3, trace->size);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        hk_recorder_header_t *header = hk_recorder_tests_get(trace, i);
+        TEST_ASSERT_EQUAL(sizeof(data), header->length);
+        TEST_ASSERT_EQUAL(7 + i, ((char *)header)[sizeof(hk_recorder_header_t)]);
+        TEST_ASSERT_EQUAL(7 + i, ((char *)header)[record_size - 1]);
+    }
+
+    // cleanup
+    hk_mem_free(trace);
+    hk_recorder_free();
+}
+
+TEST_CASE("truncates records larger than the buffer", "[recorder]")
+{
+    // prepare
+    char data[100] = {0};
+    hk_mem *trace = hk_mem_init();
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_init(sizeof(hk_recorder_header_t) + 50));
+
+    // test
+    hk_recorder_record(HK_RECORDER_BLE_RESPONSE, 1, data, sizeof(data));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_export(trace));
+
+    // assert
+    TEST_ASSERT_EQUAL(sizeof(hk_recorder_header_t) + 50, trace->size);
+    TEST_ASSERT_EQUAL(50, hk_recorder_tests_get(trace, 0)->length);
+
+    // cleanup
+    hk_mem_free(trace);
+    hk_recorder_free();
+}
+
+TEST_CASE("keeps records if initialized again", "[recorder]")
+{
+    // prepare
+    hk_mem *trace = hk_mem_init();
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_init(1024));
+    hk_recorder_record(HK_RECORDER_IP_REQUEST, 54, "GET /accessories", 16);
+
+    // test
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_init(1024));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_recorder_export(trace));
+
+    // assert
+    TEST_ASSERT_EQUAL(sizeof(hk_recorder_header_t) + 16, trace->size);
+
+    // cleanup
+    hk_mem_free(trace);
+    hk_recorder_free();
+}
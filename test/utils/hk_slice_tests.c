@@ -0,0 +1,43 @@
+#include <unity.h>
+
+#include "../../src/utils/hk_slice.h"
+
+TEST_CASE("slices compare without copies", "[slice]")
+{
+    // prepare
+    hk_mem *mem = hk_mem_init();
+    hk_mem_append_string(mem, "AB:CD:EF");
+
+    // run
+    hk_slice_t slice = hk_slice_from_mem(mem);
+
+    // assert
+    TEST_ASSERT_EQUAL_PTR(mem->ptr, slice.ptr);
+    TEST_ASSERT_TRUE(hk_slice_equal_str(slice, "AB:CD:EF"));
+    TEST_ASSERT_FALSE(hk_slice_equal_str(slice, "AB:CD:EF:"));
+    TEST_ASSERT_FALSE(hk_slice_equal_str(slice, "AB:CD"));
+    TEST_ASSERT_TRUE(hk_slice_starts_with(slice, "AB:"));
+    TEST_ASSERT_FALSE(hk_slice_starts_with(hk_slice_sub(slice, 0, 2), "AB:"));
+    TEST_ASSERT_TRUE(hk_slice_equal_str(hk_slice_sub(slice, 6, 10), "EF"));
+    TEST_ASSERT_EQUAL_INT(0, hk_slice_sub(slice, 20, 1).size);
+
+    // clean
+    hk_mem_free(mem);
+}
+
+TEST_CASE("slices parse numbers", "[slice]")
+{
+    // prepare
+    size_t value = 0;
+    const char *content_length = "Content-Length: 1234\r\n";
+
+    // run
+    hk_slice_t slice = hk_slice_sub(hk_slice_from_str(content_length), 16, 4);
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, hk_slice_to_size(slice, &value));
+    TEST_ASSERT_EQUAL_INT(1234, value);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_slice_to_size(hk_slice_sub(slice, 0, 0), &value));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_slice_to_size(hk_slice_from_str("12a"), &value));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hk_slice_to_size(hk_slice_from_str("99999999999999999999999"), &value));
+}
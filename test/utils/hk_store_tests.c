@@ -25,4 +25,93 @@ TEST_CASE("Checking reading/writing u8.", "[store]")
 
     //clean
     hk_store_free();
-}
\ No newline at end of file
+}
+
+TEST_CASE("Checking reading deferred u16 before and after flush.", "[store]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    const char *key = "deferred";
+    uint16_t result = 0;
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_set(key, 1234));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_get(key, &result));
+    TEST_ASSERT_EQUAL_INT(1234, result);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_flush());
+    result = 0;
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_get(key, &result));
+    TEST_ASSERT_EQUAL_INT(1234, result);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_erase(key));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, hk_store_u16_get(key, &result));
+
+    // clean
+    hk_store_free();
+}
+
+TEST_CASE("Checking more dirty keys than the list holds are deferred.", "[store]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    nvs_handle handle;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open("hk_store", NVS_READONLY, &handle));
+    char key[16];
+    uint16_t result = 0;
+
+    // run
+    for (uint16_t i = 0; i < HK_STORE_DIRTY_SIZE * 2 + 1; i++)
+    {
+        snprintf(key, sizeof(key), "dirty%d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_set(key, i));
+    }
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_ERR_NVS_NOT_FOUND, nvs_get_u16(handle, "dirty0", &result));
+    for (uint16_t i = 0; i < HK_STORE_DIRTY_SIZE * 2 + 1; i++)
+    {
+        snprintf(key, sizeof(key), "dirty%d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_get(key, &result));
+        TEST_ASSERT_EQUAL_INT(i, result);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_flush());
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_get_u16(handle, "dirty0", &result));
+    TEST_ASSERT_EQUAL_INT(0, result);
+
+    // clean
+    nvs_close(handle);
+    hk_store_free();
+}
+
+TEST_CASE("Checking more dirty keys than the maximum are flushed by the caller.", "[store]")
+{
+    // prepare
+    TEST_ASSERT_FALSE(nvs_flash_erase());
+    TEST_ASSERT_FALSE(hk_store_init());
+    nvs_handle handle;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open("hk_store", NVS_READONLY, &handle));
+    char key[16];
+    uint16_t result = 0;
+
+    // run
+    for (uint16_t i = 0; i < HK_STORE_DIRTY_MAX_SIZE + 1; i++)
+    {
+        snprintf(key, sizeof(key), "dirty%d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_set(key, i));
+    }
+
+    // assert
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_get_u16(handle, "dirty0", &result));
+    TEST_ASSERT_EQUAL_INT(0, result);
+    TEST_ASSERT_EQUAL(ESP_ERR_NVS_NOT_FOUND, nvs_get_u16(handle, "dirty64", &result));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_store_u16_get("dirty64", &result));
+    TEST_ASSERT_EQUAL_INT(HK_STORE_DIRTY_MAX_SIZE, result);
+
+    // clean
+    nvs_close(handle);
+    hk_store_free();
+}
@@ -0,0 +1,92 @@
+#include <unity.h>
+#include <string.h>
+
+#include "../../src/utils/hk_tasks.h"
+
+#define HK_TASKS_TESTS_STACK_SIZE 4096
+
+static volatile bool hk_tasks_tests_done = false;
+
+static void hk_tasks_tests_task(void *arg)
+{
+    // uses some of the stack, so the high water mark drops
+    volatile char buffer[1024];
+    memset((char *)buffer, 1, sizeof(buffer));
+
+    while (!hk_tasks_tests_done)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("stack usage of registered task is reported", "[tasks]")
+{
+    // prepare
+    TaskHandle_t task = NULL;
+    hk_tasks_stack_usage_t usages[HK_TASKS_MAX_COUNT];
+    hk_tasks_tests_done = false;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(hk_tasks_tests_task, "hk_tasks_test", HK_TASKS_TESTS_STACK_SIZE, NULL, 1, &task));
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_tasks_register(task, "hk_tasks_test", HK_TASKS_TESTS_STACK_SIZE));
+    size_t count = hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT);
+
+    // assert
+    hk_tasks_stack_usage_t *usage = NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strcmp(usages[i].name, "hk_tasks_test") == 0)
+        {
+            usage = &usages[i];
+        }
+    }
+
+    TEST_ASSERT_NOT_NULL(usage);
+    TEST_ASSERT_EQUAL_INT(HK_TASKS_TESTS_STACK_SIZE, usage->stack_size);
+    TEST_ASSERT_TRUE(usage->stack_high_water_mark > 0);
+    TEST_ASSERT_TRUE(usage->stack_high_water_mark < HK_TASKS_TESTS_STACK_SIZE - 1024);
+
+    // clean
+    hk_tasks_unregister(task);
+    TEST_ASSERT_EQUAL_INT(count - 1, hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT));
+    hk_tasks_tests_done = true;
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+TEST_CASE("registering a task again keeps one entry", "[tasks]")
+{
+    // prepare
+    TaskHandle_t task1 = NULL;
+    TaskHandle_t task2 = NULL;
+    hk_tasks_stack_usage_t usages[HK_TASKS_MAX_COUNT];
+    hk_tasks_tests_done = false;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(hk_tasks_tests_task, "hk_tasks_test1", HK_TASKS_TESTS_STACK_SIZE, NULL, 1, &task1));
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(hk_tasks_tests_task, "hk_tasks_test2", HK_TASKS_TESTS_STACK_SIZE, NULL, 1, &task2));
+    size_t count = hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT);
+
+    // run
+    TEST_ASSERT_EQUAL(ESP_OK, hk_tasks_register(task1, "hk_tasks_test1", HK_TASKS_TESTS_STACK_SIZE));
+    TEST_ASSERT_EQUAL(ESP_OK, hk_tasks_register(task2, "hk_tasks_test2", HK_TASKS_TESTS_STACK_SIZE));
+    hk_tasks_unregister(task1);
+    TEST_ASSERT_EQUAL(ESP_OK, hk_tasks_register(task2, "hk_tasks_test2", HK_TASKS_TESTS_STACK_SIZE * 2));
+    size_t registered_count = hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT);
+
+    // assert
+    TEST_ASSERT_EQUAL_INT(count + 1, registered_count);
+    for (size_t i = 0; i < registered_count; i++)
+    {
+        if (strcmp(usages[i].name, "hk_tasks_test2") == 0)
+        {
+            TEST_ASSERT_EQUAL_INT(HK_TASKS_TESTS_STACK_SIZE * 2, usages[i].stack_size);
+        }
+    }
+
+    // clean
+    hk_tasks_unregister(task2);
+    TEST_ASSERT_EQUAL_INT(count, hk_tasks_get_stack_usage(usages, HK_TASKS_MAX_COUNT));
+    hk_tasks_tests_done = true;
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
@@ -0,0 +1,396 @@
+#!/usr/bin/env python3
+"""Replays recorded HAP traffic against an accessory of the IP stack.
+
+The accessory records its plain traffic if 'Record plain traffic' (ESP32_HAP_RECORDER) is enabled under the 'Homekit'
+menu entry. hk_recorder_print writes the records to the monitor, whose output is the trace of this tool:
+
+    %> python3 tools/hk_replay.py summary monitor.log
+    %> python3 tools/hk_replay.py pair <ip of accessory> --code 111-22-333 --controller controller.json
+    %> python3 tools/hk_replay.py replay monitor.log <ip of accessory> --controller controller.json
+
+'summary' prints the requests of a trace, their timing and the free heap of the accessory. 'pair' pairs a new
+controller with an unpaired accessory and saves its keys. 'replay' verifies every recorded connection with these keys
+and sends the recorded requests of the IP stack, except of pairing requests, measuring latency and throughput. Print
+the records of the accessory again after a replay, to see the free heap while handling the replayed requests.
+
+Pairing and replaying require the cryptography package (pip3 install cryptography).
+"""
+
+import argparse
+import asyncio
+import base64
+import collections
+import hashlib
+import json
+import os
+import statistics
+import struct
+import time
+
+HEADER = struct.Struct("<qIHHB")
+KINDS = {1: "ip request", 2: "ip response", 3: "ip event", 4: "ble request", 5: "ble response"}
+IP_REQUEST = 1
+PAIRING_PATHS = (b"/pair-setup", b"/pair-verify", b"/pairings")
+
+SRP_N = int(
+    "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B"
+    "302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1F"
+    "E649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096"
+    "966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF695"
+    "5817183995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA7157"
+    "5D060C7DB3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B"
+    "18177B200CBBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF", 16)
+SRP_G = 5
+SRP_LENGTH = 384
+
+
+def parse_trace(path):
+    """Reads the records from the output of hk_recorder_print."""
+    records = []
+    with open(path, "rb") as trace:
+        for line in trace:
+            index = line.find(b"hk_recorder ")
+            if index < 0:
+                continue
+
+            record = base64.b64decode(line[index + len(b"hk_recorder "):].strip())
+            timestamp, free_heap, connection, length, kind = HEADER.unpack_from(record)
+            records.append({"time": timestamp, "free_heap": free_heap, "connection": connection, "kind": kind,
+                            "data": record[HEADER.size:HEADER.size + length]})
+
+    return records
+
+
+def split_requests(data):
+    """Splits the received data of a connection into complete http requests."""
+    requests = []
+    while True:
+        end = data.find(b"\r\n\r\n")
+        if end < 0:
+            return requests, data
+
+        headers = data[:end]
+        content_length = 0
+        for line in headers.split(b"\r\n")[1:]:
+            name, _, value = line.partition(b":")
+            if name.strip().lower() == b"content-length":
+                content_length = int(value)
+
+        size = end + 4 + content_length
+        if len(data) < size:
+            return requests, data
+
+        requests.append(data[:size])
+        data = data[size:]
+
+
+def get_requests(records):
+    """Returns the replayable requests of the ip stack per recorded connection, with their time."""
+    connections = collections.OrderedDict()
+    pending = {}
+    for record in records:
+        if record["kind"] != IP_REQUEST:
+            continue
+
+        connection = record["connection"]
+        requests, pending[connection] = split_requests(pending.get(connection, b"") + record["data"])
+        for request in requests:
+            connections.setdefault(connection, []).append((record["time"], request))
+
+    return connections
+
+
+def summary(args):
+    records = parse_trace(args.trace)
+    if not records:
+        print("no records")
+        return
+
+    duration = (records[-1]["time"] - records[0]["time"]) / 1000000
+    print("records:   {} in {:.1f} s".format(len(records), duration))
+    for kind, name in KINDS.items():
+        of_kind = [record for record in records if record["kind"] == kind]
+        if of_kind:
+            print("{:12} {} records, {} bytes".format(name + ":", len(of_kind), sum(len(r["data"]) for r in of_kind)))
+
+    free_heap = [record["free_heap"] for record in records]
+    print("free heap: min {}, max {}, last {}".format(min(free_heap), max(free_heap), free_heap[-1]))
+
+    paths = collections.Counter()
+    for requests in get_requests(records).values():
+        for _, request in requests:
+            paths[b" ".join(request.split(b" ", 2)[:2]).decode(errors="replace")] += 1
+
+    for path, count in paths.most_common():
+        print("{:6} {}".format(count, path[:100]))
+
+
+def tlv_encode(items):
+    encoded = b""
+    for tlv_type, value in items:
+        if not value:
+            encoded += bytes([tlv_type, 0])
+        for offset in range(0, len(value), 255):
+            chunk = value[offset:offset + 255]
+            encoded += bytes([tlv_type, len(chunk)]) + chunk
+    return encoded
+
+
+def tlv_decode(data):
+    items = {}
+    last_type = None
+    offset = 0
+    while offset + 2 <= len(data):
+        tlv_type, length = data[offset], data[offset + 1]
+        value = data[offset + 2:offset + 2 + length]
+        if tlv_type == last_type:
+            items[tlv_type] += value
+        else:
+            items[tlv_type] = value
+        last_type = tlv_type
+        offset += 2 + length
+    return items
+
+
+def sha512(*parts):
+    digest = hashlib.sha512()
+    for part in parts:
+        digest.update(part)
+    return digest.digest()
+
+
+def to_bytes(number, length=None):
+    return number.to_bytes(length or max(1, (number.bit_length() + 7) // 8), "big")
+
+
+def hkdf(key, salt, info):
+    from cryptography.hazmat.primitives import hashes
+    from cryptography.hazmat.primitives.kdf.hkdf import HKDF
+    return HKDF(algorithm=hashes.SHA512(), length=32, salt=salt, info=info).derive(key)
+
+
+def chacha(key):
+    from cryptography.hazmat.primitives.ciphers.aead import ChaCha20Poly1305
+    return ChaCha20Poly1305(key)
+
+
+class Connection:
+    """A http connection to the accessory, which is encrypted after pair verify."""
+
+    def __init__(self, reader, writer):
+        self.reader = reader
+        self.writer = writer
+        self.write_key = None
+        self.read_key = None
+        self.write_count = 0
+        self.read_count = 0
+        self.received = b""
+        self.events = 0
+
+    async def request(self, message):
+        if self.write_key is None:
+            self.writer.write(message)
+        else:
+            for offset in range(0, len(message), 1024):
+                chunk = message[offset:offset + 1024]
+                aad = struct.pack("<H", len(chunk))
+                nonce = b"\x00" * 4 + struct.pack("<Q", self.write_count)
+                self.write_count += 1
+                self.writer.write(aad + self.write_key.encrypt(nonce, chunk, aad))
+        await self.writer.drain()
+
+        while True:
+            response = await self.read_message()
+            if response.startswith(b"EVENT/1.0"):
+                self.events += 1
+                continue
+            return response
+
+    async def read_message(self):
+        while True:
+            messages, self.received = split_requests(self.received)
+            if messages:
+                self.received = b"".join(messages[1:]) + self.received
+                return messages[0]
+            self.received += await self.read_plain()
+
+    async def read_plain(self):
+        if self.read_key is None:
+            data = await self.reader.read(4096)
+            if not data:
+                raise ConnectionError("connection closed")
+            return data
+
+        aad = await self.reader.readexactly(2)
+        length = struct.unpack("<H", aad)[0]
+        encrypted = await self.reader.readexactly(length + 16)
+        nonce = b"\x00" * 4 + struct.pack("<Q", self.read_count)
+        self.read_count += 1
+        return self.read_key.decrypt(nonce, encrypted, aad)
+
+    async def post_tlv(self, path, items):
+        content = tlv_encode(items)
+        response = await self.request(b"POST " + path + b" HTTP/1.1\r\nContent-Type: application/pairing+tlv8\r\n"
+                                      b"Content-Length: " + str(len(content)).encode() + b"\r\n\r\n" + content)
+        result = tlv_decode(response[response.find(b"\r\n\r\n") + 4:])
+        if 7 in result:
+            raise RuntimeError("{} failed with error {}".format(path.decode(), result[7][0]))
+        return result
+
+    async def verify(self, controller):
+        from cryptography.hazmat.primitives.asymmetric import ed25519, x25519
+        from cryptography.hazmat.primitives import serialization
+        raw = serialization.Encoding.Raw, serialization.PublicFormat.Raw
+
+        key = x25519.X25519PrivateKey.generate()
+        public_key = key.public_key().public_bytes(*raw)
+        m2 = await self.post_tlv(b"/pair-verify", [(6, b"\x01"), (3, public_key)])
+
+        accessory_public_key = m2[3]
+        shared_secret = key.exchange(x25519.X25519PublicKey.from_public_bytes(accessory_public_key))
+        session_key = hkdf(shared_secret, b"Pair-Verify-Encrypt-Salt", b"Pair-Verify-Encrypt-Info")
+        chacha(session_key).decrypt(b"\x00" * 4 + b"PV-Msg02", m2[5], None)
+
+        signing_key = ed25519.Ed25519PrivateKey.from_private_bytes(bytes.fromhex(controller["ltsk"]))
+        pairing_id = controller["id"].encode()
+        signature = signing_key.sign(public_key + pairing_id + accessory_public_key)
+        encrypted = chacha(session_key).encrypt(b"\x00" * 4 + b"PV-Msg03", tlv_encode([(1, pairing_id), (10, signature)]), None)
+        await self.post_tlv(b"/pair-verify", [(6, b"\x03"), (5, encrypted)])
+
+        self.write_key = chacha(hkdf(shared_secret, b"Control-Salt", b"Control-Write-Encryption-Key"))
+        self.read_key = chacha(hkdf(shared_secret, b"Control-Salt", b"Control-Read-Encryption-Key"))
+
+
+async def pair_async(args):
+    from cryptography.hazmat.primitives.asymmetric import ed25519
+    from cryptography.hazmat.primitives import serialization
+    connection = Connection(*await asyncio.open_connection(args.host, args.port))
+
+    m2 = await connection.post_tlv(b"/pair-setup", [(6, b"\x01"), (0, b"\x00")])
+    salt, server_public_key = m2[2], int.from_bytes(m2[3], "big")
+
+    # srp 6a with the 3072 bit group and sha512, refer to spec 5.6
+    a = int.from_bytes(os.urandom(32), "big")
+    client_public_key = to_bytes(pow(SRP_G, a, SRP_N), SRP_LENGTH)
+    k = int.from_bytes(sha512(to_bytes(SRP_N), to_bytes(SRP_G, SRP_LENGTH)), "big")
+    u = int.from_bytes(sha512(client_public_key, to_bytes(server_public_key, SRP_LENGTH)), "big")
+    x = int.from_bytes(sha512(salt, sha512(b"Pair-Setup:" + args.code.encode())), "big")
+    secret = pow(server_public_key - k * pow(SRP_G, x, SRP_N), a + u * x, SRP_N)
+    session_key = sha512(to_bytes(secret))
+    hash_n_xor_g = bytes(n ^ g for n, g in zip(sha512(to_bytes(SRP_N)), sha512(to_bytes(SRP_G))))
+    proof = sha512(hash_n_xor_g, sha512(b"Pair-Setup"), salt, client_public_key, m2[3], session_key)
+
+    m4 = await connection.post_tlv(b"/pair-setup", [(6, b"\x03"), (3, client_public_key), (4, proof)])
+    if m4[4] != sha512(client_public_key, proof, session_key):
+        raise RuntimeError("accessory proof is invalid")
+
+    signing_key = ed25519.Ed25519PrivateKey.generate()
+    ltpk = signing_key.public_key().public_bytes(serialization.Encoding.Raw, serialization.PublicFormat.Raw)
+    pairing_id = args.id.encode()
+    device_x = hkdf(session_key, b"Pair-Setup-Controller-Sign-Salt", b"Pair-Setup-Controller-Sign-Info")
+    signature = signing_key.sign(device_x + pairing_id + ltpk)
+    encrypt_key = chacha(hkdf(session_key, b"Pair-Setup-Encrypt-Salt", b"Pair-Setup-Encrypt-Info"))
+    encrypted = encrypt_key.encrypt(b"\x00" * 4 + b"PS-Msg05", tlv_encode([(1, pairing_id), (3, ltpk), (10, signature)]), None)
+    await connection.post_tlv(b"/pair-setup", [(6, b"\x05"), (5, encrypted)])
+    connection.writer.close()
+
+    ltsk = signing_key.private_bytes(serialization.Encoding.Raw, serialization.PrivateFormat.Raw, serialization.NoEncryption())
+    with open(args.controller, "w") as controller:
+        json.dump({"id": args.id, "ltsk": ltsk.hex()}, controller)
+    print("paired, keys saved to {}".format(args.controller))
+
+
+async def replay_connection(args, controller, requests, started, latencies, errors):
+    if args.realtime:
+        await asyncio.sleep(max(0, (requests[0][0] - started) / 1000000))
+
+    try:
+        connection = Connection(*await asyncio.open_connection(args.host, args.port))
+        await connection.verify(controller)
+    except (OSError, RuntimeError, asyncio.IncompleteReadError, ConnectionError) as error:
+        errors.append(str(error))
+        return 0
+
+    try:
+        replay_started = time.monotonic()
+        for recorded_at, request in requests:
+            if args.realtime:
+                delay = (recorded_at - requests[0][0]) / 1000000 - (time.monotonic() - replay_started)
+                await asyncio.sleep(max(0, delay))
+
+            path = b" ".join(request.split(b" ", 2)[:2]).split(b"?")[0].decode(errors="replace")
+            request_started = time.monotonic()
+            await connection.request(request)
+            latencies[path].append(time.monotonic() - request_started)
+    except (OSError, asyncio.IncompleteReadError, ConnectionError) as error:
+        errors.append(str(error))
+    finally:
+        connection.writer.close()
+
+    return connection.events
+
+
+async def replay_async(args):
+    with open(args.controller) as controller_file:
+        controller = json.load(controller_file)
+
+    connections = get_requests(parse_trace(args.trace))
+    for connection in connections:
+        connections[connection] = [(t, r) for t, r in connections[connection] if not r.split(b" ")[1].startswith(PAIRING_PATHS)]
+    connections = [requests for requests in connections.values() if requests]
+    if not connections:
+        print("no requests of the ip stack to replay")
+        return
+
+    started = min(requests[0][0] for requests in connections)
+    latencies = collections.defaultdict(list)
+    errors = []
+    replay_started = time.monotonic()
+    events = await asyncio.gather(*[replay_connection(args, controller, requests, started, latencies, errors)
+                                    for requests in connections])
+    duration = time.monotonic() - replay_started
+
+    count = sum(len(values) for values in latencies.values())
+    print("connections: {}".format(len(connections)))
+    print("requests:    {} in {:.1f} s, {:.1f} requests/s".format(count, duration, count / duration))
+    print("events:      {}".format(sum(events)))
+    print("errors:      {}".format(len(errors)))
+    for path, values in sorted(latencies.items()):
+        values.sort()
+        print("{:40} {:6} requests, p50 {:.1f} ms, p99 {:.1f} ms, max {:.1f} ms".format(
+            path[:40], len(values), statistics.median(values) * 1000, values[int(len(values) * 0.99)] * 1000,
+            values[-1] * 1000))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    summary_parser = commands.add_parser("summary")
+    summary_parser.add_argument("trace")
+
+    pair_parser = commands.add_parser("pair")
+    pair_parser.add_argument("host")
+    pair_parser.add_argument("--port", type=int, default=5556)
+    pair_parser.add_argument("--code", required=True)
+    pair_parser.add_argument("--id", default="11111111-2222-3333-4444-555555555555")
+    pair_parser.add_argument("--controller", default="controller.json")
+
+    replay_parser = commands.add_parser("replay")
+    replay_parser.add_argument("trace")
+    replay_parser.add_argument("host")
+    replay_parser.add_argument("--port", type=int, default=5556)
+    replay_parser.add_argument("--controller", default="controller.json")
+    replay_parser.add_argument("--realtime", action="store_true", help="keep the recorded time between requests")
+
+    args = parser.parse_args()
+    if args.command == "summary":
+        summary(args)
+    elif args.command == "pair":
+        asyncio.run(pair_async(args))
+    else:
+        asyncio.run(replay_async(args))
+
+
+if __name__ == "__main__":
+    main()
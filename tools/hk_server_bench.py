@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Load generator for the HAP server of the IP stack.
+
+Opens concurrent keep-alive connections to the accessory and sends requests as fast as the accessory answers.
+Unverified connections are answered by the router without touching the attribute database, so the benchmark
+measures accepting, parsing, routing and responding of the server itself. Run it once with esp_http_server and
+once with the built-in HAP server (ESP32_HAP_IP_HAP_SERVER) and compare the results.
+
+    %> python3 tools/hk_server_bench.py <ip of accessory> --connections 8 --seconds 20
+"""
+
+import argparse
+import asyncio
+import statistics
+import time
+
+
+async def run_connection(host, port, request, deadline, latencies, errors):
+    try:
+        reader, writer = await asyncio.open_connection(host, port)
+    except OSError:
+        errors.append("connect")
+        return
+
+    try:
+        while time.monotonic() < deadline:
+            started = time.monotonic()
+            writer.write(request)
+            await writer.drain()
+
+            headers = await reader.readuntil(b"\r\n\r\n")
+            content_length = 0
+            for line in headers.split(b"\r\n"):
+                if line.lower().startswith(b"content-length:"):
+                    content_length = int(line.split(b":")[1])
+            await reader.readexactly(content_length)
+
+            latencies.append(time.monotonic() - started)
+    except (OSError, asyncio.IncompleteReadError, asyncio.LimitOverrunError):
+        errors.append("connection")
+    finally:
+        writer.close()
+
+
+async def run(args):
+    request = "{} {} HTTP/1.1\r\nHost: {}\r\nContent-Length: 0\r\n\r\n".format(args.method, args.path, args.host).encode()
+    deadline = time.monotonic() + args.seconds
+    latencies = []
+    errors = []
+
+    await asyncio.gather(*[run_connection(args.host, args.port, request, deadline, latencies, errors)
+                           for _ in range(args.connections)])
+
+    if not latencies:
+        print("no responses, {} errors".format(len(errors)))
+        return
+
+    latencies.sort()
+    print("requests:   {}".format(len(latencies)))
+    print("errors:     {}".format(len(errors)))
+    print("throughput: {:.1f} requests/s".format(len(latencies) / args.seconds))
+    print("latency:    p50 {:.1f} ms, p99 {:.1f} ms, max {:.1f} ms".format(
+        statistics.median(latencies) * 1000,
+        latencies[int(len(latencies) * 0.99)] * 1000,
+        latencies[-1] * 1000))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=5556)
+    parser.add_argument("--connections", type=int, default=8)
+    parser.add_argument("--seconds", type=float, default=10)
+    parser.add_argument("--method", default="GET")
+    parser.add_argument("--path", default="/accessories")
+    asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    main()